@@ -38,7 +38,8 @@ DEFINE_LOG_CATEGORY(AzureKinectAnimNodeLog);
 /*
  * FAnimNode_AzureKinectPose::FAnimNode_AzureKinectPose
  */
-FAnimNode_AzureKinectPose::FAnimNode_AzureKinectPose(void) {
+FAnimNode_AzureKinectPose::FAnimNode_AzureKinectPose(void)
+        : SkipUntrackedJoints(false) {
     this->BonesToModify.Reserve(K4ABT_JOINT_COUNT);
     for (int i = 0; i < K4ABT_JOINT_COUNT; i++) {
         this->BonesToModify.Add(
@@ -90,9 +91,21 @@ void FAnimNode_AzureKinectPose::Update_AnyThread(
 
     this->_boneTransforms.Reset(K4ABT_JOINT_COUNT);
 
+    const auto& confidences = this->Skeleton.Confidences;
+
     for (int i = 0; i < this->Skeleton.Joints.Num(); ++i) {
         auto joint = static_cast<EKinectBodyJoint>(i);
 
+        // If requested, joints that are out of range or skipped by the
+        // device leave their bones in the input pose. Skeletons built in
+        // Blueprints might not have any confidences, in which case all
+        // joints are used.
+        if (this->SkipUntrackedJoints
+                && confidences.IsValidIndex(i)
+                && (confidences[i] == EKinectJointConfidence::NONE)) {
+            continue;
+        }
+
         if (this->BonesToModify.Contains(joint)) {
             auto bone = mesh->GetBoneIndex(this->BonesToModify[joint].BoneName);
             if (bone != INDEX_NONE) {
@@ -0,0 +1,1027 @@
+﻿// <copyright file="AzureKinectBenchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+// This file provides console commands for measuring the performance of the
+// processing kernels on synthetic data, i.e. without a device being attached.
+
+#include "CoreMinimal.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Math/RandomStream.h"
+#include "Modules/ModuleManager.h"
+
+#include "AzureKinectColourDecoder.h"
+#include "AzureKinectConversion.h"
+#include "AzureKinectDecimation.h"
+#include "AzureKinectDepthFilter.h"
+#include "AzureKinectRegistration.h"
+#include "AzureKinectSkeletonFilter.h"
+#include "AzureKinectWorkerPool.h"
+
+
+DEFINE_LOG_CATEGORY_STATIC(AzureKinectBenchmarkLog, Log, All);
+
+
+namespace {
+
+    /// <summary>
+    /// Describes the image size of a depth mode.
+    /// </summary>
+    struct FDepthModeSize {
+        const TCHAR *Name;
+        int32 Width;
+        int32 Height;
+    };
+
+    /// <summary>
+    /// The sizes of the depth and infrared images in all depth modes.
+    /// </summary>
+    const FDepthModeSize DepthModeSizes[] = {
+        { TEXT("NFOV 2x2 binned"), 320, 288 },
+        { TEXT("NFOV unbinned"), 640, 576 },
+        { TEXT("WFOV 2x2 binned"), 512, 512 },
+        { TEXT("WFOV unbinned"), 1024, 1024 },
+    };
+
+    /// <summary>
+    /// The depth modes in the order of <see cref="DepthModeSizes" />.
+    /// </summary>
+    const k4a_depth_mode_t DepthModes[] = {
+        K4A_DEPTH_MODE_NFOV_2X2BINNED,
+        K4A_DEPTH_MODE_NFOV_UNBINNED,
+        K4A_DEPTH_MODE_WFOV_2X2BINNED,
+        K4A_DEPTH_MODE_WFOV_UNBINNED,
+    };
+
+    /// <summary>
+    /// The size of the colour images in the only mode supporting NV12 and
+    /// YUY2.
+    /// </summary>
+    constexpr int32 ColourWidth = 1280;
+    constexpr int32 ColourHeight = 720;
+
+    /// <summary>
+    /// Parses the optional iteration count from the command arguments.
+    /// </summary>
+    int32 GetIterations(const TArray<FString>& args) {
+        const auto retval = (args.Num() > 0) ? FCString::Atoi(*args[0]) : 0;
+        return (retval > 0) ? retval : 100;
+    }
+
+    /// <summary>
+    /// Parses the optional number of rows per tile from the second command
+    /// argument.
+    /// </summary>
+    int32 GetTileRows(const TArray<FString>& args) {
+        const auto retval = (args.Num() > 1) ? FCString::Atoi(*args[1]) : 0;
+        return (retval > 0) ? retval : 64;
+    }
+
+    /// <summary>
+    /// Creates a synthetic depth image, which contains a share of invalid
+    /// pixels like a real one.
+    /// </summary>
+    TArray<uint16> MakeDepthImage(const int32 cnt) {
+        FRandomStream rng(42);
+        TArray<uint16> retval;
+        retval.SetNumUninitialized(cnt);
+
+        for (auto& s : retval) {
+            s = (rng.FRand() < 0.1f) ? 0 : rng.RandRange(250, 5460);
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Creates a synthetic depth image of a tilted wall with a box in front
+    /// of it, which has continuous surfaces and discontinuities.
+    /// </summary>
+    TArray<uint16> MakeSceneDepthImage(const int32 width, const int32 height) {
+        TArray<uint16> retval;
+        retval.SetNumUninitialized(width * height);
+
+        for (int32 y = 0, i = 0; y < height; ++y) {
+            for (int32 x = 0; x < width; ++x, ++i) {
+                const auto inBox = (x > width / 3) && (x < 2 * width / 3)
+                    && (y > height / 3) && (y < 2 * height / 3);
+                retval[i] = inBox
+                    ? 1200
+                    : static_cast<uint16>(2500 + (1000 * y) / height);
+            }
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Creates a synthetic calibration with typical parameters of a device
+    /// for the given depth mode and a colour resolution of 720p.
+    /// </summary>
+    k4a::calibration MakeCalibration(const int32 mode) {
+        k4a::calibration retval;
+        FMemory::Memzero(static_cast<k4a_calibration_t&>(retval));
+
+        const auto& size = DepthModeSizes[mode];
+        const auto binned = (size.Width == 320) || (size.Width == 512);
+        retval.depth_mode = DepthModes[mode];
+        retval.color_resolution = K4A_COLOR_RESOLUTION_720P;
+
+        {
+            auto& c = retval.depth_camera_calibration;
+            auto& p = c.intrinsics.parameters.param;
+            c.resolution_width = size.Width;
+            c.resolution_height = size.Height;
+            c.metric_radius = 1.74f;
+            c.intrinsics.type = K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY;
+            c.intrinsics.parameter_count = 14;
+            p.cx = 0.5f * size.Width;
+            p.cy = 0.5f * size.Height;
+            p.fx = p.fy = binned ? 252.0f : 504.0f;
+            p.k1 = 0.55f;
+            p.k2 = -0.02f;
+            p.k3 = -0.002f;
+            p.k4 = 0.9f;
+            p.k5 = 0.2f;
+            p.k6 = -0.01f;
+            p.p1 = p.p2 = 0.0001f;
+            p.metric_radius = c.metric_radius;
+            c.extrinsics.rotation[0] = 1.0f;
+            c.extrinsics.rotation[4] = 1.0f;
+            c.extrinsics.rotation[8] = 1.0f;
+        }
+
+        {
+            auto& c = retval.color_camera_calibration;
+            auto& p = c.intrinsics.parameters.param;
+            c.resolution_width = ColourWidth;
+            c.resolution_height = ColourHeight;
+            c.metric_radius = 1.7f;
+            c.intrinsics.type = K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY;
+            c.intrinsics.parameter_count = 14;
+            p.cx = 638.0f;
+            p.cy = 367.0f;
+            p.fx = p.fy = 610.0f;
+            p.k1 = 0.08f;
+            p.k2 = -0.06f;
+            p.k3 = 0.02f;
+            p.p1 = p.p2 = 0.0005f;
+            p.metric_radius = c.metric_radius;
+        }
+
+        // The colour camera is tilted by six degrees and offset by about
+        // 32 mm from the depth camera.
+        {
+            const auto a = FMath::DegreesToRadians(6.0f);
+            const float r[] = {
+                1.0f, 0.0f, 0.0f,
+                0.0f, FMath::Cos(a), -FMath::Sin(a),
+                0.0f, FMath::Sin(a), FMath::Cos(a)
+            };
+            const float t[] = { -32.0f, -2.0f, 4.0f };
+
+            for (int32 i = 0; i < K4A_CALIBRATION_TYPE_NUM; ++i) {
+                for (int32 j = 0; j < K4A_CALIBRATION_TYPE_NUM; ++j) {
+                    auto& e = retval.extrinsics[i][j];
+                    e.rotation[0] = e.rotation[4] = e.rotation[8] = 1.0f;
+                }
+            }
+
+            auto& d2c = retval.extrinsics[K4A_CALIBRATION_TYPE_DEPTH]
+                [K4A_CALIBRATION_TYPE_COLOR];
+            auto& c2d = retval.extrinsics[K4A_CALIBRATION_TYPE_COLOR]
+                [K4A_CALIBRATION_TYPE_DEPTH];
+            for (int32 i = 0; i < 3; ++i) {
+                c2d.translation[i] = 0.0f;
+                for (int32 j = 0; j < 3; ++j) {
+                    d2c.rotation[3 * i + j] = r[3 * i + j];
+                    c2d.rotation[3 * i + j] = r[3 * j + i];
+                    c2d.translation[i] -= r[3 * j + i] * t[j];
+                }
+                d2c.translation[i] = t[i];
+            }
+
+            retval.color_camera_calibration.extrinsics = d2c;
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Creates a synthetic BGRA32 colour image with smooth gradients, which
+    /// compresses like a natural image.
+    /// </summary>
+    TArray<uint8> MakeColourImage(const int32 width, const int32 height) {
+        TArray<uint8> retval;
+        retval.SetNumUninitialized(4 * width * height);
+
+        auto dst = retval.GetData();
+        for (int32 y = 0; y < height; ++y) {
+            for (int32 x = 0; x < width; ++x) {
+                *dst++ = static_cast<uint8>(255 * x / width);
+                *dst++ = static_cast<uint8>(255 * y / height);
+                *dst++ = static_cast<uint8>(255 * (x + y) / (width + height));
+                *dst++ = 0xFF;
+            }
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Creates a synthetic image with random samples of the given size.
+    /// </summary>
+    TArray<uint8> MakeRandomImage(const int32 size) {
+        FRandomStream rng(42);
+        TArray<uint8> retval;
+        retval.SetNumUninitialized(size);
+
+        for (auto& s : retval) {
+            s = static_cast<uint8>(rng.RandRange(0, 255));
+        }
+
+        return retval;
+    }
+
+    /*
+     * ::BenchmarkColourDecode
+     */
+    void BenchmarkColourDecode(const TArray<FString>& args) {
+        const auto iterations = GetIterations(args);
+        const auto cnt = ColourWidth * ColourHeight;
+
+        TArray<uint8> reference;
+        reference.SetNumUninitialized(4 * cnt);
+        TArray<uint8> dst;
+        dst.SetNumUninitialized(4 * cnt);
+
+        // NV12 and YUY2 are checked against the scalar kernels of the same
+        // format.
+        struct FFormat {
+            const TCHAR *Name;
+            k4a_image_format_t Format;
+            int32 Size;
+            int32 Stride;
+        };
+
+        const FFormat formats[] = {
+            { TEXT("NV12"), K4A_IMAGE_FORMAT_COLOR_NV12,
+                ColourWidth * ColourHeight * 3 / 2, ColourWidth },
+            { TEXT("YUY2"), K4A_IMAGE_FORMAT_COLOR_YUY2,
+                2 * ColourWidth * ColourHeight, 2 * ColourWidth },
+        };
+
+        for (auto& f : formats) {
+            const auto src = MakeRandomImage(f.Size);
+            const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+
+            for (auto& k : kernels) {
+                const auto start = FPlatformTime::Seconds();
+                for (int32 i = 0; i < iterations; ++i) {
+                    for (int32 y = 0; y < ColourHeight; ++y) {
+                        const auto row = src.GetData() + y * f.Stride;
+                        auto d = dst.GetData() + 4 * y * ColourWidth;
+                        if (f.Format == K4A_IMAGE_FORMAT_COLOR_NV12) {
+                            const auto uv = src.GetData()
+                                + ColourHeight * f.Stride
+                                + (y / 2) * f.Stride;
+                            k.Nv12(d, row, uv, ColourWidth);
+                        } else {
+                            k.Yuy2(d, row, ColourWidth);
+                        }
+                    }
+                }
+                const auto elapsed = FPlatformTime::Seconds() - start;
+
+                if (&k == &kernels[0]) {
+                    reference = dst;
+                }
+
+                const auto identical = (FMemory::Memcmp(dst.GetData(),
+                    reference.GetData(), dst.Num()) == 0);
+
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Display,
+                    TEXT("%s conversion (%d x %d), %s: %.2f ms/frame%s"),
+                    f.Name, ColourWidth, ColourHeight, k.Name,
+                    1000.0 * elapsed / iterations,
+                    identical ? TEXT("") : TEXT(" (OUTPUT DIFFERS)"));
+            }
+        }
+
+        // MJPG is checked against the image it was compressed from, which
+        // only allows for an approximate comparison.
+        {
+            const auto src = MakeColourImage(ColourWidth, ColourHeight);
+            auto& module = FModuleManager::LoadModuleChecked<
+                IImageWrapperModule>(FName("ImageWrapper"));
+            auto wrapper = module.CreateImageWrapper(EImageFormat::JPEG);
+            if (!wrapper.IsValid() || !wrapper->SetRaw(src.GetData(),
+                    src.Num(), ColourWidth, ColourHeight, ERGBFormat::BGRA,
+                    8)) {
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Error,
+                    TEXT("Failed to create synthetic JPEG image."));
+                return;
+            }
+
+            const auto jpeg = wrapper->GetCompressed(90);
+            const auto decode = [&jpeg](uint8 *d) {
+                return FAzureKinectColourDecoder::Decode(d,
+                    4 * ColourWidth,
+                    K4A_IMAGE_FORMAT_COLOR_MJPG,
+                    jpeg.GetData(),
+                    jpeg.Num(),
+                    ColourWidth,
+                    ColourHeight,
+                    0);
+            };
+
+            if (!decode(dst.GetData())) {
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Error,
+                    TEXT("Failed to decode synthetic JPEG image."));
+                return;
+            }
+
+            int32 maxError = 0;
+            for (int32 i = 0; i < dst.Num(); ++i) {
+                maxError = FMath::Max(maxError, FMath::Abs(dst[i] - src[i]));
+            }
+
+            auto start = FPlatformTime::Seconds();
+            for (int32 i = 0; i < iterations; ++i) {
+                decode(dst.GetData());
+            }
+            const auto serial = FPlatformTime::Seconds() - start;
+
+            // Decode independent frames in parallel like the decoder threads
+            // do, each of which owns its output buffer.
+            const auto cores = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+            const auto perCore = FMath::DivideAndRoundUp(iterations, cores);
+            TArray<TArray<uint8>> frames;
+            frames.SetNum(cores);
+            for (auto& f : frames) {
+                f.SetNumUninitialized(4 * cnt);
+            }
+
+            start = FPlatformTime::Seconds();
+            ParallelFor(cores, [&frames, &decode, perCore](const int32 i) {
+                for (int32 j = 0; j < perCore; ++j) {
+                    decode(frames[i].GetData());
+                }
+            });
+            const auto parallel = FPlatformTime::Seconds() - start;
+
+            UE_LOG(AzureKinectBenchmarkLog,
+                Display,
+                TEXT("MJPG decoding (%d x %d, %lld bytes): %.2f ms/frame ")
+                TEXT("serial, %.1f frames/s on %d cores, maximum error %d"),
+                ColourWidth, ColourHeight,
+                static_cast<int64>(jpeg.Num()),
+                1000.0 * serial / iterations,
+                perCore * cores / parallel, cores, maxError);
+        }
+    }
+
+    /*
+     * ::BenchmarkConversion
+     */
+    void BenchmarkConversion(const TArray<FString>& args) {
+        const auto iterations = GetIterations(args);
+        const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+
+        for (auto& mode : DepthModeSizes) {
+            const auto cnt = mode.Width * mode.Height;
+            const auto src = MakeDepthImage(cnt);
+
+            TArray<uint8> reference;
+            reference.SetNumUninitialized(4 * cnt);
+            kernels[0].Expand16(reference.GetData(), src.GetData(), cnt);
+
+            TArray<uint8> dst;
+            dst.SetNumUninitialized(4 * cnt);
+
+            for (auto& k : kernels) {
+                const auto start = FPlatformTime::Seconds();
+                for (int32 i = 0; i < iterations; ++i) {
+                    k.Expand16(dst.GetData(), src.GetData(), cnt);
+                }
+                const auto elapsed = FPlatformTime::Seconds() - start;
+
+                const auto mpps = (static_cast<double>(cnt) * iterations)
+                    / (elapsed * 1000.0 * 1000.0);
+                const auto identical = (FMemory::Memcmp(dst.GetData(),
+                    reference.GetData(), dst.Num()) == 0);
+
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Display,
+                    TEXT("Depth/IR expansion, %s (%d x %d), %s: ")
+                    TEXT("%.1f Mpixel/s%s"),
+                    mode.Name, mode.Width, mode.Height, k.Name, mpps,
+                    identical ? TEXT("") : TEXT(" (OUTPUT DIFFERS)"));
+            }
+        }
+    }
+
+    /*
+     * ::BenchmarkDecimation
+     */
+    void BenchmarkDecimation(const TArray<FString>& args) {
+        const auto iterations = GetIterations(args);
+        const auto colourData = MakeRandomImage(4 * 1024 * 1024);
+        const float voxelSizes[] = { 0.5f, 1.0f, 2.0f, 5.0f };
+        const int32 targets[] = { 50000, 100000, 200000 };
+
+        const auto cntModes = static_cast<int32>(UE_ARRAY_COUNT(DepthModeSizes));
+        for (int32 m = 0; m < cntModes; ++m) {
+            const auto& mode = DepthModeSizes[m];
+            const auto cnt = mode.Width * mode.Height;
+            const auto depth = MakeSceneDepthImage(mode.Width, mode.Height);
+            FAzureKinectPointCloud source;
+
+            try {
+                FAzureKinectRegistration registration;
+                registration.Reset(MakeCalibration(m));
+
+                source.Positions.SetNumUninitialized(cnt);
+                FAzureKinectConversion::Unproject(
+                    reinterpret_cast<float *>(source.Positions.GetData()),
+                    depth.GetData(),
+                    registration.GetRaysX(),
+                    registration.GetRaysY(),
+                    cnt);
+            } catch (k4a::error ex) {
+                FString msg(ANSI_TO_TCHAR(ex.what()));
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Error,
+                    TEXT("Decimation benchmark for %s failed: %s"),
+                    mode.Name, *msg);
+                continue;
+            }
+
+            // Drop the points of pixels that cannot be unprojected like the
+            // device does.
+            source.Positions.RemoveAll([](const FVector3f& p) {
+                return FMath::IsNaN(p.Y);
+            });
+            source.Colours.SetNumUninitialized(source.Positions.Num());
+            FMemory::Memcpy(source.Colours.GetData(), colourData.GetData(),
+                source.Colours.Num() * sizeof(FColor));
+
+            for (int32 a = 0; a < 2; ++a) {
+                const auto average = (a != 0);
+                auto cloud = source;
+
+                auto measure = [&](const float voxelSize,
+                        const int32 target) {
+                    FAzureKinectDecimation decimation;
+                    double elapsed = 0.0;
+                    int32 retval = 0;
+
+                    for (int32 i = 0; i < iterations; ++i) {
+                        // Copy into the existing arrays, which does not
+                        // allocate and is not part of the measurement.
+                        cloud.Positions = source.Positions;
+                        cloud.Colours = source.Colours;
+
+                        const auto start = FPlatformTime::Seconds();
+                        retval = decimation.Decimate(cloud, voxelSize, target,
+                            average);
+                        elapsed += FPlatformTime::Seconds() - start;
+                    }
+
+                    UE_LOG(AzureKinectBenchmarkLog,
+                        Display,
+                        TEXT("Decimation, %s, %s, %d points: %.2f ms, ")
+                        TEXT("%d points retained, voxel size %.2f cm"),
+                        mode.Name,
+                        average ? TEXT("centroids") : TEXT("first point"),
+                        source.Positions.Num(),
+                        1000.0 * elapsed / iterations,
+                        retval,
+                        decimation.GetVoxelSize());
+                };
+
+                for (auto v : voxelSizes) {
+                    measure(v, 0);
+                }
+
+                for (auto t : targets) {
+                    measure(0.0f, t);
+                }
+            }
+        }
+    }
+
+    /*
+     * ::BenchmarkDepthFilter
+     */
+    void BenchmarkDepthFilter(const TArray<FString>& args) {
+        const auto iterations = GetIterations(args);
+        const auto tileRows = GetTileRows(args);
+        const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+        FRandomStream rng(42);
+        const FAzureKinectDepthFilterSettings settings;
+        FAzureKinectWorkerPool pool;
+
+        // The calling thread participates in the work.
+        pool.Start(FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 1, 0);
+
+        for (auto& mode : DepthModeSizes) {
+            const auto cnt = mode.Width * mode.Height;
+            const auto width = mode.Width;
+            const auto height = mode.Height;
+
+            // Two noisy frames with holes, which are alternated such that the
+            // temporal stage sees noise rather than a static image.
+            const auto scene = MakeSceneDepthImage(width, height);
+            TArray<uint16> frames[2];
+            for (auto& f : frames) {
+                f = scene;
+                for (auto& s : f) {
+                    s = (rng.FRand() < 0.05f)
+                        ? 0
+                        : static_cast<uint16>(s + rng.RandRange(-8, 8));
+                }
+            }
+
+            TArray<uint16> zeros;
+            zeros.SetNumZeroed(width);
+
+            // Run both stages serially with the default settings, i.e. with
+            // thresholds of 2 % and 5 % and a history weight of 0.6.
+            auto filter = [&](const FAzureKinectConversion::FKernels& k,
+                    TArray<uint16>& history,
+                    TArray<uint16>& dst,
+                    const TArray<uint16>& src) {
+                k.Temporal(history.GetData(), src.GetData(), 3277, 10, 13107,
+                    cnt);
+
+                const auto h = history.GetData();
+                for (int32 r = 0; r < height; ++r) {
+                    const auto row = h + r * width;
+                    k.Spatial(dst.GetData() + r * width,
+                        (r > 0) ? row - width : zeros.GetData(),
+                        row,
+                        (r + 1 < height) ? row + width : zeros.GetData(),
+                        1311,
+                        10,
+                        true,
+                        true,
+                        width);
+                }
+            };
+
+            TArray<uint16> reference;
+            reference.SetNumUninitialized(cnt);
+            {
+                auto history = frames[0];
+                filter(kernels[0], history, reference, frames[1]);
+            }
+
+            TArray<uint16> dst;
+            dst.SetNumUninitialized(cnt);
+
+            for (auto& k : kernels) {
+                auto history = frames[0];
+                filter(k, history, dst, frames[1]);
+                const auto identical = (FMemory::Memcmp(dst.GetData(),
+                    reference.GetData(), cnt * sizeof(uint16)) == 0);
+
+                const auto start = FPlatformTime::Seconds();
+                for (int32 i = 0; i < iterations; ++i) {
+                    filter(k, history, dst, frames[i % 2]);
+                }
+                const auto elapsed = FPlatformTime::Seconds() - start;
+
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Display,
+                    TEXT("Depth filter, %s (%d x %d), %s, single thread: ")
+                    TEXT("%.2f ms%s"),
+                    mode.Name, width, height, k.Name,
+                    1000.0 * elapsed / iterations,
+                    identical ? TEXT("") : TEXT(" (OUTPUT DIFFERS)"));
+            }
+
+            {
+                FAzureKinectDepthFilter depthFilter;
+
+                const auto start = FPlatformTime::Seconds();
+                for (int32 i = 0; i < iterations; ++i) {
+                    depthFilter.Apply(dst.GetData(),
+                        frames[i % 2].GetData(),
+                        width,
+                        height,
+                        settings,
+                        pool,
+                        tileRows);
+                }
+                const auto elapsed = FPlatformTime::Seconds() - start;
+
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Display,
+                    TEXT("Depth filter, %s (%d x %d), %d row tiles: ")
+                    TEXT("%.2f ms"),
+                    mode.Name, width, height, tileRows,
+                    1000.0 * elapsed / iterations);
+            }
+        }
+
+        pool.Shutdown();
+    }
+
+    /*
+     * ::BenchmarkRegistration
+     */
+    void BenchmarkRegistration(const TArray<FString>& args) {
+        const auto iterations = GetIterations(args);
+        const auto tileRows = GetTileRows(args);
+        const auto cores = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+        const auto colourData = MakeRandomImage(4 * ColourWidth * ColourHeight);
+        FAzureKinectWorkerPool pool;
+        pool.Start(cores - 1, 0);
+
+        const auto cntModes = static_cast<int32>(UE_ARRAY_COUNT(DepthModeSizes));
+        for (int32 m = 0; m < cntModes; ++m) {
+            const auto& mode = DepthModeSizes[m];
+            const auto depthData = MakeSceneDepthImage(mode.Width, mode.Height);
+
+            try {
+                const auto calibration = MakeCalibration(m);
+                k4a::transformation transformation(calibration);
+
+                auto start = FPlatformTime::Seconds();
+                FAzureKinectRegistration registration;
+                registration.Reset(calibration);
+                const auto setup = FPlatformTime::Seconds() - start;
+
+                auto depth = k4a::image::create(K4A_IMAGE_FORMAT_DEPTH16,
+                    mode.Width, mode.Height, 2 * mode.Width);
+                FMemory::Memcpy(depth.get_buffer(), depthData.GetData(),
+                    depth.get_size());
+                auto colour = k4a::image::create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                    ColourWidth, ColourHeight, 4 * ColourWidth);
+                FMemory::Memcpy(colour.get_buffer(), colourData.GetData(),
+                    colour.get_size());
+
+                // Depth to colour.
+                {
+                    auto reference = k4a::image::create(
+                        K4A_IMAGE_FORMAT_DEPTH16,
+                        ColourWidth, ColourHeight, 2 * ColourWidth);
+                    TArray<uint16> dst;
+                    dst.SetNumUninitialized(ColourWidth * ColourHeight);
+
+                    start = FPlatformTime::Seconds();
+                    for (int32 i = 0; i < iterations; ++i) {
+                        transformation.depth_image_to_color_camera(depth,
+                            &reference);
+                    }
+                    const auto sdk = FPlatformTime::Seconds() - start;
+
+                    start = FPlatformTime::Seconds();
+                    for (int32 i = 0; i < iterations; ++i) {
+                        registration.DepthToColour(dst.GetData(),
+                            depthData.GetData(), pool, tileRows);
+                    }
+                    const auto lut = FPlatformTime::Seconds() - start;
+
+                    const auto r = reinterpret_cast<const uint16 *>(
+                        reference.get_buffer());
+                    int64 both = 0;
+                    int64 coverage = 0;
+                    double error = 0.0;
+                    for (int32 i = 0; i < dst.Num(); ++i) {
+                        if ((r[i] != 0) && (dst[i] != 0)) {
+                            ++both;
+                            error += FMath::Abs(r[i] - dst[i]);
+                        } else if ((r[i] != 0) != (dst[i] != 0)) {
+                            ++coverage;
+                        }
+                    }
+
+                    UE_LOG(AzureKinectBenchmarkLog,
+                        Display,
+                        TEXT("Depth to colour, %s: SDK %.2f ms, tables ")
+                        TEXT("%.2f ms on %d cores, mean error %.2f mm, ")
+                        TEXT("coverage differs for %.2f%% of the pixels"),
+                        mode.Name,
+                        1000.0 * sdk / iterations,
+                        1000.0 * lut / iterations,
+                        cores,
+                        (both > 0) ? error / both : 0.0,
+                        100.0 * coverage / dst.Num());
+                }
+
+                // Colour to depth.
+                {
+                    auto reference = k4a::image::create(
+                        K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                        mode.Width, mode.Height, 4 * mode.Width);
+                    TArray<uint32> dst;
+                    dst.SetNumUninitialized(mode.Width * mode.Height);
+
+                    start = FPlatformTime::Seconds();
+                    for (int32 i = 0; i < iterations; ++i) {
+                        transformation.color_image_to_depth_camera(depth,
+                            colour, &reference);
+                    }
+                    const auto sdk = FPlatformTime::Seconds() - start;
+
+                    start = FPlatformTime::Seconds();
+                    for (int32 i = 0; i < iterations; ++i) {
+                        registration.ColourToDepth(dst.GetData(),
+                            reinterpret_cast<const uint32 *>(
+                                colourData.GetData()),
+                            depthData.GetData(), pool, tileRows);
+                    }
+                    const auto lut = FPlatformTime::Seconds() - start;
+
+                    // The colours are random, so an identical colour means
+                    // that the same colour pixel has been chosen.
+                    const auto r = reinterpret_cast<const uint32 *>(
+                        reference.get_buffer());
+                    int64 both = 0;
+                    int64 identical = 0;
+                    for (int32 i = 0; i < dst.Num(); ++i) {
+                        if ((r[i] != 0) && (dst[i] != 0)) {
+                            ++both;
+                            identical += (r[i] == dst[i]) ? 1 : 0;
+                        }
+                    }
+
+                    UE_LOG(AzureKinectBenchmarkLog,
+                        Display,
+                        TEXT("Colour to depth, %s: SDK %.2f ms, tables ")
+                        TEXT("%.2f ms on %d cores, %.2f%% identical pixels, ")
+                        TEXT("setup %.1f ms"),
+                        mode.Name,
+                        1000.0 * sdk / iterations,
+                        1000.0 * lut / iterations,
+                        cores,
+                        (both > 0) ? 100.0 * identical / both : 0.0,
+                        1000.0 * setup);
+                }
+            } catch (k4a::error ex) {
+                FString msg(ANSI_TO_TCHAR(ex.what()));
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Error,
+                    TEXT("Registration benchmark for %s failed: %s"),
+                    mode.Name, *msg);
+            }
+        }
+
+        pool.Shutdown();
+    }
+
+    /*
+     * ::BenchmarkSkeletonFilter
+     */
+    void BenchmarkSkeletonFilter(const TArray<FString>& args) {
+        constexpr auto JointCount = FAzureKinectSkeletonData::JointCount;
+        constexpr int32 Bodies = 6;
+        constexpr double FrameTime = 1.0 / 30.0;
+        // The first second is not measured, so there are at least two.
+        const auto frames = FMath::Max(10 * GetIterations(args), 60);
+        FRandomStream rng(42);
+
+        // Each joint moves on a Lissajous figure of its own and is observed
+        // with Gaussian noise, which is stronger for the extremities like
+        // in the output of the tracker.
+        TArray<FAzureKinectSkeletonData> truth;
+        TArray<FAzureKinectSkeletonData> recorded;
+        truth.SetNumUninitialized(frames * Bodies);
+        recorded.SetNumUninitialized(frames * Bodies);
+
+        for (int32 b = 0; b < Bodies; ++b) {
+            float phases[JointCount];
+            for (auto& p : phases) {
+                p = rng.FRandRange(0.0f, 2.0f * PI);
+            }
+
+            for (int32 f = 0; f < frames; ++f) {
+                const auto t = static_cast<float>(f * FrameTime);
+                auto& tr = truth[f * Bodies + b];
+                auto& rec = recorded[f * Bodies + b];
+                tr.ID = rec.ID = b + 1;
+
+                for (int32 j = 0; j < JointCount; ++j) {
+                    const auto a = 2.0f * PI * 0.5f * t + phases[j];
+                    const auto sigma = (j >= 8) ? 2.0f : 1.0f;
+                    tr.Confidences[j] = EKinectJointConfidence::MEDIUM;
+                    tr.Positions[j] = FVector3f(200.0f + 50.0f * b,
+                        20.0f * FMath::Sin(a),
+                        100.0f + 10.0f * FMath::Sin(2.0f * a));
+                    tr.Rotations[j] = FQuat4f(FVector3f::UpVector,
+                        0.5f * FMath::Sin(a));
+
+                    // Box-Muller for the noise.
+                    FVector3f noise;
+                    for (int32 i = 0; i < 3; ++i) {
+                        const auto u = FMath::Max(rng.GetFraction(), 1e-6f);
+                        const auto v = rng.GetFraction();
+                        noise[i] = sigma * FMath::Sqrt(-2.0f * FMath::Loge(u))
+                            * FMath::Cos(2.0f * PI * v);
+                    }
+
+                    rec.Confidences[j] = tr.Confidences[j];
+                    rec.Positions[j] = tr.Positions[j] + noise;
+                    rec.Rotations[j] = tr.Rotations[j];
+                }
+            }
+        }
+
+        const EKinectSkeletonFilter filters[] = {
+            EKinectSkeletonFilter::NONE,
+            EKinectSkeletonFilter::ONE_EURO,
+            EKinectSkeletonFilter::KALMAN
+        };
+        const TCHAR *names[] = {
+            TEXT("none"),
+            TEXT("One Euro"),
+            TEXT("Kalman")
+        };
+
+        const auto cntFilters = static_cast<int32>(UE_ARRAY_COUNT(filters));
+        for (int32 i = 0; i < cntFilters; ++i) {
+            FAzureKinectSkeletonFilterSettings settings;
+            settings.Filter = filters[i];
+            FAzureKinectSkeletonFilter filter;
+            auto filtered = recorded;
+            double elapsed = 0.0;
+
+            for (int32 f = 0; f < frames; ++f) {
+                const auto start = FPlatformTime::Seconds();
+                filter.Apply(filtered.GetData() + f * Bodies,
+                    Bodies,
+                    1.0 + f * FrameTime,
+                    settings);
+                elapsed += FPlatformTime::Seconds() - start;
+            }
+
+            // The error is the distance from the truth and the jitter the
+            // second difference of the positions over time, which would be
+            // close to zero for the smooth movement without noise.
+            double error = 0.0;
+            double jitter = 0.0;
+            int64 cnt = 0;
+            for (int32 f = 30; f < frames; ++f) {
+                for (int32 b = 0; b < Bodies; ++b) {
+                    const auto& p0 = filtered[(f - 2) * Bodies + b];
+                    const auto& p1 = filtered[(f - 1) * Bodies + b];
+                    const auto& p2 = filtered[f * Bodies + b];
+                    const auto& tr = truth[f * Bodies + b];
+
+                    for (int32 j = 0; j < JointCount; ++j) {
+                        error += FVector3f::DistSquared(p2.Positions[j],
+                            tr.Positions[j]);
+                        jitter += (p2.Positions[j] - 2.0f * p1.Positions[j]
+                            + p0.Positions[j]).SizeSquared();
+                        ++cnt;
+                    }
+                }
+            }
+
+            UE_LOG(AzureKinectBenchmarkLog,
+                Display,
+                TEXT("Skeleton filter, %s, %d bodies: %.3f ms per frame, ")
+                TEXT("RMS error %.2f cm, RMS jitter %.2f cm"),
+                names[i], Bodies,
+                1000.0 * elapsed / frames,
+                FMath::Sqrt(error / cnt),
+                FMath::Sqrt(jitter / cnt));
+        }
+    }
+
+    /*
+     * ::BenchmarkScaling
+     */
+    void BenchmarkScaling(const TArray<FString>& args) {
+        const auto iterations = GetIterations(args);
+        const auto tileRows = GetTileRows(args);
+        const auto cores = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+        FAzureKinectWorkerPool pool;
+
+        for (auto& mode : DepthModeSizes) {
+            const auto cnt = mode.Width * mode.Height;
+            const auto src = MakeDepthImage(cnt);
+            auto s = src.GetData();
+            const auto width = mode.Width;
+
+            TArray<uint8> dst;
+            dst.SetNumUninitialized(4 * cnt);
+            auto d = dst.GetData();
+
+            double serial = 0.0;
+
+            // The calling thread participates in the work, so one thread
+            // less than the number of cores is needed in the pool. A single
+            // core is measured without the pool, because an empty pool would
+            // use the task graph.
+            for (int32 c = 1; c <= cores; ++c) {
+                pool.Start(c - 1, 0);
+
+                const auto start = FPlatformTime::Seconds();
+                for (int32 i = 0; i < iterations; ++i) {
+                    auto body = [d, s, width](const int32 b, const int32 e) {
+                        FAzureKinectConversion::Expand16(d + 4 * b * width,
+                            s + b * width,
+                            (e - b) * width);
+                    };
+
+                    if (c > 1) {
+                        pool.ParallelForTiles(mode.Height, tileRows, body);
+                    } else {
+                        for (int32 b = 0; b < mode.Height; b += tileRows) {
+                            body(b, FMath::Min(b + tileRows, mode.Height));
+                        }
+                    }
+                }
+                const auto elapsed = FPlatformTime::Seconds() - start;
+
+                if (c == 1) {
+                    serial = elapsed;
+                }
+
+                const auto mpps = (static_cast<double>(cnt) * iterations)
+                    / (elapsed * 1000.0 * 1000.0);
+
+                UE_LOG(AzureKinectBenchmarkLog,
+                    Display,
+                    TEXT("Depth/IR expansion, %s (%d x %d), %d row tiles, ")
+                    TEXT("%d core(s): %.1f Mpixel/s, speedup %.2f"),
+                    mode.Name, mode.Width, mode.Height, tileRows, c, mpps,
+                    serial / elapsed);
+            }
+        }
+
+        pool.Shutdown();
+    }
+
+    FAutoConsoleCommand BenchmarkColourDecodeCommand(
+        TEXT("AzureKinect.Benchmark.ColourDecode"),
+        TEXT("Converts synthetic NV12, YUY2 and MJPG colour images into ")
+        TEXT("BGRA32, checks the output and measures the throughput. The ")
+        TEXT("optional argument specifies the number of iterations."),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkColourDecode));
+
+    FAutoConsoleCommand BenchmarkConversionCommand(
+        TEXT("AzureKinect.Benchmark.Conversion"),
+        TEXT("Measures the throughput of the depth and infrared conversion ")
+        TEXT("kernels for each depth mode. The optional argument specifies ")
+        TEXT("the number of iterations."),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkConversion));
+
+    FAutoConsoleCommand BenchmarkDecimationCommand(
+        TEXT("AzureKinect.Benchmark.Decimation"),
+        TEXT("Measures the voxel-grid decimation of point clouds generated ")
+        TEXT("from synthetic depth images of each depth mode for fixed voxel ")
+        TEXT("sizes and target numbers of points. The optional argument ")
+        TEXT("specifies the number of iterations."),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkDecimation));
+
+    FAutoConsoleCommand BenchmarkDepthFilterCommand(
+        TEXT("AzureKinect.Benchmark.DepthFilter"),
+        TEXT("Checks the depth filter kernels against the scalar ones and ")
+        TEXT("measures the temporal and spatial filtering of noisy synthetic ")
+        TEXT("depth images of each depth mode. The optional arguments ")
+        TEXT("specify the number of iterations and the number of rows per ")
+        TEXT("tile."),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkDepthFilter));
+
+    FAutoConsoleCommand BenchmarkRegistrationCommand(
+        TEXT("AzureKinect.Benchmark.Registration"),
+        TEXT("Compares the accuracy and the speed of the lookup-table ")
+        TEXT("registration against the transformation of the SDK on ")
+        TEXT("synthetic calibrations of each depth mode. The optional ")
+        TEXT("arguments specify the number of iterations and the number of ")
+        TEXT("rows per tile."),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkRegistration));
+
+    FAutoConsoleCommand BenchmarkSkeletonFilterCommand(
+        TEXT("AzureKinect.Benchmark.SkeletonFilter"),
+        TEXT("Replays synthetic joint streams with tracker-like noise ")
+        TEXT("through the skeleton filters and reports their cost, their ")
+        TEXT("error against the noise-free stream and the remaining jitter. ")
+        TEXT("The optional argument scales the length of the streams."),
+        FConsoleCommandWithArgsDelegate::CreateStatic(
+            &BenchmarkSkeletonFilter));
+
+    FAutoConsoleCommand BenchmarkScalingCommand(
+        TEXT("AzureKinect.Benchmark.Scaling"),
+        TEXT("Measures the throughput of the tiled depth and infrared ")
+        TEXT("conversion for each depth mode on one up to all cores. The ")
+        TEXT("optional arguments specify the number of iterations and the ")
+        TEXT("number of rows per tile."),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkScaling));
+
+} /* namespace */
@@ -0,0 +1,172 @@
+﻿// <copyright file="AzureKinectBufferPool.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectBufferPool.h"
+
+#include <cassert>
+
+
+/*
+ * FAzureKinectBufferPool::FAzureKinectBufferPool
+ */
+FAzureKinectBufferPool::FAzureKinectBufferPool(void)
+    : _hits(0), _misses(0), _size(0) { }
+
+
+/*
+ * FAzureKinectBufferPool::~FAzureKinectBufferPool
+ */
+FAzureKinectBufferPool::~FAzureKinectBufferPool(void) {
+    // Buffers in use hold a reference to us, so all of them must have
+    // returned at this point.
+    for (auto b : this->_available) {
+        Free(b);
+    }
+}
+
+
+/*
+ * FAzureKinectBufferPool::Acquire
+ */
+k4a::image FAzureKinectBufferPool::Acquire(const k4a_image_format_t format,
+        const int32 width,
+        const int32 height,
+        const int32 stride) {
+    const auto size = height * stride;
+    FBuffer *buffer = nullptr;
+    int32 poolSize = 0;
+
+    {
+        FScopeLock l(&this->_lock);
+        poolSize = this->_size;
+
+        if ((size <= poolSize) && (this->_available.Num() > 0)) {
+            buffer = this->_available.Pop(EAllowShrinking::No);
+            ++this->_hits;
+        } else {
+            ++this->_misses;
+        }
+    }
+
+    if (buffer == nullptr) {
+        // If the image fits, we allocate a buffer of the pool size such that
+        // the pool can grow to the number of buffers actually in flight.
+        buffer = Allocate(FMath::Max(size, poolSize));
+    }
+
+    buffer->Owner = this->AsShared();
+
+    try {
+        return k4a::image::create_from_buffer(format,
+            width,
+            height,
+            stride,
+            buffer->Data,
+            buffer->Size,
+            &FAzureKinectBufferPool::OnRelease,
+            buffer);
+    } catch (...) {
+        buffer->Owner.Reset();
+        this->Return(buffer);
+        throw;
+    }
+}
+
+
+/*
+ * FAzureKinectBufferPool::GetStatistics
+ */
+void FAzureKinectBufferPool::GetStatistics(
+        FAzureKinectBufferPoolStatistics& statistics) const {
+    FScopeLock l(&this->_lock);
+    statistics.Available = this->_available.Num();
+    statistics.BufferSize = this->_size;
+    statistics.Hits = this->_hits;
+    statistics.Misses = this->_misses;
+}
+
+
+/*
+ * FAzureKinectBufferPool::Reset
+ */
+void FAzureKinectBufferPool::Reset(const int32 size, const int32 count) {
+    TArray<FBuffer *> buffers;
+    buffers.Reserve(count);
+    for (int32 i = 0; i < count; ++i) {
+        buffers.Add(Allocate(size));
+    }
+
+    {
+        FScopeLock l(&this->_lock);
+        Swap(buffers, this->_available);
+        this->_hits = 0;
+        this->_misses = 0;
+        this->_size = size;
+    }
+
+    for (auto b : buffers) {
+        Free(b);
+    }
+}
+
+
+/*
+ * FAzureKinectBufferPool::Allocate
+ */
+FAzureKinectBufferPool::FBuffer *FAzureKinectBufferPool::Allocate(
+        const int32 size) {
+    auto retval = new FBuffer();
+    // Align the buffers for the vector units of the conversion kernels.
+    retval->Data = static_cast<uint8 *>(FMemory::Malloc(size, 64));
+    retval->Size = size;
+    return retval;
+}
+
+
+/*
+ * FAzureKinectBufferPool::Free
+ */
+void FAzureKinectBufferPool::Free(FBuffer *buffer) {
+    if (buffer != nullptr) {
+        assert(!buffer->Owner.IsValid());
+        FMemory::Free(buffer->Data);
+        delete buffer;
+    }
+}
+
+
+/*
+ * FAzureKinectBufferPool::OnRelease
+ */
+void FAzureKinectBufferPool::OnRelease(void *data, void *context) {
+    auto buffer = static_cast<FBuffer *>(context);
+    assert(buffer != nullptr);
+    assert(buffer->Data == data);
+
+    // Move the reference to the pool out of the buffer, because the pooled
+    // buffer must not keep the pool alive. If this is the last reference, the
+    // pool is destroyed once we leave the scope.
+    auto pool = MoveTemp(buffer->Owner);
+    pool->Return(buffer);
+}
+
+
+/*
+ * FAzureKinectBufferPool::Return
+ */
+void FAzureKinectBufferPool::Return(FBuffer *buffer) {
+    assert(buffer != nullptr);
+
+    {
+        FScopeLock l(&this->_lock);
+        if (buffer->Size == this->_size) {
+            this->_available.Push(buffer);
+            return;
+        }
+    }
+
+    Free(buffer);
+}
@@ -0,0 +1,344 @@
+﻿// <copyright file="AzureKinectColourDecoder.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectColourDecoder.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+
+#include "AzureKinectConversion.h"
+#include "AzureKinectDeviceThread.h"
+
+
+namespace {
+
+    /// <summary>
+    /// Answer the module providing the JPEG codec.
+    /// </summary>
+    /// <remarks>
+    /// The module is loaded on first use, which should therefore happen on
+    /// the game thread.
+    /// </remarks>
+    IImageWrapperModule& GetImageWrapperModule(void) {
+        static auto& retval = FModuleManager::LoadModuleChecked<
+            IImageWrapperModule>(FName("ImageWrapper"));
+        return retval;
+    }
+
+    /*
+     * ::DecodeMjpg
+     */
+    bool DecodeMjpg(uint8 *dst,
+            const int32 pitch,
+            const uint8 *src,
+            const size_t size,
+            const int32 width,
+            const int32 height) {
+        auto wrapper = GetImageWrapperModule().CreateImageWrapper(
+            EImageFormat::JPEG);
+        if (!wrapper.IsValid() || !wrapper->SetCompressed(src, size)) {
+            return false;
+        }
+
+        if ((wrapper->GetWidth() != width)
+                || (wrapper->GetHeight() != height)) {
+            return false;
+        }
+
+        TArray64<uint8> raw;
+        if (!wrapper->GetRaw(ERGBFormat::BGRA, 8, raw)) {
+            return false;
+        }
+
+        for (int32 y = 0; y < height; ++y) {
+            FMemory::Memcpy(dst + y * pitch,
+                raw.GetData() + static_cast<int64>(y) * 4 * width,
+                4 * width);
+        }
+
+        return true;
+    }
+
+} /* namespace */
+
+
+/*
+ * FAzureKinectColourDecoder::Decode
+ */
+bool FAzureKinectColourDecoder::Decode(uint8 *dst,
+        const int32 pitch,
+        const k4a_image_format_t format,
+        const uint8 *src,
+        const size_t size,
+        const int32 width,
+        const int32 height,
+        const int32 stride) {
+    if ((dst == nullptr) || (src == nullptr) || (width < 1) || (height < 1)
+            || (pitch < 4 * width)) {
+        return false;
+    }
+
+    switch (format) {
+        case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+            if ((stride < 4 * width) || (size < static_cast<size_t>(
+                    stride * height))) {
+                return false;
+            }
+
+            for (int32 y = 0; y < height; ++y) {
+                FMemory::Memcpy(dst + y * pitch, src + y * stride, 4 * width);
+            }
+            return true;
+
+        case K4A_IMAGE_FORMAT_COLOR_MJPG:
+            return DecodeMjpg(dst, pitch, src, size, width, height);
+
+        case K4A_IMAGE_FORMAT_COLOR_NV12: {
+            // The luma plane is followed by the interleaved chroma plane of
+            // half the height.
+            if ((stride < width) || (size < static_cast<size_t>(
+                    stride * (height + (height + 1) / 2)))) {
+                return false;
+            }
+
+            const auto uv = src + stride * height;
+            for (int32 y = 0; y < height; ++y) {
+                FAzureKinectConversion::Nv12(dst + y * pitch,
+                    src + y * stride,
+                    uv + (y / 2) * stride,
+                    width);
+            }
+            return true;
+        }
+
+        case K4A_IMAGE_FORMAT_COLOR_YUY2:
+            if ((stride < 2 * width) || (size < static_cast<size_t>(
+                    stride * height))) {
+                return false;
+            }
+
+            for (int32 y = 0; y < height; ++y) {
+                FAzureKinectConversion::Yuy2(dst + y * pitch,
+                    src + y * stride,
+                    width);
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+/*
+ * FAzureKinectColourDecoder::Decode
+ */
+k4a::image FAzureKinectColourDecoder::Decode(const k4a::image& image,
+        FAzureKinectBufferPool& pool) {
+    assert(image);
+    const auto width = image.get_width_pixels();
+    const auto height = image.get_height_pixels();
+    auto retval = pool.Acquire(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+        width,
+        height,
+        4 * width);
+
+    if (!Decode(retval.get_buffer(),
+            4 * width,
+            image.get_format(),
+            image.get_buffer(),
+            image.get_size(),
+            width,
+            height,
+            image.get_stride_bytes())) {
+        retval.reset();
+    }
+
+    return retval;
+}
+
+
+/*
+ * FAzureKinectColourDecoder::FAzureKinectColourDecoder
+ */
+FAzureKinectColourDecoder::FAzureKinectColourDecoder(void)
+    : _latest(0), _sequence(0), _stopCounter(0) { }
+
+
+/*
+ * FAzureKinectColourDecoder::~FAzureKinectColourDecoder
+ */
+FAzureKinectColourDecoder::~FAzureKinectColourDecoder(void) {
+    this->Shutdown();
+}
+
+
+/*
+ * FAzureKinectColourDecoder::GetStatistics
+ */
+void FAzureKinectColourDecoder::GetStatistics(
+        FAzureKinectStageStatistics& statistics) const {
+    this->_queue.GetStatistics(statistics);
+    statistics.Dropped += this->_cntDiscarded.GetValue();
+    statistics.Processed = this->_cntDecoded.GetValue();
+}
+
+
+/*
+ * FAzureKinectColourDecoder::Run
+ */
+uint32 FAzureKinectColourDecoder::Run(void) {
+    using namespace std::chrono_literals;
+
+    while (this->_stopCounter.GetValue() == 0) {
+        FJob job;
+
+        // Multiple threads wait on the queue, but closing it only wakes one
+        // of them, so we must not wait too long for the others to notice.
+        if (!this->_queue.Pop(job, 100ms)) {
+            continue;
+        }
+
+        k4a::image image;
+        try {
+            image = Decode(job.Image, *this->_pool);
+        } catch (k4a::error ex) {
+            FString msg(ANSI_TO_TCHAR(ex.what()));
+            UE_LOG(AzureKinectThreadLog,
+                Error,
+                TEXT("Failed to allocate decoded colour image: %s"), *msg);
+            this->_cntDiscarded.Increment();
+            continue;
+        }
+
+        if (!image) {
+            UE_LOG(AzureKinectThreadLog,
+                Warning,
+                TEXT("Failed to decode colour image."));
+            this->_cntDiscarded.Increment();
+            continue;
+        }
+
+        this->_cntDecoded.Increment();
+
+        // Images might complete out of order, in which case we must not
+        // overwrite the texture with an older one. The lock makes sure that
+        // the submissions are in the order of the sequence numbers.
+        {
+            FScopeLock l(&this->_lock);
+            if (job.Sequence < this->_latest) {
+                this->_cntDiscarded.Increment();
+                continue;
+            }
+
+            this->_latest = job.Sequence;
+
+            const auto width = image.get_width_pixels();
+            const auto height = image.get_height_pixels();
+            FAzureKinectTextureUploads uploads;
+            uploads.Emplace(EKinectStream::COLOUR,
+                job.Target,
+                MoveTemp(image),
+                width,
+                height,
+                4 * width);
+            uploads.Last().FrameInfo = job.FrameInfo;
+            this->_uploader->Submit(MoveTemp(uploads));
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * FAzureKinectColourDecoder::Shutdown
+ */
+void FAzureKinectColourDecoder::Shutdown(void) {
+    this->Stop();
+
+    for (auto t : this->_threads) {
+        t->WaitForCompletion();
+        delete t;
+    }
+
+    this->_threads.Reset();
+    this->_stopCounter.Reset();
+}
+
+
+/*
+ * FAzureKinectColourDecoder::Start
+ */
+void FAzureKinectColourDecoder::Start(const int32 threads,
+        const TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe>& pool,
+        const TSharedPtr<FAzureKinectTextureUploader, ESPMode::ThreadSafe>& uploader) {
+    assert(pool.IsValid());
+    assert(uploader.IsValid());
+    this->Shutdown();
+
+    // Make sure that the codec is loaded on the calling thread even if the
+    // images are decoded synchronously.
+    GetImageWrapperModule();
+
+    if (threads < 1) {
+        return;
+    }
+
+    this->_latest = 0;
+    this->_pool = pool;
+    this->_sequence = 0;
+    this->_uploader = uploader;
+    this->_cntDecoded.Reset();
+    this->_cntDiscarded.Reset();
+    this->_queue.Open(threads);
+
+    for (int32 i = 0; i < threads; ++i) {
+        const auto name = FString::Printf(TEXT("Azure Kinect colour decoder %d"),
+            i);
+        auto thread = FRunnableThread::Create(this,
+            *name,
+            0,
+            TPri_BelowNormal);
+
+        if (thread != nullptr) {
+            this->_threads.Add(thread);
+        } else {
+            UE_LOG(AzureKinectThreadLog,
+                Error,
+                TEXT("Failed to create Azure Kinect worker thread \"%s\"."),
+                *name);
+        }
+    }
+}
+
+
+/*
+ * FAzureKinectColourDecoder::Stop
+ */
+void FAzureKinectColourDecoder::Stop(void) {
+    this->_stopCounter.Increment();
+    this->_queue.Close();
+}
+
+
+/*
+ * FAzureKinectColourDecoder::Submit
+ */
+void FAzureKinectColourDecoder::Submit(k4a::image&& image,
+        UTextureRenderTarget2D *target,
+        const FAzureKinectFrameInfo& frameInfo) {
+    FJob job;
+    job.FrameInfo = frameInfo;
+    job.Image = MoveTemp(image);
+    job.Sequence = ++this->_sequence;
+    job.Target = target;
+    this->_queue.Push(MoveTemp(job));
+}
@@ -0,0 +1,909 @@
+﻿// <copyright file="AzureKinectConversion.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectConversion.h"
+
+#include "HAL/PlatformMisc.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#include <immintrin.h>
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#endif /* PLATFORM_CPU_X86_FAMILY */
+
+
+// MSVC allows for using AVX2 intrinsics without enabling them for the whole
+// module, whereas Clang requires the functions to be marked explicitly.
+#if PLATFORM_CPU_X86_FAMILY && (defined(__clang__) || defined(__GNUC__))
+#define AZUREKINECT_TARGET_AVX2 __attribute__((target("avx2")))
+#else /* PLATFORM_CPU_X86_FAMILY && (defined(__clang__) || defined(__GNUC__)) */
+#define AZUREKINECT_TARGET_AVX2
+#endif /* PLATFORM_CPU_X86_FAMILY && (defined(__clang__) || defined(__GNUC__)) */
+
+
+namespace {
+
+    /*
+     * ::YuvToBgraScalar
+     */
+    inline void YuvToBgraScalar(uint8 *dst,
+            const int32 y,
+            const int32 u,
+            const int32 v) {
+        const auto c = 75 * (y - 16);
+        const auto d = u - 128;
+        const auto e = v - 128;
+        dst[0] = static_cast<uint8>(FMath::Clamp((c + 129 * d + 32) >> 6,
+            0, 255));
+        dst[1] = static_cast<uint8>(FMath::Clamp((c - 25 * d - 52 * e + 32)
+            >> 6, 0, 255));
+        dst[2] = static_cast<uint8>(FMath::Clamp((c + 102 * e + 32) >> 6,
+            0, 255));
+        dst[3] = 0xFF;
+    }
+
+    /*
+     * ::Expand16Scalar
+     */
+    void Expand16Scalar(uint8 *dst, const uint16 *src, const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i, dst += 4) {
+            const auto sample = src[i];
+            dst[0] = static_cast<uint8>(sample & 0xFF);
+            dst[1] = static_cast<uint8>(sample >> 8);
+            dst[2] = (sample > 0) ? 0x00 : 0xFF;
+            dst[3] = 0xFF;
+        }
+    }
+
+    /*
+     * ::Lookup8Scalar
+     */
+    void Lookup8Scalar(uint32 *dst,
+            const uint8 *src,
+            const uint32 *lut,
+            const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i) {
+            dst[i] = lut[src[i]];
+        }
+    }
+
+    /*
+     * ::Pack16Scalar
+     */
+    void Pack16Scalar(uint16 *dst,
+            const uint16 *depth,
+            const uint16 *infrared,
+            const uint8 *bodyIndex,
+            const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i, dst += 4) {
+            dst[0] = depth[i];
+            dst[1] = infrared[i];
+            dst[2] = (bodyIndex != nullptr) ? bodyIndex[i] : 0xFF;
+            dst[3] = 0;
+        }
+    }
+
+    /*
+     * ::Nv12Scalar
+     */
+    void Nv12Scalar(uint8 *dst,
+            const uint8 *y,
+            const uint8 *uv,
+            const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i, dst += 4) {
+            const auto c = uv + (i & ~1);
+            YuvToBgraScalar(dst, y[i], c[0], c[1]);
+        }
+    }
+
+    /*
+     * ::ReprojectScalar
+     */
+    void ReprojectScalar(float *x,
+            float *y,
+            float *z,
+            const uint16 *depth,
+            const float *rayX,
+            const float *rayY,
+            const float *transform,
+            const int32 cnt) {
+        const auto t = transform;
+        for (int32 i = 0; i < cnt; ++i) {
+            const auto d = static_cast<float>(depth[i]);
+            const auto px = d * rayX[i];
+            const auto py = d * rayY[i];
+            const auto tx = t[0] * px + t[1] * py + t[2] * d + t[3];
+            const auto ty = t[4] * px + t[5] * py + t[6] * d + t[7];
+            const auto tz = t[8] * px + t[9] * py + t[10] * d + t[11];
+            x[i] = tx / tz;
+            y[i] = ty / tz;
+            z[i] = (depth[i] != 0) ? tz : 0.0f;
+        }
+    }
+
+    /*
+     * ::SpatialPixel
+     */
+    inline uint16 SpatialPixel(const uint32 c,
+            const uint32 above,
+            const uint32 below,
+            const uint32 left,
+            const uint32 right,
+            const uint32 threshold,
+            const uint32 minThreshold,
+            const bool smooth,
+            const bool fill) {
+        const uint32 neighbours[] = { above, below, left, right };
+
+        if (c != 0) {
+            if (!smooth) {
+                return static_cast<uint16>(c);
+            }
+
+            const auto t = ((c * threshold) >> 16) + minThreshold;
+            uint32 sum = 2 * c;
+            uint32 weight = 2;
+
+            for (auto n : neighbours) {
+                const auto d = (n > c) ? n - c : c - n;
+                if ((n != 0) && (d <= t)) {
+                    sum += n;
+                    ++weight;
+                }
+            }
+
+            // A sample without any similar neighbour is a flying pixel.
+            return (weight > 2)
+                ? static_cast<uint16>(static_cast<int32>(
+                    static_cast<float>(sum) / static_cast<float>(weight)
+                    + 0.5f))
+                : 0;
+        }
+
+        if (fill) {
+            uint32 sum = 0;
+            uint32 weight = 0;
+            uint32 lo = 0xFFFF;
+            uint32 hi = 0;
+
+            for (auto n : neighbours) {
+                if (n != 0) {
+                    sum += n;
+                    ++weight;
+                    lo = FMath::Min(lo, n);
+                    hi = FMath::Max(hi, n);
+                }
+            }
+
+            // Only fill the hole if it does not span an edge.
+            const auto t = ((lo * threshold) >> 16) + minThreshold;
+            if ((weight >= 2) && (hi - lo <= t)) {
+                return static_cast<uint16>(static_cast<int32>(
+                    static_cast<float>(sum) / static_cast<float>(weight)
+                    + 0.5f));
+            }
+        }
+
+        return 0;
+    }
+
+    /*
+     * ::SpatialScalar
+     */
+    void SpatialScalar(uint16 *dst,
+            const uint16 *above,
+            const uint16 *row,
+            const uint16 *below,
+            const uint16 threshold,
+            const uint16 minThreshold,
+            const bool smooth,
+            const bool fill,
+            const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i) {
+            dst[i] = SpatialPixel(row[i],
+                above[i],
+                below[i],
+                (i > 0) ? row[i - 1] : 0,
+                (i + 1 < cnt) ? row[i + 1] : 0,
+                threshold,
+                minThreshold,
+                smooth,
+                fill);
+        }
+    }
+
+    /*
+     * ::TemporalScalar
+     */
+    void TemporalScalar(uint16 *history,
+            const uint16 *depth,
+            const uint16 threshold,
+            const uint16 minThreshold,
+            const int16 weight,
+            const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i) {
+            const int32 h = history[i];
+            const int32 d = depth[i];
+
+            if ((d == 0) || (h == 0)) {
+                history[i] = static_cast<uint16>(d);
+                continue;
+            }
+
+            const auto t = ((h * threshold) >> 16) + minThreshold;
+            if (FMath::Abs(d - h) > t) {
+                history[i] = static_cast<uint16>(d);
+            } else {
+                history[i] = static_cast<uint16>(
+                    h + ((2 * (d - h) * weight) >> 16));
+            }
+        }
+    }
+
+    /*
+     * ::UnprojectScalar
+     */
+    void UnprojectScalar(float *dst,
+            const uint16 *depth,
+            const float *rayX,
+            const float *rayY,
+            const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i, dst += 3) {
+            const auto d = static_cast<float>(depth[i]);
+            dst[0] = d * 0.1f;
+            dst[1] = d * rayX[i] * 0.1f;
+            dst[2] = -(d * rayY[i] * 0.1f);
+        }
+    }
+
+    /*
+     * ::Yuy2Scalar
+     */
+    void Yuy2Scalar(uint8 *dst, const uint8 *src, const int32 cnt) {
+        for (int32 i = 0; i < cnt; ++i, dst += 4) {
+            const auto c = src + 2 * (i & ~1);
+            YuvToBgraScalar(dst, src[2 * i], c[1], c[3]);
+        }
+    }
+
+#if PLATFORM_CPU_X86_FAMILY
+    /*
+     * ::YuvToBgraSse2
+     */
+    inline void YuvToBgraSse2(uint8 *dst,
+            const __m128i y0, const __m128i u0, const __m128i v0,
+            const __m128i y1, const __m128i u1, const __m128i v1) {
+        // All inputs are eight 16-bit samples. The intermediate results fit
+        // into 16 bits except for the blue channel of very bright pixels,
+        // which saturate to a value that is clipped to 0xFF anyway. The
+        // output is therefore identical to the scalar implementation.
+        const auto c16 = _mm_set1_epi16(16);
+        const auto c128 = _mm_set1_epi16(128);
+        const auto round = _mm_set1_epi16(32);
+        __m128i b[2], g[2], r[2];
+
+        for (int32 i = 0; i < 2; ++i) {
+            const auto c = _mm_mullo_epi16(_mm_sub_epi16((i == 0) ? y0 : y1,
+                c16), _mm_set1_epi16(75));
+            const auto d = _mm_sub_epi16((i == 0) ? u0 : u1, c128);
+            const auto e = _mm_sub_epi16((i == 0) ? v0 : v1, c128);
+
+            b[i] = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(c,
+                _mm_mullo_epi16(d, _mm_set1_epi16(129))), round), 6);
+            g[i] = _mm_srai_epi16(_mm_adds_epi16(_mm_subs_epi16(
+                _mm_subs_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(25))),
+                _mm_mullo_epi16(e, _mm_set1_epi16(52))), round), 6);
+            r[i] = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(c,
+                _mm_mullo_epi16(e, _mm_set1_epi16(102))), round), 6);
+        }
+
+        // Packing with unsigned saturation performs the clipping.
+        const auto b8 = _mm_packus_epi16(b[0], b[1]);
+        const auto g8 = _mm_packus_epi16(g[0], g[1]);
+        const auto r8 = _mm_packus_epi16(r[0], r[1]);
+        const auto a8 = _mm_set1_epi8(-1);
+
+        const auto bgLo = _mm_unpacklo_epi8(b8, g8);
+        const auto bgHi = _mm_unpackhi_epi8(b8, g8);
+        const auto raLo = _mm_unpacklo_epi8(r8, a8);
+        const auto raHi = _mm_unpackhi_epi8(r8, a8);
+
+        auto o = reinterpret_cast<__m128i *>(dst);
+        _mm_storeu_si128(o, _mm_unpacklo_epi16(bgLo, raLo));
+        _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(bgLo, raLo));
+        _mm_storeu_si128(o + 2, _mm_unpacklo_epi16(bgHi, raHi));
+        _mm_storeu_si128(o + 3, _mm_unpackhi_epi16(bgHi, raHi));
+    }
+
+    /*
+     * ::Nv12Sse2
+     */
+    void Nv12Sse2(uint8 *dst,
+            const uint8 *y,
+            const uint8 *uv,
+            const int32 cnt) {
+        const auto mask = _mm_set1_epi16(0x00FF);
+        const auto zero = _mm_setzero_si128();
+        int32 i = 0;
+
+        for (; i + 16 <= cnt; i += 16) {
+            const auto ys = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(y + i));
+            const auto cs = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(uv + i));
+
+            // Each chroma sample is shared by two neighbouring pixels.
+            const auto u = _mm_and_si128(cs, mask);
+            const auto v = _mm_srli_epi16(cs, 8);
+
+            YuvToBgraSse2(dst + 4 * i,
+                _mm_unpacklo_epi8(ys, zero),
+                _mm_unpacklo_epi16(u, u),
+                _mm_unpacklo_epi16(v, v),
+                _mm_unpackhi_epi8(ys, zero),
+                _mm_unpackhi_epi16(u, u),
+                _mm_unpackhi_epi16(v, v));
+        }
+
+        Nv12Scalar(dst + 4 * i, y + i, uv + i, cnt - i);
+    }
+
+    /*
+     * ::Yuy2Sse2
+     */
+    void Yuy2Sse2(uint8 *dst, const uint8 *src, const int32 cnt) {
+        const auto mask = _mm_set1_epi16(0x00FF);
+        int32 i = 0;
+
+        for (; i + 16 <= cnt; i += 16) {
+            __m128i y[2], u[2], v[2];
+
+            for (int32 h = 0; h < 2; ++h) {
+                const auto s = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(src + 2 * i + 16 * h));
+                // 'c' holds U0, V0, U1, V1, ... for eight pixels.
+                const auto c = _mm_srli_epi16(s, 8);
+                y[h] = _mm_and_si128(s, mask);
+                u[h] = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c,
+                    _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+                v[h] = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c,
+                    _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+            }
+
+            YuvToBgraSse2(dst + 4 * i, y[0], u[0], v[0], y[1], u[1], v[1]);
+        }
+
+        Yuy2Scalar(dst + 4 * i, src + 2 * i, cnt - i);
+    }
+
+    /*
+     * ::ReprojectSse2
+     */
+    void ReprojectSse2(float *x,
+            float *y,
+            float *z,
+            const uint16 *depth,
+            const float *rayX,
+            const float *rayY,
+            const float *transform,
+            const int32 cnt) {
+        __m128 t[12];
+        for (int32 j = 0; j < 12; ++j) {
+            t[j] = _mm_set1_ps(transform[j]);
+        }
+
+        const auto zero = _mm_setzero_si128();
+        int32 i = 0;
+
+        // The operations are performed in the same order as in the scalar
+        // implementation, which makes the results bit-identical as long as
+        // the compiler does not contract them into fused multiply-adds.
+        for (; i + 4 <= cnt; i += 4) {
+            const auto s = _mm_unpacklo_epi16(_mm_loadl_epi64(
+                reinterpret_cast<const __m128i *>(depth + i)), zero);
+            const auto d = _mm_cvtepi32_ps(s);
+            const auto px = _mm_mul_ps(d, _mm_loadu_ps(rayX + i));
+            const auto py = _mm_mul_ps(d, _mm_loadu_ps(rayY + i));
+
+            auto tx = _mm_add_ps(_mm_mul_ps(t[0], px), _mm_mul_ps(t[1], py));
+            tx = _mm_add_ps(_mm_add_ps(tx, _mm_mul_ps(t[2], d)), t[3]);
+            auto ty = _mm_add_ps(_mm_mul_ps(t[4], px), _mm_mul_ps(t[5], py));
+            ty = _mm_add_ps(_mm_add_ps(ty, _mm_mul_ps(t[6], d)), t[7]);
+            auto tz = _mm_add_ps(_mm_mul_ps(t[8], px), _mm_mul_ps(t[9], py));
+            tz = _mm_add_ps(_mm_add_ps(tz, _mm_mul_ps(t[10], d)), t[11]);
+
+            _mm_storeu_ps(x + i, _mm_div_ps(tx, tz));
+            _mm_storeu_ps(y + i, _mm_div_ps(ty, tz));
+            const auto valid = _mm_castsi128_ps(_mm_xor_si128(
+                _mm_cmpeq_epi32(s, zero), _mm_set1_epi32(-1)));
+            _mm_storeu_ps(z + i, _mm_and_ps(tz, valid));
+        }
+
+        ReprojectScalar(x + i,
+            y + i,
+            z + i,
+            depth + i,
+            rayX + i,
+            rayY + i,
+            transform,
+            cnt - i);
+    }
+
+    /*
+     * ::DivideSse2
+     */
+    inline __m128i DivideSse2(const __m128i sumLo,
+            const __m128i sumHi,
+            const __m128i weight) {
+        const auto bias = _mm_set1_epi32(0x8000);
+        const auto half = _mm_set1_ps(0.5f);
+        const auto zero = _mm_setzero_si128();
+
+        const auto lo = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(
+            _mm_cvtepi32_ps(sumLo),
+            _mm_cvtepi32_ps(_mm_unpacklo_epi16(weight, zero))), half));
+        const auto hi = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(
+            _mm_cvtepi32_ps(sumHi),
+            _mm_cvtepi32_ps(_mm_unpackhi_epi16(weight, zero))), half));
+
+        // There is no unsigned saturation from 32 to 16 bits in SSE2, so
+        // the values are shifted into the signed range and back.
+        return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo, bias),
+            _mm_sub_epi32(hi, bias)), _mm_set1_epi16(
+            static_cast<int16>(0x8000)));
+    }
+
+    /*
+     * ::SpatialSse2
+     */
+    void SpatialSse2(uint16 *dst,
+            const uint16 *above,
+            const uint16 *row,
+            const uint16 *below,
+            const uint16 threshold,
+            const uint16 minThreshold,
+            const bool smooth,
+            const bool fill,
+            const int32 cnt) {
+        const auto bias = _mm_set1_epi16(static_cast<int16>(0x8000));
+        const auto fillMask = _mm_set1_epi16(fill ? -1 : 0);
+        const auto minT = _mm_set1_epi16(static_cast<int16>(minThreshold));
+        const auto one = _mm_set1_epi16(1);
+        const auto ones = _mm_set1_epi16(-1);
+        const auto relT = _mm_set1_epi16(static_cast<int16>(threshold));
+        const auto smoothMask = _mm_set1_epi16(smooth ? -1 : 0);
+        const auto zero = _mm_setzero_si128();
+
+        if (cnt < 10) {
+            SpatialScalar(dst, above, row, below, threshold, minThreshold,
+                smooth, fill, cnt);
+            return;
+        }
+
+        // The first sample has no left neighbour, which the vector loop
+        // cannot handle.
+        dst[0] = SpatialPixel(row[0], above[0], below[0], 0, row[1],
+            threshold, minThreshold, smooth, fill);
+        int32 i = 1;
+
+        for (; i + 8 < cnt; i += 8) {
+            const auto c = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(row + i));
+            const __m128i neighbours[] = {
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + i)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(below + i)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i - 1)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i + 1))
+            };
+            const auto hole = _mm_cmpeq_epi16(c, zero);
+            const auto tc = _mm_adds_epu16(_mm_mulhi_epu16(c, relT), minT);
+
+            auto smoothLo = _mm_slli_epi32(_mm_unpacklo_epi16(c, zero), 1);
+            auto smoothHi = _mm_slli_epi32(_mm_unpackhi_epi16(c, zero), 1);
+            auto smoothWeight = zero;
+            auto fillLo = zero;
+            auto fillHi = zero;
+            auto fillWeight = zero;
+            auto lo = ones;
+            auto hi = zero;
+
+            for (auto n : neighbours) {
+                const auto valid = _mm_andnot_si128(_mm_cmpeq_epi16(n, zero),
+                    ones);
+                const auto diff = _mm_or_si128(_mm_subs_epu16(n, c),
+                    _mm_subs_epu16(c, n));
+                const auto similar = _mm_and_si128(_mm_and_si128(valid,
+                    _mm_cmpeq_epi16(_mm_subs_epu16(diff, tc), zero)),
+                    smoothMask);
+
+                const auto s = _mm_and_si128(n, similar);
+                smoothLo = _mm_add_epi32(smoothLo, _mm_unpacklo_epi16(s, zero));
+                smoothHi = _mm_add_epi32(smoothHi, _mm_unpackhi_epi16(s, zero));
+                smoothWeight = _mm_sub_epi16(smoothWeight, similar);
+
+                fillLo = _mm_add_epi32(fillLo, _mm_unpacklo_epi16(n, zero));
+                fillHi = _mm_add_epi32(fillHi, _mm_unpackhi_epi16(n, zero));
+                fillWeight = _mm_sub_epi16(fillWeight, valid);
+
+                // Unsigned minimum and maximum via the signed ones, with
+                // invalid samples not contributing to the minimum.
+                const auto nb = _mm_xor_si128(_mm_or_si128(n,
+                    _mm_andnot_si128(valid, ones)), bias);
+                lo = _mm_xor_si128(_mm_min_epi16(_mm_xor_si128(lo, bias), nb),
+                    bias);
+                hi = _mm_xor_si128(_mm_max_epi16(_mm_xor_si128(hi, bias),
+                    _mm_xor_si128(n, bias)), bias);
+            }
+
+            // Valid samples.
+            const auto smoothed = DivideSse2(smoothLo, smoothHi,
+                _mm_add_epi16(smoothWeight, _mm_add_epi16(one, one)));
+            const auto flying = _mm_and_si128(_mm_cmpeq_epi16(smoothWeight,
+                zero), smoothMask);
+            const auto valid = _mm_andnot_si128(flying, smoothed);
+
+            // Holes.
+            const auto filled = DivideSse2(fillLo, fillHi, fillWeight);
+            const auto tlo = _mm_adds_epu16(_mm_mulhi_epu16(lo, relT), minT);
+            const auto fillable = _mm_and_si128(_mm_and_si128(
+                _mm_cmpgt_epi16(fillWeight, one),
+                _mm_cmpeq_epi16(_mm_subs_epu16(_mm_subs_epu16(hi, lo), tlo),
+                    zero)),
+                fillMask);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                _mm_or_si128(_mm_andnot_si128(hole, valid),
+                _mm_and_si128(hole, _mm_and_si128(fillable, filled))));
+        }
+
+        for (; i < cnt; ++i) {
+            dst[i] = SpatialPixel(row[i],
+                above[i],
+                below[i],
+                row[i - 1],
+                (i + 1 < cnt) ? row[i + 1] : 0,
+                threshold,
+                minThreshold,
+                smooth,
+                fill);
+        }
+    }
+
+    /*
+     * ::TemporalSse2
+     */
+    void TemporalSse2(uint16 *history,
+            const uint16 *depth,
+            const uint16 threshold,
+            const uint16 minThreshold,
+            const int16 weight,
+            const int32 cnt) {
+        const auto minT = _mm_set1_epi16(static_cast<int16>(minThreshold));
+        const auto relT = _mm_set1_epi16(static_cast<int16>(threshold));
+        const auto w = _mm_set1_epi16(weight);
+        const auto zero = _mm_setzero_si128();
+        int32 i = 0;
+
+        for (; i + 8 <= cnt; i += 8) {
+            auto o = reinterpret_cast<__m128i *>(history + i);
+            const auto h = _mm_loadu_si128(o);
+            const auto d = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(depth + i));
+
+            const auto t = _mm_adds_epu16(_mm_mulhi_epu16(h, relT), minT);
+            const auto diff = _mm_or_si128(_mm_subs_epu16(d, h),
+                _mm_subs_epu16(h, d));
+            const auto replace = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi16(d, zero),
+                    _mm_cmpeq_epi16(h, zero)),
+                _mm_andnot_si128(
+                    _mm_cmpeq_epi16(_mm_subs_epu16(diff, t), zero),
+                    _mm_set1_epi16(-1)));
+
+            // The difference of the samples that are blended is at most
+            // 16383, so twice of it fits into a signed 16-bit integer.
+            const auto blended = _mm_add_epi16(h, _mm_mulhi_epi16(
+                _mm_slli_epi16(_mm_sub_epi16(d, h), 1), w));
+
+            _mm_storeu_si128(o, _mm_or_si128(_mm_and_si128(replace, d),
+                _mm_andnot_si128(replace, blended)));
+        }
+
+        TemporalScalar(history + i, depth + i, threshold, minThreshold,
+            weight, cnt - i);
+    }
+
+    /*
+     * ::UnprojectSse2
+     */
+    void UnprojectSse2(float *dst,
+            const uint16 *depth,
+            const float *rayX,
+            const float *rayY,
+            const int32 cnt) {
+        const auto scale = _mm_set1_ps(0.1f);
+        const auto sign = _mm_set1_ps(-0.0f);
+        const auto zero = _mm_setzero_si128();
+        int32 i = 0;
+
+        for (; i + 4 <= cnt; i += 4) {
+            const auto d = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64(
+                reinterpret_cast<const __m128i *>(depth + i)), zero));
+            const auto x = _mm_mul_ps(d, scale);
+            const auto y = _mm_mul_ps(_mm_mul_ps(d, _mm_loadu_ps(rayX + i)),
+                scale);
+            const auto z = _mm_xor_ps(_mm_mul_ps(_mm_mul_ps(d,
+                _mm_loadu_ps(rayY + i)), scale), sign);
+
+            // Interleave the components of the four points into the
+            // sequence x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3.
+            const auto xyLo = _mm_unpacklo_ps(x, y);
+            const auto xyHi = _mm_unpackhi_ps(x, y);
+            const auto t0 = _mm_shuffle_ps(z, xyLo, _MM_SHUFFLE(2, 2, 0, 0));
+            const auto t1 = _mm_shuffle_ps(xyLo, z, _MM_SHUFFLE(1, 1, 3, 3));
+            const auto t2 = _mm_shuffle_ps(xyHi, z, _MM_SHUFFLE(3, 2, 3, 2));
+
+            auto o = dst + 3 * i;
+            _mm_storeu_ps(o, _mm_shuffle_ps(xyLo, t0, _MM_SHUFFLE(2, 0, 1, 0)));
+            _mm_storeu_ps(o + 4, _mm_shuffle_ps(t1, xyHi,
+                _MM_SHUFFLE(1, 0, 2, 0)));
+            _mm_storeu_ps(o + 8, _mm_shuffle_ps(t2, t2,
+                _MM_SHUFFLE(3, 1, 0, 2)));
+        }
+
+        UnprojectScalar(dst + 3 * i, depth + i, rayX + i, rayY + i, cnt - i);
+    }
+
+    /*
+     * ::Expand16Sse2
+     */
+    void Expand16Sse2(uint8 *dst, const uint16 *src, const int32 cnt) {
+        const auto alpha = _mm_set1_epi16(static_cast<int16>(0xFF00));
+        const auto invalid = _mm_set1_epi16(0x00FF);
+        const auto zero = _mm_setzero_si128();
+        int32 i = 0;
+
+        for (; i + 8 <= cnt; i += 8) {
+            // 'ba' holds the blue and alpha bytes of eight texels, which we
+            // interleave with the samples that form the red and green bytes.
+            const auto s = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(src + i));
+            const auto ba = _mm_or_si128(alpha,
+                _mm_and_si128(_mm_cmpeq_epi16(s, zero), invalid));
+            auto d = reinterpret_cast<__m128i *>(dst + 4 * i);
+            _mm_storeu_si128(d, _mm_unpacklo_epi16(s, ba));
+            _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(s, ba));
+        }
+
+        Expand16Scalar(dst + 4 * i, src + i, cnt - i);
+    }
+
+    /*
+     * ::Pack16Sse2
+     */
+    void Pack16Sse2(uint16 *dst,
+            const uint16 *depth,
+            const uint16 *infrared,
+            const uint8 *bodyIndex,
+            const int32 cnt) {
+        const auto background = _mm_set1_epi16(0x00FF);
+        const auto zero = _mm_setzero_si128();
+        int32 i = 0;
+
+        for (; i + 8 <= cnt; i += 8) {
+            const auto d = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(depth + i));
+            const auto r = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(infrared + i));
+            const auto b = (bodyIndex != nullptr)
+                ? _mm_unpacklo_epi8(_mm_loadl_epi64(
+                    reinterpret_cast<const __m128i *>(bodyIndex + i)), zero)
+                : background;
+
+            // Interleave the pairs of (depth, infrared) and (body index,
+            // alpha) and then the pairs thereof into whole texels.
+            const auto drLo = _mm_unpacklo_epi16(d, r);
+            const auto drHi = _mm_unpackhi_epi16(d, r);
+            const auto baLo = _mm_unpacklo_epi16(b, zero);
+            const auto baHi = _mm_unpackhi_epi16(b, zero);
+
+            auto o = reinterpret_cast<__m128i *>(dst + 4 * i);
+            _mm_storeu_si128(o, _mm_unpacklo_epi32(drLo, baLo));
+            _mm_storeu_si128(o + 1, _mm_unpackhi_epi32(drLo, baLo));
+            _mm_storeu_si128(o + 2, _mm_unpacklo_epi32(drHi, baHi));
+            _mm_storeu_si128(o + 3, _mm_unpackhi_epi32(drHi, baHi));
+        }
+
+        Pack16Scalar(dst + 4 * i,
+            depth + i,
+            infrared + i,
+            (bodyIndex != nullptr) ? bodyIndex + i : nullptr,
+            cnt - i);
+    }
+
+    /*
+     * ::Expand16Avx2
+     */
+    AZUREKINECT_TARGET_AVX2 void Expand16Avx2(uint8 *dst,
+            const uint16 *src,
+            const int32 cnt) {
+        const auto alpha = _mm256_set1_epi16(static_cast<int16>(0xFF00));
+        const auto invalid = _mm256_set1_epi16(0x00FF);
+        const auto zero = _mm256_setzero_si256();
+        int32 i = 0;
+
+        for (; i + 16 <= cnt; i += 16) {
+            const auto s = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(src + i));
+            const auto ba = _mm256_or_si256(alpha,
+                _mm256_and_si256(_mm256_cmpeq_epi16(s, zero), invalid));
+
+            // The unpack instructions work within 128-bit lanes, so the
+            // lower and upper halves of the result must be recombined.
+            const auto lo = _mm256_unpacklo_epi16(s, ba);
+            const auto hi = _mm256_unpackhi_epi16(s, ba);
+            auto d = reinterpret_cast<__m256i *>(dst + 4 * i);
+            _mm256_storeu_si256(d, _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(d + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        Expand16Sse2(dst + 4 * i, src + i, cnt - i);
+    }
+
+    /*
+     * ::Lookup8Avx2
+     */
+    AZUREKINECT_TARGET_AVX2 void Lookup8Avx2(uint32 *dst,
+            const uint8 *src,
+            const uint32 *lut,
+            const int32 cnt) {
+        const auto table = reinterpret_cast<const int *>(lut);
+        int32 i = 0;
+
+        for (; i + 8 <= cnt; i += 8) {
+            const auto s = _mm_loadl_epi64(
+                reinterpret_cast<const __m128i *>(src + i));
+            const auto v = _mm256_i32gather_epi32(table,
+                _mm256_cvtepu8_epi32(s),
+                4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+        }
+
+        Lookup8Scalar(dst + i, src + i, lut, cnt - i);
+    }
+#endif /* PLATFORM_CPU_X86_FAMILY */
+
+#if PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+    /*
+     * ::Expand16Neon
+     */
+    void Expand16Neon(uint8 *dst, const uint16 *src, const int32 cnt) {
+        const auto alpha = vdupq_n_u16(0xFF00);
+        const auto invalid = vdupq_n_u16(0x00FF);
+        const auto zero = vdupq_n_u16(0);
+        int32 i = 0;
+
+        for (; i + 8 <= cnt; i += 8) {
+            uint16x8x2_t texels;
+            texels.val[0] = vld1q_u16(src + i);
+            texels.val[1] = vorrq_u16(alpha,
+                vandq_u16(vceqq_u16(texels.val[0], zero), invalid));
+            vst2q_u16(reinterpret_cast<uint16_t *>(dst + 4 * i), texels);
+        }
+
+        Expand16Scalar(dst + 4 * i, src + i, cnt - i);
+    }
+
+    /*
+     * ::Pack16Neon
+     */
+    void Pack16Neon(uint16 *dst,
+            const uint16 *depth,
+            const uint16 *infrared,
+            const uint8 *bodyIndex,
+            const int32 cnt) {
+        const auto background = vdupq_n_u16(0x00FF);
+        int32 i = 0;
+
+        for (; i + 8 <= cnt; i += 8) {
+            uint16x8x4_t texels;
+            texels.val[0] = vld1q_u16(depth + i);
+            texels.val[1] = vld1q_u16(infrared + i);
+            texels.val[2] = (bodyIndex != nullptr)
+                ? vmovl_u8(vld1_u8(bodyIndex + i))
+                : background;
+            texels.val[3] = vdupq_n_u16(0);
+            vst4q_u16(dst + 4 * i, texels);
+        }
+
+        Pack16Scalar(dst + 4 * i,
+            depth + i,
+            infrared + i,
+            (bodyIndex != nullptr) ? bodyIndex + i : nullptr,
+            cnt - i);
+    }
+#endif /* PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON */
+
+} /* namespace */
+
+
+/*
+ * FAzureKinectConversion::GetKernels
+ */
+const FAzureKinectConversion::FKernels& FAzureKinectConversion::GetKernels(
+        void) {
+    static const auto retval = GetSupportedKernels().Last();
+    return retval;
+}
+
+
+/*
+ * FAzureKinectConversion::GetSupportedKernels
+ */
+TArray<FAzureKinectConversion::FKernels>
+FAzureKinectConversion::GetSupportedKernels(void) {
+    TArray<FKernels> retval;
+
+    // There is no gather instruction below AVX2, so the lookup uses the
+    // scalar implementation in the other sets. The packing, the colour
+    // conversions and the reprojection are bound by memory bandwidth or
+    // by the division, so the wider AVX2 registers would not gain anything.
+    retval.Add({ TEXT("Scalar"),
+        &::Expand16Scalar,
+        &::Lookup8Scalar,
+        &::Pack16Scalar,
+        &::Nv12Scalar,
+        &::ReprojectScalar,
+        &::SpatialScalar,
+        &::TemporalScalar,
+        &::UnprojectScalar,
+        &::Yuy2Scalar });
+
+#if PLATFORM_CPU_X86_FAMILY
+    retval.Add({ TEXT("SSE2"),
+        &::Expand16Sse2,
+        &::Lookup8Scalar,
+        &::Pack16Sse2,
+        &::Nv12Sse2,
+        &::ReprojectSse2,
+        &::SpatialSse2,
+        &::TemporalSse2,
+        &::UnprojectSse2,
+        &::Yuy2Sse2 });
+
+    if (FPlatformMisc::HasAVX2InstructionSupport()) {
+        retval.Add({ TEXT("AVX2"),
+            &::Expand16Avx2,
+            &::Lookup8Avx2,
+            &::Pack16Sse2,
+            &::Nv12Sse2,
+            &::ReprojectSse2,
+            &::SpatialSse2,
+            &::TemporalSse2,
+            &::UnprojectSse2,
+            &::Yuy2Sse2 });
+    }
+#endif /* PLATFORM_CPU_X86_FAMILY */
+
+#if PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+    // The colour formats, the registration, the depth filter and the point
+    // cloud are only relevant for the device, which is not supported on ARM,
+    // so they have no NEON implementation.
+    retval.Add({ TEXT("NEON"),
+        &::Expand16Neon,
+        &::Lookup8Scalar,
+        &::Pack16Neon,
+        &::Nv12Scalar,
+        &::ReprojectScalar,
+        &::SpatialScalar,
+        &::TemporalScalar,
+        &::UnprojectScalar,
+        &::Yuy2Scalar });
+#endif /* PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON */
+
+    return retval;
+}
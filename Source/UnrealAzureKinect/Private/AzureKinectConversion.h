@@ -0,0 +1,370 @@
+﻿// <copyright file="AzureKinectConversion.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/// <summary>
+/// Provides the pixel conversion kernels for turning sensor images into
+/// texture data.
+/// </summary>
+/// <remarks>
+/// Each kernel exists as a scalar reference implementation and as vectorised
+/// implementations for the instruction sets available on the target platform.
+/// All implementations produce bit-identical output. The best implementation
+/// supported by the CPU is selected once at runtime.
+/// </remarks>
+class FAzureKinectConversion final {
+
+public:
+
+    /// <summary>
+    /// The signature of a kernel expanding 16-bit samples into RGBA8 texels.
+    /// </summary>
+    typedef void (*Expand16Type)(uint8 *dst,
+        const uint16 *src,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel mapping 8-bit indices to 32-bit values.
+    /// </summary>
+    typedef void (*Lookup8Type)(uint32 *dst,
+        const uint8 *src,
+        const uint32 *lut,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel interleaving depth, infrared and body index
+    /// into RGBA16 texels.
+    /// </summary>
+    typedef void (*Pack16Type)(uint16 *dst,
+        const uint16 *depth,
+        const uint16 *infrared,
+        const uint8 *bodyIndex,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel converting a row of an NV12 image into BGRA8
+    /// texels.
+    /// </summary>
+    typedef void (*Nv12Type)(uint8 *dst,
+        const uint8 *y,
+        const uint8 *uv,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel transforming depth samples along their rays
+    /// into another camera.
+    /// </summary>
+    typedef void (*ReprojectType)(float *x,
+        float *y,
+        float *z,
+        const uint16 *depth,
+        const float *rayX,
+        const float *rayY,
+        const float *transform,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel smoothing a row of a depth image with its
+    /// neighbours and filling its holes.
+    /// </summary>
+    typedef void (*SpatialType)(uint16 *dst,
+        const uint16 *above,
+        const uint16 *row,
+        const uint16 *below,
+        const uint16 threshold,
+        const uint16 minThreshold,
+        const bool smooth,
+        const bool fill,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel blending depth samples into their history.
+    /// </summary>
+    typedef void (*TemporalType)(uint16 *history,
+        const uint16 *depth,
+        const uint16 threshold,
+        const uint16 minThreshold,
+        const int16 weight,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel turning depth samples into points.
+    /// </summary>
+    typedef void (*UnprojectType)(float *dst,
+        const uint16 *depth,
+        const float *rayX,
+        const float *rayY,
+        const int32 cnt);
+
+    /// <summary>
+    /// The signature of a kernel converting a row of a YUY2 image into BGRA8
+    /// texels.
+    /// </summary>
+    typedef void (*Yuy2Type)(uint8 *dst,
+        const uint8 *src,
+        const int32 cnt);
+
+    /// <summary>
+    /// A set of kernels using the same instruction set.
+    /// </summary>
+    struct FKernels {
+        const TCHAR *Name;
+        Expand16Type Expand16;
+        Lookup8Type Lookup8;
+        Pack16Type Pack16;
+        Nv12Type Nv12;
+        ReprojectType Reproject;
+        SpatialType Spatial;
+        TemporalType Temporal;
+        UnprojectType Unproject;
+        Yuy2Type Yuy2;
+    };
+
+    /// <summary>
+    /// Expands 16-bit depth or infrared samples into RGBA8 texels using the
+    /// fastest kernel available.
+    /// </summary>
+    /// <remarks>
+    /// The red channel receives the low byte and the green channel the high
+    /// byte of the sample. The blue channel is 0xFF for invalid, i.e. zero,
+    /// samples and zero otherwise. Alpha is always 0xFF.
+    /// </remarks>
+    /// <param name="dst">The output buffer, which must be able to hold
+    /// <paramref name="cnt" /> * 4 bytes.</param>
+    /// <param name="src">The samples to be converted.</param>
+    /// <param name="cnt">The number of samples.</param>
+    static inline void Expand16(uint8 *dst,
+            const uint16 *src,
+            const int32 cnt) {
+        GetKernels().Expand16(dst, src, cnt);
+    }
+
+    /// <summary>
+    /// Replaces each 8-bit index with the 32-bit value from the given lookup
+    /// table using the fastest kernel available.
+    /// </summary>
+    /// <param name="dst">The output buffer, which must be able to hold
+    /// <paramref name="cnt" /> values.</param>
+    /// <param name="src">The indices to be converted.</param>
+    /// <param name="lut">The lookup table, which must hold 256
+    /// entries.</param>
+    /// <param name="cnt">The number of indices.</param>
+    static inline void Lookup8(uint32 *dst,
+            const uint8 *src,
+            const uint32 *lut,
+            const int32 cnt) {
+        GetKernels().Lookup8(dst, src, lut, cnt);
+    }
+
+    /// <summary>
+    /// Interleaves depth, infrared and body index samples into RGBA16 texels
+    /// using the fastest kernel available.
+    /// </summary>
+    /// <remarks>
+    /// Red receives the depth, green the infrared sample and blue the body
+    /// index. Alpha is always zero.
+    /// </remarks>
+    /// <param name="dst">The output buffer, which must be able to hold
+    /// <paramref name="cnt" /> * 4 values.</param>
+    /// <param name="depth">The depth samples.</param>
+    /// <param name="infrared">The infrared samples.</param>
+    /// <param name="bodyIndex">The body indices, or <c>nullptr</c> if
+    /// there is no body index map, in which case the blue channel is set to
+    /// 255, i.e. K4ABT_BODY_INDEX_MAP_BACKGROUND.</param>
+    /// <param name="cnt">The number of pixels.</param>
+    static inline void Pack16(uint16 *dst,
+            const uint16 *depth,
+            const uint16 *infrared,
+            const uint8 *bodyIndex,
+            const int32 cnt) {
+        GetKernels().Pack16(dst, depth, infrared, bodyIndex, cnt);
+    }
+
+    /// <summary>
+    /// Converts a row of an NV12 image into BGRA8 texels using the fastest
+    /// kernel available.
+    /// </summary>
+    /// <remarks>
+    /// The conversion uses the BT.601 coefficients for limited-range
+    /// YCbCr in 6-bit fixed-point precision.
+    /// </remarks>
+    /// <param name="dst">The output buffer, which must be able to hold
+    /// <paramref name="cnt" /> * 4 bytes.</param>
+    /// <param name="y">The luma samples of the row.</param>
+    /// <param name="uv">The interleaved chroma samples shared by the row,
+    /// one pair for two pixels.</param>
+    /// <param name="cnt">The number of pixels in the row.</param>
+    static inline void Nv12(uint8 *dst,
+            const uint8 *y,
+            const uint8 *uv,
+            const int32 cnt) {
+        GetKernels().Nv12(dst, y, uv, cnt);
+    }
+
+    /// <summary>
+    /// Transforms the points given by depth samples and their rays into
+    /// another camera using the fastest kernel available.
+    /// </summary>
+    /// <remarks>
+    /// For each sample d with ray (rx, ry), the point d * (rx, ry, 1) is
+    /// transformed by the 3x4 matrix and the result (tx, ty, tz) is stored
+    /// as (tx / tz, ty / tz, tz), i.e. as normalised image coordinates and
+    /// depth in the target camera. The depth is zero for invalid samples.
+    /// Rays that cannot be unprojected should be NaN, which yields NaN.
+    /// </remarks>
+    /// <param name="x">Receives the normalised x-coordinates.</param>
+    /// <param name="y">Receives the normalised y-coordinates.</param>
+    /// <param name="z">Receives the depth in the target camera.</param>
+    /// <param name="depth">The depth samples.</param>
+    /// <param name="rayX">The x-components of the rays at z = 1.</param>
+    /// <param name="rayY">The y-components of the rays at z = 1.</param>
+    /// <param name="transform">The row-major 3x4 matrix of the rotation and
+    /// translation into the target camera.</param>
+    /// <param name="cnt">The number of samples.</param>
+    static inline void Reproject(float *x,
+            float *y,
+            float *z,
+            const uint16 *depth,
+            const float *rayX,
+            const float *rayY,
+            const float *transform,
+            const int32 cnt) {
+        GetKernels().Reproject(x, y, z, depth, rayX, rayY, transform, cnt);
+    }
+
+    /// <summary>
+    /// Smoothes a row of a depth image with its four neighbours while
+    /// preserving edges and fills holes using the fastest kernel available.
+    /// </summary>
+    /// <remarks>
+    /// <para>The threshold t(d) of a depth d is
+    /// <c>((d * threshold) &gt;&gt; 16) + minThreshold</c>. If smoothing is
+    /// enabled, a valid sample d becomes the weighted mean of twice itself
+    /// and all valid neighbours that differ by at most t(d). Samples without
+    /// any such neighbour are considered flying pixels and set to zero.
+    /// </para>
+    /// <para>If filling is enabled, an invalid sample becomes the mean of
+    /// its valid neighbours if there are at least two and if they span at
+    /// most t(m) of their minimum m. Otherwise, it remains zero.</para>
+    /// <para>All means are rounded to the nearest integer. The thresholds
+    /// must not exceed 8192, which limits t(d) to the range of a signed
+    /// 16-bit integer.</para>
+    /// </remarks>
+    /// <param name="dst">The output row, which must not alias the
+    /// input.</param>
+    /// <param name="above">The row above, or a row of zeros at the top of the
+    /// image.</param>
+    /// <param name="row">The row to be filtered.</param>
+    /// <param name="below">The row below, or a row of zeros at the bottom of
+    /// the image.</param>
+    /// <param name="threshold">The relative threshold in 1/65536.</param>
+    /// <param name="minThreshold">The absolute part of the threshold in
+    /// millimetres.</param>
+    /// <param name="smooth">Enables the smoothing of valid samples.</param>
+    /// <param name="fill">Enables the filling of holes.</param>
+    /// <param name="cnt">The number of samples in the row.</param>
+    static inline void Spatial(uint16 *dst,
+            const uint16 *above,
+            const uint16 *row,
+            const uint16 *below,
+            const uint16 threshold,
+            const uint16 minThreshold,
+            const bool smooth,
+            const bool fill,
+            const int32 cnt) {
+        GetKernels().Spatial(dst, above, row, below, threshold, minThreshold,
+            smooth, fill, cnt);
+    }
+
+    /// <summary>
+    /// Blends depth samples into their exponentially smoothed history using
+    /// the fastest kernel available.
+    /// </summary>
+    /// <remarks>
+    /// If the sample or its history is invalid, or if they differ by more
+    /// than t(h) = <c>((h * threshold) &gt;&gt; 16) + minThreshold</c> of the
+    /// history h, which indicates motion, the history is replaced by the
+    /// sample. Otherwise, it moves towards the sample by
+    /// <c>((2 * (d - h) * weight) &gt;&gt; 16)</c>, i.e. by the share
+    /// weight / 32768 of the difference. The thresholds must not exceed
+    /// 8192.
+    /// </remarks>
+    /// <param name="history">The history, which is updated in place.</param>
+    /// <param name="depth">The new depth samples.</param>
+    /// <param name="threshold">The relative motion threshold in
+    /// 1/65536.</param>
+    /// <param name="minThreshold">The absolute part of the motion threshold
+    /// in millimetres.</param>
+    /// <param name="weight">The weight of new samples in 1/32768.</param>
+    /// <param name="cnt">The number of samples.</param>
+    static inline void Temporal(uint16 *history,
+            const uint16 *depth,
+            const uint16 threshold,
+            const uint16 minThreshold,
+            const int16 weight,
+            const int32 cnt) {
+        GetKernels().Temporal(history, depth, threshold, minThreshold, weight,
+            cnt);
+    }
+
+    /// <summary>
+    /// Turns depth samples into points in the coordinate system of Unreal
+    /// using the fastest kernel available.
+    /// </summary>
+    /// <remarks>
+    /// The sample d with ray (rx, ry) yields the point (d, d * rx, -d * ry)
+    /// scaled from millimetres to centimetres, which matches the axes used
+    /// for the joints of the skeletons. Invalid samples yield the origin,
+    /// rays that cannot be unprojected yield NaN.
+    /// </remarks>
+    /// <param name="dst">The output buffer, which must be able to hold
+    /// <paramref name="cnt" /> * 3 values.</param>
+    /// <param name="depth">The depth samples.</param>
+    /// <param name="rayX">The x-components of the rays at z = 1.</param>
+    /// <param name="rayY">The y-components of the rays at z = 1.</param>
+    /// <param name="cnt">The number of samples.</param>
+    static inline void Unproject(float *dst,
+            const uint16 *depth,
+            const float *rayX,
+            const float *rayY,
+            const int32 cnt) {
+        GetKernels().Unproject(dst, depth, rayX, rayY, cnt);
+    }
+
+    /// <summary>
+    /// Converts a row of a YUY2 image into BGRA8 texels using the fastest
+    /// kernel available.
+    /// </summary>
+    /// <remarks>
+    /// The conversion is the same as for <see cref="Nv12" />.
+    /// </remarks>
+    /// <param name="dst">The output buffer, which must be able to hold
+    /// <paramref name="cnt" /> * 4 bytes.</param>
+    /// <param name="src">The row in the order Y0, U, Y1, V.</param>
+    /// <param name="cnt">The number of pixels in the row.</param>
+    static inline void Yuy2(uint8 *dst,
+            const uint8 *src,
+            const int32 cnt) {
+        GetKernels().Yuy2(dst, src, cnt);
+    }
+
+    /// <summary>
+    /// Answer the fastest kernels supported by the CPU.
+    /// </summary>
+    static const FKernels& GetKernels(void);
+
+    /// <summary>
+    /// Answer all kernels supported by the CPU, starting with the scalar
+    /// reference implementation.
+    /// </summary>
+    static TArray<FKernels> GetSupportedKernels(void);
+
+    FAzureKinectConversion(void) = delete;
+};
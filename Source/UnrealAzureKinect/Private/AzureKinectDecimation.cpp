@@ -0,0 +1,255 @@
+﻿// <copyright file="AzureKinectDecimation.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectDecimation.h"
+
+#include <cassert>
+
+
+namespace {
+
+    /// <summary>
+    /// The marker of an empty slot in the hash table, which cannot be a
+    /// valid key as these only use 63 bits.
+    /// </summary>
+    constexpr uint64 EmptyKey = ~static_cast<uint64>(0);
+
+    /// <summary>
+    /// If a point cloud falls below this share of the target number of
+    /// points, the voxel size is reduced for the next frame.
+    /// </summary>
+    constexpr float ShrinkThreshold = 0.75f;
+
+    /// <summary>
+    /// The share of the target number of points the voxel size is adapted
+    /// to, which leaves room for the noise between frames.
+    /// </summary>
+    constexpr float TargetShare = 0.9f;
+
+    /*
+     * ::MakeKey
+     */
+    inline uint64 MakeKey(const FVector3f& position, const float scale) {
+        // 21 bits per axis cover about 2 km at the smallest voxel size of
+        // 1 mm, which is far beyond the range of the sensor.
+        constexpr uint64 mask = (static_cast<uint64>(1) << 21) - 1;
+        const auto x = static_cast<uint64>(FMath::FloorToInt32(
+            position.X * scale));
+        const auto y = static_cast<uint64>(FMath::FloorToInt32(
+            position.Y * scale));
+        const auto z = static_cast<uint64>(FMath::FloorToInt32(
+            position.Z * scale));
+        return ((x & mask) << 42) | ((y & mask) << 21) | (z & mask);
+    }
+
+} /* namespace */
+
+
+/*
+ * FAzureKinectDecimation::FAzureKinectDecimation
+ */
+FAzureKinectDecimation::FAzureKinectDecimation(void) : _voxelSize(0.0f) { }
+
+
+/*
+ * FAzureKinectDecimation::Decimate
+ */
+int32 FAzureKinectDecimation::Decimate(FAzureKinectPointCloud& cloud,
+        const float voxelSize,
+        const int32 targetPoints,
+        const bool average) {
+    assert(cloud.Colours.IsEmpty()
+        || (cloud.Colours.Num() == cloud.Positions.Num()));
+    auto positions = cloud.Positions.GetData();
+    auto colours = cloud.Colours.IsEmpty() ? nullptr : cloud.Colours.GetData();
+    auto retval = cloud.Positions.Num();
+
+    if (targetPoints <= 0) {
+        // Decimate with the fixed voxel size if there is one.
+        if (voxelSize > 0.0f) {
+            retval = this->Grid(positions, colours, retval, voxelSize,
+                average);
+            this->_voxelSize = voxelSize;
+        } else {
+            this->_voxelSize = 0.0f;
+        }
+
+    } else if ((retval > targetPoints) || (voxelSize > 0.0f)) {
+        const auto minSize = FMath::Max(voxelSize, MinVoxelSize);
+        auto size = FMath::Max(this->_voxelSize, minSize);
+
+        for (int32 p = 0; p < MaxPasses; ++p) {
+            const auto cnt = this->Grid(positions, colours, retval, size,
+                average);
+            const auto ratio = static_cast<float>(cnt) / targetPoints;
+            retval = cnt;
+
+            if (ratio <= 1.0f) {
+                // The points lie on surfaces, so their number is roughly
+                // inversely proportional to the square of the voxel size.
+                // If we have far less points than requested, start the next
+                // frame with the voxel size that would have met the target.
+                // After multiple passes, the count is lower than a single
+                // pass with the final size would yield, so it is kept.
+                if ((p == 0) && (ratio < ShrinkThreshold)) {
+                    size = FMath::Max(minSize, size * FMath::Sqrt(
+                        FMath::Max(ratio, 0.01f) / TargetShare));
+                }
+                break;
+            }
+
+            // Overshoot the estimate a bit, because the next pass can only
+            // merge the voxels retained in this one.
+            size *= FMath::Sqrt(ratio / TargetShare);
+        }
+
+        // If the passes did not meet the target, e.g. because the points lie
+        // on thin structures rather than surfaces, thin out the rest with a
+        // regular stride, which keeps the points spread over the whole
+        // cloud. As the stride is at least one, the points can be moved in
+        // place.
+        if (retval > targetPoints) {
+            for (int32 i = 0; i < targetPoints; ++i) {
+                const auto j = static_cast<int32>(static_cast<int64>(i)
+                    * retval / targetPoints);
+                positions[i] = positions[j];
+                if (colours != nullptr) {
+                    colours[i] = colours[j];
+                }
+            }
+
+            retval = targetPoints;
+        }
+
+        this->_voxelSize = size;
+    }
+
+    cloud.Positions.SetNum(retval, EAllowShrinking::No);
+    if (colours != nullptr) {
+        cloud.Colours.SetNum(retval, EAllowShrinking::No);
+    }
+
+    return retval;
+}
+
+
+/*
+ * FAzureKinectDecimation::Reset
+ */
+void FAzureKinectDecimation::Reset(void) {
+    this->_colourSums.Empty();
+    this->_counts.Empty();
+    this->_keys.Empty();
+    this->_slots.Empty();
+    this->_sums.Empty();
+    this->_voxelSize = 0.0f;
+}
+
+
+/*
+ * FAzureKinectDecimation::Grid
+ */
+int32 FAzureKinectDecimation::Grid(FVector3f *positions,
+        FColor *colours,
+        const int32 cnt,
+        const float voxelSize,
+        const bool average) {
+    assert(positions != nullptr);
+    assert(voxelSize > 0.0f);
+
+    // Keep the load factor of the table below one half, which keeps the
+    // linear probing short.
+    const auto capacity = FMath::Max(static_cast<int32>(
+        FMath::RoundUpToPowerOfTwo(2 * cnt)), 16);
+    const auto mask = static_cast<uint64>(capacity - 1);
+    const auto shift = 64 - FMath::FloorLog2(capacity);
+    const auto scale = 1.0f / voxelSize;
+
+    this->_keys.SetNumUninitialized(capacity, EAllowShrinking::No);
+    this->_slots.SetNumUninitialized(capacity, EAllowShrinking::No);
+    FMemory::Memset(this->_keys.GetData(), 0xFF,
+        capacity * sizeof(uint64));
+
+    if (average) {
+        this->_counts.SetNumUninitialized(cnt, EAllowShrinking::No);
+        this->_sums.SetNumUninitialized(cnt, EAllowShrinking::No);
+        if (colours != nullptr) {
+            this->_colourSums.SetNumUninitialized(4 * cnt,
+                EAllowShrinking::No);
+        }
+    }
+
+    auto keys = this->_keys.GetData();
+    auto slots = this->_slots.GetData();
+    auto counts = this->_counts.GetData();
+    auto sums = this->_sums.GetData();
+    auto colourSums = this->_colourSums.GetData();
+    int32 retval = 0;
+
+    for (int32 i = 0; i < cnt; ++i) {
+        const auto key = MakeKey(positions[i], scale);
+        auto h = (key * 0x9E3779B97F4A7C15ull) >> shift;
+        while ((keys[h] != EmptyKey) && (keys[h] != key)) {
+            h = (h + 1) & mask;
+        }
+
+        if (keys[h] == EmptyKey) {
+            // This is the first point in the voxel. As a voxel is never
+            // created after the point being processed, the output can be
+            // written in place.
+            const auto slot = retval++;
+            keys[h] = key;
+            slots[h] = slot;
+
+            if (average) {
+                counts[slot] = 1;
+                sums[slot] = positions[i];
+                if (colours != nullptr) {
+                    auto c = colourSums + 4 * slot;
+                    c[0] = colours[i].B;
+                    c[1] = colours[i].G;
+                    c[2] = colours[i].R;
+                    c[3] = colours[i].A;
+                }
+
+            } else {
+                positions[slot] = positions[i];
+                if (colours != nullptr) {
+                    colours[slot] = colours[i];
+                }
+            }
+
+        } else if (average) {
+            const auto slot = slots[h];
+            ++counts[slot];
+            sums[slot] += positions[i];
+            if (colours != nullptr) {
+                auto c = colourSums + 4 * slot;
+                c[0] += colours[i].B;
+                c[1] += colours[i].G;
+                c[2] += colours[i].R;
+                c[3] += colours[i].A;
+            }
+        }
+    }
+
+    if (average) {
+        for (int32 s = 0; s < retval; ++s) {
+            const auto n = counts[s];
+            positions[s] = sums[s] / static_cast<float>(n);
+            if (colours != nullptr) {
+                // Round to the nearest value.
+                const auto c = colourSums + 4 * s;
+                colours[s].B = static_cast<uint8>((c[0] + n / 2) / n);
+                colours[s].G = static_cast<uint8>((c[1] + n / 2) / n);
+                colours[s].R = static_cast<uint8>((c[2] + n / 2) / n);
+                colours[s].A = static_cast<uint8>((c[3] + n / 2) / n);
+            }
+        }
+    }
+
+    return retval;
+}
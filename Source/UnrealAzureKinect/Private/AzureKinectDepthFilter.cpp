@@ -0,0 +1,130 @@
+﻿// <copyright file="AzureKinectDepthFilter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectDepthFilter.h"
+
+#include <cassert>
+
+#include "AzureKinectConversion.h"
+
+
+namespace {
+
+    /// <summary>
+    /// The largest threshold the kernels support, which keeps the sum of
+    /// both parts within the range of a signed 16-bit integer.
+    /// </summary>
+    constexpr int32 MaxThreshold = 8192;
+
+    /*
+     * ::ToRelative
+     */
+    inline uint16 ToRelative(const float threshold) {
+        return static_cast<uint16>(FMath::Clamp(
+            FMath::RoundToInt32(threshold * 65536.0f), 0, MaxThreshold));
+    }
+
+} /* namespace */
+
+
+/*
+ * FAzureKinectDepthFilter::FAzureKinectDepthFilter
+ */
+FAzureKinectDepthFilter::FAzureKinectDepthFilter(void) { }
+
+
+/*
+ * FAzureKinectDepthFilter::Apply
+ */
+void FAzureKinectDepthFilter::Apply(uint16 *dst,
+        const uint16 *src,
+        const int32 width,
+        const int32 height,
+        const FAzureKinectDepthFilterSettings& settings,
+        FAzureKinectWorkerPool& workers,
+        const int32 tileRows) {
+    assert(dst != nullptr);
+    assert(src != nullptr);
+    assert(dst != src);
+    const auto cnt = width * height;
+    const auto edge = ToRelative(settings.EdgeThreshold);
+    const auto fill = settings.FillHoles;
+    const auto minThreshold = static_cast<uint16>(FMath::Clamp(
+        settings.MinThreshold, 0, MaxThreshold));
+    const auto motion = ToRelative(settings.MotionThreshold);
+    const auto smooth = settings.SpatialSmoothing;
+    const auto weight = static_cast<int16>(FMath::Clamp(FMath::RoundToInt32(
+        (1.0f - settings.TemporalSmoothing) * 32768.0f), 1, 32767));
+    const auto temporal = (settings.TemporalSmoothing > 0.0f);
+
+    // The spatial stage reads the output of the temporal one, which is the
+    // history if it is enabled.
+    auto input = src;
+
+    if (temporal) {
+        if (this->_history.Num() != cnt) {
+            // Restart from the current frame, which is what the kernel would
+            // do anyway for a history of zeros.
+            this->_history.SetNumUninitialized(cnt);
+            FMemory::Memcpy(this->_history.GetData(), src,
+                cnt * sizeof(uint16));
+        } else {
+            auto history = this->_history.GetData();
+            workers.ParallelForTiles(height, tileRows,
+                    [history, src, width, motion, minThreshold, weight](
+                    const int32 b, const int32 e) {
+                const auto offset = b * width;
+                FAzureKinectConversion::Temporal(history + offset,
+                    src + offset,
+                    motion,
+                    minThreshold,
+                    weight,
+                    (e - b) * width);
+            });
+        }
+
+        input = this->_history.GetData();
+
+    } else {
+        // Do not resume from a stale history once re-enabled.
+        this->_history.Empty();
+    }
+
+    if (!smooth && !fill) {
+        FMemory::Memcpy(dst, input, cnt * sizeof(uint16));
+        return;
+    }
+
+    if (this->_zeros.Num() < width) {
+        this->_zeros.SetNumZeroed(width);
+    }
+
+    const auto zeros = this->_zeros.GetData();
+    workers.ParallelForTiles(height, tileRows,
+            [dst, input, zeros, width, height, edge, minThreshold, smooth,
+            fill](const int32 b, const int32 e) {
+        for (int32 r = b; r < e; ++r) {
+            const auto row = input + r * width;
+            FAzureKinectConversion::Spatial(dst + r * width,
+                (r > 0) ? row - width : zeros,
+                row,
+                (r + 1 < height) ? row + width : zeros,
+                edge,
+                minThreshold,
+                smooth,
+                fill,
+                width);
+        }
+    });
+}
+
+
+/*
+ * FAzureKinectDepthFilter::Reset
+ */
+void FAzureKinectDepthFilter::Reset(void) {
+    this->_history.Empty();
+}
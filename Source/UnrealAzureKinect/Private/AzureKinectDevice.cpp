@@ -34,12 +34,17 @@
 
 #include "Runtime/RHI/Public/RHI.h"
 
+#include "AzureKinectConversion.h"
 #include "AzureKinectDeviceThread.h"
 
 
 DEFINE_LOG_CATEGORY(AzureKinectDeviceLog);
 
 
+static_assert(FAzureKinectSkeletonData::JointCount == K4ABT_JOINT_COUNT,
+    "The skeletons must hold all joints of the body tracker.");
+
+
 /*
  * UAzureKinectDevice::CountDevices
  */
@@ -48,25 +53,73 @@ int32 UAzureKinectDevice::CountDevices(void) {
 }
 
 
+/*
+ * UAzureKinectDevice::GetHostTime
+ */
+double UAzureKinectDevice::GetHostTime(void) {
+    return FPlatformTime::Seconds();
+}
+
+
 /*
  * UAzureKinectDevice::UAzureKinectDevice
  */
 UAzureKinectDevice::UAzureKinectDevice(void)
-        : BodyIndexTexture(nullptr),
+        : BodyIndexMode(EKinectBodyIndexMode::GREYSCALE),
+        BodyIndexPalette(GetDefaultBodyIndexPalette()),
+        BodyIndexTexture(nullptr),
+        ColourDecoderThreads(2),
+        ColourFormat(EKinectColourFormat::BGRA32),
         ColourResolution(EKinectColourResolution::RESOLUTION_720P),
         ColourTexture(nullptr),
+        ConversionQueueDepth(2),
+        ConversionTileRows(64),
         DepthMode(EKinectDepthMode::NFOV_UNBINNED),
         DepthTexture(nullptr),
         DeviceIndex(-1),
         DisableStreamingIndicator(false),
         FrameRate(EKinectFps::PER_SECOND_30),
+        GeneratePointCloud(false),
         InfraredTexture(nullptr),
+        JointConfidenceThreshold(EKinectJointConfidence::MEDIUM),
+        LowConfidencePolicy(EKinectJointPolicy::KEEP),
+        MaxExtrapolation(50.0f),
+        MaxInFlightUploads(2),
+        PointCloudAveraging(false),
+        PointCloudColours(false),
+        PointCloudMaxPoints(0),
+        PointCloudVoxelSize(0.0f),
         Remapping(EKinectRemap::DEPTH_TO_COLOUR),
         SensorOrientation(EKinectSensorOrientation::DEFAULT),
+        SensorTexture(nullptr),
+        SensorTextureFormat(EKinectSensorTextureFormat::RGBA8),
         SkeletonTracking(EKinectTrackerProcessing::DISABLED),
         SynchronisedImagesOnly(false),
-        _cntTrackedSkeletons(0),
-        _thread(nullptr) {
+        SynchronisedTextures(false),
+        TrackerQueuePolicy(EKinectQueuePolicy::DROP_OLDEST),
+        TrackingQueueDepth(2),
+        WorkerAffinityMask(0),
+        WorkerThreads(0),
+        _bodyIndexPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _captureThread(nullptr),
+        _colourPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _colourRemapPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _conversionThread(nullptr),
+        _depthFilterPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _depthPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _depthRemapPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _frameSequence(-1),
+        _framesPerSecond(0),
+        _gpuBuffers(MakeShared<FAzureKinectGpuBuffers, ESPMode::ThreadSafe>()),
+        _infraredPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _pointCloudSequence(0),
+        _sensorPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _skeletonSequence(0),
+        _systemTimeOffset(0.0),
+        _texturesFromTracker(false),
+        _trackingThread(nullptr),
+        _trackerResultThread(nullptr),
+        _uploader(MakeShared<FAzureKinectTextureUploader, ESPMode::ThreadSafe>()) {
     this->RefreshDevices();
 }
 
@@ -76,22 +129,291 @@ UAzureKinectDevice::UAzureKinectDevice(void)
  */
 UAzureKinectDevice::UAzureKinectDevice(const FObjectInitializer& initialiser)
         : Super(initialiser),
-        _cntTrackedSkeletons(0),
-        _thread(nullptr) {
+        BodyIndexMode(EKinectBodyIndexMode::GREYSCALE),
+        BodyIndexPalette(GetDefaultBodyIndexPalette()),
+        ColourDecoderThreads(2),
+        ColourFormat(EKinectColourFormat::BGRA32),
+        ConversionQueueDepth(2),
+        ConversionTileRows(64),
+        JointConfidenceThreshold(EKinectJointConfidence::MEDIUM),
+        LowConfidencePolicy(EKinectJointPolicy::KEEP),
+        MaxExtrapolation(50.0f),
+        MaxInFlightUploads(2),
+        PointCloudAveraging(false),
+        PointCloudColours(false),
+        PointCloudMaxPoints(0),
+        PointCloudVoxelSize(0.0f),
+        SynchronisedTextures(false),
+        TrackerQueuePolicy(EKinectQueuePolicy::DROP_OLDEST),
+        TrackingQueueDepth(2),
+        WorkerAffinityMask(0),
+        WorkerThreads(0),
+        _bodyIndexPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _captureThread(nullptr),
+        _colourPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _colourRemapPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _conversionThread(nullptr),
+        _depthFilterPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _depthPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _depthRemapPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _frameSequence(-1),
+        _framesPerSecond(0),
+        _gpuBuffers(MakeShared<FAzureKinectGpuBuffers, ESPMode::ThreadSafe>()),
+        _infraredPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _pointCloudSequence(0),
+        _sensorPool(MakeShared<FAzureKinectBufferPool, ESPMode::ThreadSafe>()),
+        _skeletonSequence(0),
+        _systemTimeOffset(0.0),
+        _texturesFromTracker(false),
+        _trackingThread(nullptr),
+        _trackerResultThread(nullptr),
+        _uploader(MakeShared<FAzureKinectTextureUploader, ESPMode::ThreadSafe>()) {
     this->RefreshDevices();
 }
 
 
+/*
+ * UAzureKinectDevice::CopySkeletons
+ */
+int32 UAzureKinectDevice::CopySkeletons(
+        TArray<FAzureKinectSkeletonData>& dst) const {
+    const auto snapshot = this->_skeletons.Acquire();
+    dst.Reset();
+
+    if (snapshot) {
+        dst.Append(snapshot->Skeletons);
+    }
+
+    return dst.Num();
+}
+
+
+/*
+ * UAzureKinectDevice::CopySkeletonsAt
+ */
+int32 UAzureKinectDevice::CopySkeletonsAt(
+        TArray<FAzureKinectSkeletonData>& dst,
+        const double time,
+        FAzureKinectFrameInfo& frameInfo) const {
+    const auto snapshot = this->_skeletons.Acquire();
+    dst.Reset();
+
+    if (!snapshot) {
+        frameInfo = FAzureKinectFrameInfo();
+        return 0;
+    }
+
+    dst.Append(snapshot->Skeletons);
+    frameInfo = snapshot->FrameInfo;
+
+    const auto& previous = snapshot->PreviousSkeletons;
+    const auto period = snapshot->FrameInfo.GetDeviceTime()
+        - snapshot->PreviousFrameInfo.GetDeviceTime();
+    if ((previous.Num() < 1) || (period <= 0.0)) {
+        return dst.Num();
+    }
+
+    // The system timestamp tells us when the most recent frame arrived on
+    // the host, so the requested time relative to it is also the offset on
+    // the clock of the device. The distance between the frames comes from
+    // the clock of the device, because it does not jitter.
+    const auto received = 1e-9 * snapshot->FrameInfo.SystemTimestamp
+        + this->_systemTimeOffset;
+    const auto offset = FMath::Clamp(time - received,
+        -period,
+        0.001 * FMath::Max(this->MaxExtrapolation, 0.0f));
+    const auto alpha = static_cast<float>(1.0 + offset / period);
+
+    for (auto& s : dst) {
+        auto p = previous.FindByPredicate(
+            [&s](const FAzureKinectSkeletonData& c) { return c.ID == s.ID; });
+        if (p != nullptr) {
+            s.InterpolateFrom(*p, alpha);
+        }
+    }
+
+    return dst.Num();
+}
+
+
+/*
+ * UAzureKinectDevice::GetBufferPoolStatistics
+ */
+FAzureKinectBufferPoolStatistics UAzureKinectDevice::GetBufferPoolStatistics(
+        const EKinectStream stream) const {
+    FAzureKinectBufferPoolStatistics retval;
+
+    switch (stream) {
+        case EKinectStream::BODY_INDEX:
+            this->_bodyIndexPool->GetStatistics(retval);
+            break;
+
+        case EKinectStream::COLOUR:
+            this->_colourPool->GetStatistics(retval);
+            break;
+
+        case EKinectStream::DEPTH:
+            this->_depthPool->GetStatistics(retval);
+            break;
+
+        case EKinectStream::INFRARED:
+            this->_infraredPool->GetStatistics(retval);
+            break;
+
+        case EKinectStream::SENSOR:
+            this->_sensorPool->GetStatistics(retval);
+            break;
+
+        default:
+            break;
+    }
+
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::GetPipelineStatistics
+ */
+FAzureKinectPipelineStatistics UAzureKinectDevice::GetPipelineStatistics(
+        void) const {
+    FAzureKinectPipelineStatistics retval;
+
+    retval.Capture.Processed = this->_cntCaptured.GetValue();
+    retval.Capture.Dropped = this->_cntCaptureTimeouts.GetValue();
+
+    retval.Conversion.Processed = this->_cntConverted.GetValue();
+    this->_conversionQueue.GetStatistics(retval.Conversion);
+
+    this->_colourDecoder.GetStatistics(retval.Decoding);
+
+    retval.Tracking.Processed = this->_cntTracked.GetValue();
+    this->_trackingQueue.GetStatistics(retval.Tracking);
+    // Captures that have been handed to the tracker, but have not yet been
+    // popped, are still pending from the user's point of view.
+    retval.Tracking.Pending += static_cast<int32>(
+        this->_cntTrackerEnqueued.GetValue() - retval.Tracking.Processed);
+
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::GetPointCloud
+ */
+int32 UAzureKinectDevice::GetPointCloud(TArray<FVector>& positions,
+        TArray<FColor>& colours) const {
+    const auto snapshot = this->_pointClouds.Acquire();
+    if (!snapshot) {
+        positions.Reset();
+        colours.Reset();
+        return 0;
+    }
+
+    positions.SetNumUninitialized(snapshot->Positions.Num());
+    for (int32 i = 0; i < positions.Num(); ++i) {
+        positions[i] = FVector(snapshot->Positions[i]);
+    }
+
+    colours = snapshot->Colours;
+    return positions.Num();
+}
+
+
+/*
+ * UAzureKinectDevice::GetPointCloudFrameInfo
+ */
+FAzureKinectFrameInfo UAzureKinectDevice::GetPointCloudFrameInfo(
+        void) const {
+    const auto snapshot = this->_pointClouds.Acquire();
+    return snapshot ? snapshot->FrameInfo : FAzureKinectFrameInfo();
+}
+
+
+/*
+ * UAzureKinectDevice::GetPointCloudSnapshot
+ */
+TAzureKinectSnapshotBuffer<FAzureKinectPointCloud>::SnapshotType
+UAzureKinectDevice::GetPointCloudSnapshot(void) const {
+    return this->_pointClouds.Acquire();
+}
+
+
+/*
+ * UAzureKinectDevice::GetPointCloudStatistics
+ */
+FAzureKinectPointCloudStatistics UAzureKinectDevice::GetPointCloudStatistics(
+        void) const {
+    const auto snapshot = this->_pointClouds.Acquire();
+    return snapshot ? snapshot->Statistics : FAzureKinectPointCloudStatistics();
+}
+
+
+/*
+ * UAzureKinectDevice::GetUploadStatistics
+ */
+FAzureKinectStageStatistics UAzureKinectDevice::GetUploadStatistics(
+        const EKinectStream stream) const {
+    FAzureKinectStageStatistics retval;
+    this->_uploader->GetStatistics(stream, retval);
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::GetSkeletonFrameInfo
+ */
+FAzureKinectFrameInfo UAzureKinectDevice::GetSkeletonFrameInfo(void) const {
+    const auto snapshot = this->_skeletons.Acquire();
+    return snapshot ? snapshot->FrameInfo : FAzureKinectFrameInfo();
+}
+
+
 /*
  * UAzureKinectDevice::GetSkeletons
  */
 TArray<FAzureKinectSkeleton> UAzureKinectDevice::GetSkeletons(void) const {
-    if (this->IsOpen()) {
-        FScopeLock l(&this->_lock);
-        return this->_skeletons;
-    } else {
-        return this->_skeletons;
+    TArray<FAzureKinectSkeleton> retval;
+
+    const auto snapshot = this->_skeletons.Acquire();
+    if (snapshot) {
+        retval.SetNum(snapshot->Skeletons.Num());
+        for (int32 s = 0; s < retval.Num(); ++s) {
+            snapshot->Skeletons[s].ToSkeleton(retval[s]);
+            retval[s].FrameInfo = snapshot->FrameInfo;
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::GetSkeletonsAt
+ */
+TArray<FAzureKinectSkeleton> UAzureKinectDevice::GetSkeletonsAt(
+        const double time) const {
+    TArray<FAzureKinectSkeletonData> skeletons;
+    FAzureKinectFrameInfo frameInfo;
+    this->CopySkeletonsAt(skeletons, time, frameInfo);
+
+    TArray<FAzureKinectSkeleton> retval;
+    retval.SetNum(skeletons.Num());
+    for (int32 s = 0; s < retval.Num(); ++s) {
+        skeletons[s].ToSkeleton(retval[s]);
+        retval[s].FrameInfo = frameInfo;
     }
+
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::GetSkeletonSnapshot
+ */
+TAzureKinectSnapshotBuffer<FAzureKinectSkeletonSnapshot>::SnapshotType
+UAzureKinectDevice::GetSkeletonSnapshot(void) const {
+    return this->_skeletons.Acquire();
 }
 
 
@@ -115,8 +437,8 @@ FAzureKinectSkeleton UAzureKinectDevice::GetSkeleton(const int32 index) const {
         return FAzureKinectSkeleton();
     }
 
-    FScopeLock l(&this->_lock);
-    if (!this->_skeletons.IsValidIndex(index)) {
+    const auto snapshot = this->_skeletons.Acquire();
+    if (!snapshot || !snapshot->Skeletons.IsValidIndex(index)) {
         UE_LOG(AzureKinectDeviceLog,
             Warning,
             TEXT("An empty skeleton was returned as the requested index %d ")
@@ -124,7 +446,21 @@ FAzureKinectSkeleton UAzureKinectDevice::GetSkeleton(const int32 index) const {
         return FAzureKinectSkeleton();
     }
 
-    return this->_skeletons[index];
+    FAzureKinectSkeleton retval;
+    snapshot->Skeletons[index].ToSkeleton(retval);
+    retval.FrameInfo = snapshot->FrameInfo;
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::GetTextureFrameInfo
+ */
+FAzureKinectFrameInfo UAzureKinectDevice::GetTextureFrameInfo(
+        const EKinectStream stream) const {
+    FAzureKinectFrameInfo retval;
+    this->_uploader->GetFrameInfo(stream, retval);
+    return retval;
 }
 
 
@@ -146,9 +482,25 @@ int32 UAzureKinectDevice::GetTrackedSkeletons(void) const {
         return 0;
     }
 
-    FScopeLock l(&this->_lock);
-    return this->_cntTrackedSkeletons;
+    const auto snapshot = this->_skeletons.Acquire();
+    return snapshot ? snapshot->Skeletons.Num() : 0;
+}
+
+
+#if WITH_EDITOR
+/*
+ * UAzureKinectDevice::PostEditChangeProperty
+ */
+void UAzureKinectDevice::PostEditChangeProperty(
+        FPropertyChangedEvent& event) {
+    Super::PostEditChangeProperty(event);
+
+    if (event.GetPropertyName() == GET_MEMBER_NAME_CHECKED(UAzureKinectDevice,
+            BodyIndexPalette)) {
+        this->UpdateBodyIndexColours();
+    }
 }
+#endif /* WITH_EDITOR */
 
 
 /*
@@ -180,6 +532,16 @@ int32 UAzureKinectDevice::RefreshDevices(void) {
     return this->Devices.Num();
 }
 
+
+/*
+ * UAzureKinectDevice::SetBodyIndexPalette
+ */
+void UAzureKinectDevice::SetBodyIndexPalette(const TArray<FColor>& palette) {
+    this->BodyIndexPalette = palette;
+    this->UpdateBodyIndexColours();
+}
+
+
 /*
  * UAzureKinectDevice::Start
  */
@@ -199,16 +561,29 @@ bool UAzureKinectDevice::Start(void) {
         return false;
     }
 
+    if (((this->ColourFormat == EKinectColourFormat::NV12)
+            || (this->ColourFormat == EKinectColourFormat::YUY2))
+            && (this->ColourResolution
+                != EKinectColourResolution::RESOLUTION_720P)
+            && (this->ColourResolution
+                != EKinectColourResolution::RESOLUTION_OFF)) {
+        UE_LOG(AzureKinectDeviceLog,
+            Warning,
+            TEXT("The NV12 and YUY2 colour formats are only supported at ")
+            TEXT("720p. Starting the cameras will most likely fail."));
+    }
+
     try {
         this->_device = k4a::device::open(this->DeviceIndex);
 
         {
             auto config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
             typedef decltype(config.camera_fps) F;
+            typedef decltype(config.color_format) C;
             typedef decltype(config.color_resolution) R;
             typedef decltype(config.depth_mode) D;
             config.camera_fps = static_cast<F>(this->FrameRate);
-            config.color_format = ColourFormat;
+            config.color_format = static_cast<C>(this->ColourFormat);
             config.color_resolution = static_cast<R>(this->ColourResolution);
             config.depth_mode = static_cast<D>(this->DepthMode);
             config.disable_streaming_indicator
@@ -219,7 +594,7 @@ bool UAzureKinectDevice::Start(void) {
             this->_device.start_cameras(&config);
             this->_calibration = this->_device.get_calibration(config.depth_mode,
                 config.color_resolution);
-            this->_transform = k4a::transformation(this->_calibration);
+            this->_registration.Reset(this->_calibration);
         }
 
         if (this->SkeletonTracking != EKinectTrackerProcessing::DISABLED) {
@@ -240,10 +615,119 @@ bool UAzureKinectDevice::Start(void) {
                 config);
         }
 
+        this->_framesPerSecond = ToFramesPerSecond(this->FrameRate);
         this->_frameTime = ToFrameTime(this->FrameRate);
 
-        assert(this->_thread == nullptr);
-        this->_thread = new FAzureKinectDeviceThread(this);
+        // The SDK derives the system timestamps from the same performance
+        // counter as FPlatformTime, but the latter adds a constant offset.
+        this->_systemTimeOffset = FPlatformTime::Seconds()
+            - FPlatformTime::GetSecondsPerCycle64()
+            * static_cast<double>(FPlatformTime::Cycles64());
+
+        // Size the upload buffers for the resolution that is now fixed by the
+        // calibration. We only pre-allocate buffers for streams that need
+        // to be converted on the CPU.
+        {
+            const auto& c = this->_calibration.color_camera_calibration;
+            const auto& d = this->_calibration.depth_camera_calibration;
+            const auto colourSize = 4 * c.resolution_width
+                * c.resolution_height;
+            const auto depthSize = 4 * d.resolution_width
+                * d.resolution_height;
+            // Besides the uploads in flight, one buffer can wait in the
+            // mailbox of the uploader and one is being filled.
+            const auto cntPooled = this->MaxInFlightUploads + 2;
+            const auto cntSensor = (this->SensorTextureFormat
+                == EKinectSensorTextureFormat::RGBA8)
+                ? cntPooled
+                : 0;
+            const auto cntBodyIndex = (this->_bodyTracker
+                && (this->BodyIndexMode != EKinectBodyIndexMode::RAW_G8))
+                ? cntPooled
+                : 0;
+
+            this->_depthPool->Reset(IsDepthRemapped(this->Remapping)
+                ? colourSize : depthSize,
+                cntSensor);
+            this->_depthFilterPool->Reset(depthSize / 2,
+                this->DepthFilter.Enabled ? cntPooled : 0);
+            this->_infraredPool->Reset(depthSize, cntSensor);
+            this->_bodyIndexPool->Reset(depthSize, cntBodyIndex);
+            this->_sensorPool->Reset(2 * depthSize,
+                (this->SensorTexture != nullptr) ? cntPooled : 0);
+            // The remapped images have the size of the other camera and are
+            // uploaded as they are if they need no further conversion.
+            this->_colourRemapPool->Reset(depthSize,
+                IsColourRemapped(this->Remapping) ? cntPooled : 0);
+            this->_depthRemapPool->Reset(colourSize / 2,
+                IsDepthRemapped(this->Remapping) ? cntPooled : 0);
+            // Each decoder thread fills its own buffer.
+            this->_colourPool->Reset(colourSize,
+                (this->ColourFormat != EKinectColourFormat::BGRA32)
+                ? cntPooled + this->ColourDecoderThreads
+                : 0);
+        }
+
+        this->_cntCaptured.Reset();
+        this->_cntCaptureTimeouts.Reset();
+        this->_cntConverted.Reset();
+        this->_cntTracked.Reset();
+        this->_cntTrackerEnqueued.Reset();
+        this->_frameSequence = -1;
+        for (auto& f : this->_frameSequences) {
+            f.DeviceTimestamp = -1;
+            f.Sequence = -1;
+        }
+        this->_uploader->Reset(this->MaxInFlightUploads);
+        this->UpdateBodyIndexColours();
+        this->_workers.Start(this->WorkerThreads, this->WorkerAffinityMask);
+
+        // Only MJPG is expensive enough to be decoded on dedicated threads.
+        // Remapping requires the decoded image in the conversion stage.
+        if (this->ColourFormat == EKinectColourFormat::MJPG) {
+            const auto async = (this->ColourResolution
+                    != EKinectColourResolution::RESOLUTION_OFF)
+                && (this->ColourTexture != nullptr)
+                && !IsColourRemapped(this->Remapping);
+            this->_colourDecoder.Start(async ? this->ColourDecoderThreads : 0,
+                this->_colourPool,
+                this->_uploader);
+        }
+
+        // If the textures are synchronised with the body tracker, the tracker
+        // result stage performs the conversion.
+        this->_texturesFromTracker = this->SynchronisedTextures
+            && this->_bodyTracker;
+
+        // The downstream stages must be running before the capture stage
+        // starts feeding them.
+        assert(this->_conversionThread == nullptr);
+        if (((this->ColourResolution != EKinectColourResolution::RESOLUTION_OFF)
+                || (this->DepthMode != EKinectDepthMode::OFF))
+                && !this->_texturesFromTracker) {
+            this->_conversionQueue.Open(this->ConversionQueueDepth);
+            this->_conversionThread = new FAzureKinectDeviceThread(this,
+                &UAzureKinectDevice::ConvertAsync,
+                TEXT("Azure Kinect conversion thread"));
+        }
+
+        assert(this->_trackingThread == nullptr);
+        assert(this->_trackerResultThread == nullptr);
+        if (this->_bodyTracker) {
+            this->_trackingQueue.Open(this->TrackingQueueDepth,
+                this->TrackerQueuePolicy);
+            this->_trackerResultThread = new FAzureKinectDeviceThread(this,
+                &UAzureKinectDevice::PopTrackerResultAsync,
+                TEXT("Azure Kinect tracker result thread"));
+            this->_trackingThread = new FAzureKinectDeviceThread(this,
+                &UAzureKinectDevice::TrackAsync,
+                TEXT("Azure Kinect tracking thread"));
+        }
+
+        assert(this->_captureThread == nullptr);
+        this->_captureThread = new FAzureKinectDeviceThread(this,
+            &UAzureKinectDevice::UpdateAsync,
+            TEXT("Azure Kinect capture thread"));
     } catch (k4a::error ex) {
         if (this->_device) {
             this->_device.close();
@@ -271,20 +755,41 @@ bool UAzureKinectDevice::Stop(void) {
         return false;
     }
 
-    if (this->_thread != nullptr) {
-        this->_thread->EnsureCompletion();
-        this->_thread = nullptr;
+    // Stop the producer first such that no new work arrives while the
+    // downstream stages are shutting down. Closing the queues wakes the
+    // stages if they are waiting for input and the producer if it is blocked
+    // on a full tracking queue.
+    if (this->_captureThread != nullptr) {
+        this->_captureThread->Stop();
+    }
+
+    this->_conversionQueue.Close();
+    this->_trackingQueue.Close();
+
+    for (auto t : { &this->_captureThread,
+            &this->_conversionThread,
+            &this->_trackingThread,
+            &this->_trackerResultThread }) {
+        if (*t != nullptr) {
+            (*t)->EnsureCompletion();
+            delete *t;
+            *t = nullptr;
+        }
     }
 
+    this->_pendingTrackerCapture.reset();
+    this->_workers.Shutdown();
+    this->_decimation.Reset();
+    this->_depthFilter.Reset();
+    this->_skeletonFilter.Reset();
+    this->_registration.Reset();
+    this->_colourDecoder.Shutdown();
+
     if (this->_bodyTracker) {
         this->_bodyTracker.shutdown();
         this->_bodyTracker.destroy();
     }
 
-    if (this->_remapImage) {
-        this->_remapImage.reset();
-    }
-
     if (this->_device) {
         this->_device.stop_cameras();
         this->_device.close();
@@ -297,6 +802,23 @@ bool UAzureKinectDevice::Stop(void) {
 }
 
 
+/*
+ * UAzureKinectDevice::GetDefaultBodyIndexPalette
+ */
+TArray<FColor> UAzureKinectDevice::GetDefaultBodyIndexPalette(void) {
+    return TArray<FColor> {
+        FColor(230, 25, 75),
+        FColor(60, 180, 75),
+        FColor(255, 225, 25),
+        FColor(0, 130, 200),
+        FColor(245, 130, 48),
+        FColor(145, 30, 180),
+        FColor(70, 240, 240),
+        FColor(240, 50, 230)
+    };
+}
+
+
 /*
  * UAzureKinectDevice::GetPluginLocation
  */
@@ -327,35 +849,120 @@ FString UAzureKinectDevice::GetPluginLocation(void) {
 
 
 /*
- * UAzureKinectDevice::ToFrameTime
+ * UAzureKinectDevice::GetReferenceImage
  */
-std::chrono::milliseconds UAzureKinectDevice::ToFrameTime(
-        const EKinectFps frameRate) noexcept {
-    auto value = 0.0f;
+k4a::image UAzureKinectDevice::GetReferenceImage(
+        const k4a::capture& capture) {
+    // The skeletons and the point cloud are derived from the depth image, so
+    // we prefer its timestamps such that all data of a frame agree.
+    auto retval = capture.get_depth_image();
+    if (!retval) {
+        retval = capture.get_color_image();
+    }
+    if (!retval) {
+        retval = capture.get_ir_image();
+    }
+
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::InitColourTexture
+ */
+void UAzureKinectDevice::InitColourTexture(UTextureRenderTarget2D *rt,
+        const int32 width,
+        const int32 height) {
+    assert(rt != nullptr);
+    rt->InitCustomFormat(width, height, EPixelFormat::PF_B8G8R8A8, false);
+    rt->RenderTargetFormat = ETextureRenderTargetFormat::RTF_RGBA8;
+    rt->UpdateResource();
+}
+
+
+/*
+ * UAzureKinectDevice::InitSensorTexture
+ */
+void UAzureKinectDevice::InitSensorTexture(UTextureRenderTarget2D *rt,
+        const int32 width,
+        const int32 height,
+        const EKinectSensorTextureFormat format) {
+    assert(rt != nullptr);
+    rt->InitCustomFormat(width, height, ToPixelFormat(format), true);
+
+    switch (format) {
+        case EKinectSensorTextureFormat::RGBA8:
+            rt->RenderTargetFormat = ETextureRenderTargetFormat::RTF_RGBA8;
+            break;
+
+        default:
+            // There is no render target format for 16-bit integers, but the
+            // override format set by InitCustomFormat takes precedence anyway.
+            rt->RenderTargetFormat = ETextureRenderTargetFormat::RTF_R16f;
+            break;
+    }
+
+    rt->UpdateResource();
+}
+
 
+/*
+ * UAzureKinectDevice::ToFramesPerSecond
+ */
+int32 UAzureKinectDevice::ToFramesPerSecond(
+        const EKinectFps frameRate) noexcept {
     switch (frameRate) {
         case EKinectFps::PER_SECOND_5:
-            value = 1000.f / 5.f;
-            break;
+            return 5;
 
         case EKinectFps::PER_SECOND_15:
-            value = 1000.f / 15.f;
-            break;
+            return 15;
 
         case EKinectFps::PER_SECOND_30:
-            value = 1000.f / 30.f;
-            break;
+            return 30;
+
+        default:
+            return 0;
     }
+}
 
+
+/*
+ * UAzureKinectDevice::ToFrameTime
+ */
+std::chrono::milliseconds UAzureKinectDevice::ToFrameTime(
+        const EKinectFps frameRate) noexcept {
+    const auto fps = ToFramesPerSecond(frameRate);
+    const auto value = (fps > 0) ? 1000.f / fps : 0.0f;
     return std::chrono::milliseconds(FMath::CeilToInt(value));
 }
 
 
 /*
- * UAzureKinectDevice::ToTransform
+ * UAzureKinectDevice::ToPixelFormat
+ */
+EPixelFormat UAzureKinectDevice::ToPixelFormat(
+        const EKinectSensorTextureFormat format) noexcept {
+    switch (format) {
+        case EKinectSensorTextureFormat::G16:
+            return EPixelFormat::PF_G16;
+
+        case EKinectSensorTextureFormat::R16_UINT:
+            return EPixelFormat::PF_R16_UINT;
+
+        default:
+            return EPixelFormat::PF_R8G8B8A8;
+    }
+}
+
+
+/*
+ * UAzureKinectDevice::ToJoint
  */
-FTransform UAzureKinectDevice::ToTransform(const k4abt_joint_t& joint,
-        const int32 index) {
+void UAzureKinectDevice::ToJoint(FVector3f& position,
+        FQuat4f& rotation,
+        EKinectJointConfidence& confidence,
+        const k4abt_joint_t& joint) {
     // This transform algorithm is introdeced from 
     // https://github.com/secretlocation/azure-kinect-unreal/
     // Still there is room to refactor...
@@ -371,7 +978,7 @@ FTransform UAzureKinectDevice::ToTransform(const k4abt_joint_t& joint,
      * +ve Y-axis		Down		-ve Z-axis
      * +ve Z-axis		Forward		+ve X-axis
     */
-    FVector position(
+    position = FVector3f(
         joint.position.xyz.z,
         joint.position.xyz.x,
         -joint.position.xyz.y);
@@ -382,7 +989,7 @@ FTransform UAzureKinectDevice::ToTransform(const k4abt_joint_t& joint,
      * We negate the x, y components of the jointQuaternion since we are converting from
      * Kinect's Right Hand orientation to Unreal's Left Hand orientation.
      */
-    FQuat rotation(
+    rotation = FQuat4f(
         -joint.orientation.wxyz.x,
         -joint.orientation.wxyz.y,
         joint.orientation.wxyz.z,
@@ -390,53 +997,94 @@ FTransform UAzureKinectDevice::ToTransform(const k4abt_joint_t& joint,
 
     // Idk whether the above worked in UE4, but in UE5, the character is lying
     // on the floor w/o the following pre-transform.
-    rotation = FQuat(FRotator(0.0f, 0.0f, 90.0f)) * rotation;
+    static const FQuat4f PreTransform(FRotator3f(0.0f, 0.0f, 90.0f));
+    rotation = PreTransform * rotation;
     //DrawDebugCoordinateSystem(GetWorld(), position, rotation.Rotator(), 1.0f);
 
-    return FTransform(rotation, position);
+    confidence = static_cast<EKinectJointConfidence>(joint.confidence_level);
 }
 
 
 /*
- * UAzureKinectDevice::Update
+ * UAzureKinectDevice::ApplyJointPolicy
  */
-void UAzureKinectDevice::Update(UTextureRenderTarget2D *rt,
-        TArray<uint8>&& data,
-        const int32 width,
-        const int32 height,
-        const int32 pitch) {
-    assert(rt);
-    assert(data);
-    assert(data.Num() == height * pitch);
-
-    FUpdateTextureRegion2D region(0, 0, 0, 0, width, height);
-
-    ENQUEUE_RENDER_COMMAND(UpdateRTCommand)(
-        [rt, d = MoveTemp(data), region, pitch](
-                FRHICommandListImmediate& cmdList) {
-            auto res = rt->GetRenderTargetResource();
-            if (res) {
-                GDynamicRHI->RHIUpdateTexture2D(
-                    cmdList,
-                    res->GetRenderTargetTexture(),
-                    0,
-                    region,
-                    pitch,
-                    d.GetData());
-            } else {
-                UE_LOG(AzureKinectDeviceLog,
-                    Warning,
-                    TEXT("Failed to obtain resource from render target."));
+void UAzureKinectDevice::ApplyJointPolicy(FAzureKinectSkeletonData& skeleton,
+        const FAzureKinectSkeletonSnapshot *previous) const {
+    const auto policy = this->LowConfidencePolicy;
+    const auto threshold = this->JointConfidenceThreshold;
+
+    if (policy == EKinectJointPolicy::KEEP) {
+        return;
+    }
+
+    const FAzureKinectSkeletonData *last = nullptr;
+    if (previous != nullptr) {
+        last = previous->Skeletons.FindByPredicate(
+            [&skeleton](const FAzureKinectSkeletonData& s) {
+                return (s.ID == skeleton.ID);
+            });
+    }
+
+    // Parents precede their children, so a child falling back to its parent
+    // obtains the parent after the policy has been applied to it.
+    for (int32 j = 0; j < FAzureKinectSkeletonData::JointCount; ++j) {
+        if (skeleton.Confidences[j] >= threshold) {
+            continue;
+        }
+
+        switch (policy) {
+            case EKinectJointPolicy::HOLD_LAST:
+                // The previous snapshot already holds the last good value if
+                // the joint was below the threshold there, too. The joint
+                // also keeps the confidence it is held with, such that
+                // consumers do not discard it.
+                if (last != nullptr) {
+                    skeleton.Positions[j] = last->Positions[j];
+                    skeleton.Rotations[j] = last->Rotations[j];
+                    skeleton.Confidences[j] = last->Confidences[j];
+                }
+                break;
+
+            case EKinectJointPolicy::USE_PARENT: {
+                const auto parent = FAzureKinectSkeletonData::GetParent(j);
+                if (parent < 0) {
+                    break;
+                }
+
+                // If the body was tracked before, the joint keeps its offset
+                // from the parent in the last frame, which already moved it
+                // with the parent if it was low then, too. The bone therefore
+                // retains its length and the joint becomes as reliable as its
+                // parent. Otherwise, we only have the rotation to go by.
+                if (last != nullptr) {
+                    const auto offset = last->Rotations[parent].UnrotateVector(
+                        last->Positions[j] - last->Positions[parent]);
+                    skeleton.Positions[j] = skeleton.Positions[parent]
+                        + skeleton.Rotations[parent].RotateVector(offset);
+                    skeleton.Confidences[j] = skeleton.Confidences[parent];
+                }
+
+                skeleton.Rotations[j] = skeleton.Rotations[parent];
+                break;
             }
-        });
+
+            case EKinectJointPolicy::SKIP:
+                skeleton.Confidences[j] = EKinectJointConfidence::NONE;
+                break;
+
+            default:
+                break;
+        }
+    }
 }
 
 
 /*
  * UAzureKinectDevice::CaptureBodyIndexTexture
  */
-void UAzureKinectDevice::CaptureBodyIndexTexture(const k4abt::frame& frame) {
-    const auto indexMap = frame.get_body_index_map();
+void UAzureKinectDevice::CaptureBodyIndexTexture(const k4abt::frame& frame,
+        FAzureKinectTextureUploads& uploads) {
+    auto indexMap = frame.get_body_index_map();
     const auto width = indexMap.get_width_pixels();
     const auto height = indexMap.get_height_pixels();
 
@@ -447,27 +1095,57 @@ void UAzureKinectDevice::CaptureBodyIndexTexture(const k4abt::frame& frame) {
         return;
     }
 
-    if (!HasSize(this->BodyIndexTexture, width, height)) {
-        this->BodyIndexTexture->InitCustomFormat(width, height,
-            EPixelFormat::PF_R8G8B8A8, true);
-        this->BodyIndexTexture->RenderTargetFormat
-            = ETextureRenderTargetFormat::RTF_RGBA8;
+    const auto raw = (this->BodyIndexMode == EKinectBodyIndexMode::RAW_G8);
+    const auto format = raw ? EPixelFormat::PF_G8 : EPixelFormat::PF_R8G8B8A8;
+
+    if (!HasSize(this->BodyIndexTexture, width, height, format)) {
+        this->BodyIndexTexture->InitCustomFormat(width, height, format, true);
+        this->BodyIndexTexture->RenderTargetFormat = raw
+            ? ETextureRenderTargetFormat::RTF_R8
+            : ETextureRenderTargetFormat::RTF_RGBA8;
         this->BodyIndexTexture->UpdateResource();
 
-    } else {
-        auto d = indexMap.get_buffer();
+    } else if (raw) {
+        const auto pitch = indexMap.get_stride_bytes();
+        uploads.Emplace(EKinectStream::BODY_INDEX,
+            this->BodyIndexTexture,
+            MoveTemp(indexMap),
+            width,
+            height,
+            pitch);
 
-        TArray<uint8> data;
-        data.Reset(width * height * 4);
+    } else {
+        auto s = indexMap.get_buffer();
+        k4a::image data;
 
-        for (int i = 0; i < width * height; i++) {
-            data.Push(d[i]);
-            data.Push(d[i]);
-            data.Push(d[i]);
-            data.Push(0xff);
+        try {
+            data = this->_bodyIndexPool->Acquire(K4A_IMAGE_FORMAT_CUSTOM,
+                width,
+                height,
+                4 * width);
+        } catch (k4a::error ex) {
+            FString msg(ANSI_TO_TCHAR(ex.what()));
+            UE_LOG(AzureKinectDeviceLog,
+                Error,
+                TEXT("Failed to allocate body index texture data: %s"),
+                *msg);
+            return;
         }
 
-        Update(this->BodyIndexTexture,
+        uint32 lut[256];
+        this->GetBodyIndexLut(frame, lut);
+
+        auto dst = reinterpret_cast<uint32 *>(data.get_buffer());
+        this->_workers.ParallelForTiles(height, this->ConversionTileRows,
+                [dst, s, width, &lut](const int32 begin, const int32 end) {
+            FAzureKinectConversion::Lookup8(dst + begin * width,
+                s + begin * width,
+                lut,
+                (end - begin) * width);
+        });
+
+        uploads.Emplace(EKinectStream::BODY_INDEX,
+            this->BodyIndexTexture,
             MoveTemp(data),
             width,
             height,
@@ -479,13 +1157,14 @@ void UAzureKinectDevice::CaptureBodyIndexTexture(const k4abt::frame& frame) {
 /*
  * UAzureKinectDevice::CaptureColourTexture
  */
-void UAzureKinectDevice::CaptureColourTexture(k4a::capture& capture) {
+void UAzureKinectDevice::CaptureColourTexture(k4a::capture& capture,
+        FAzureKinectTextureUploads& uploads) {
     assert(capture);
     int32 width = 0;
     int32 height = 0;
-    uint8 *source = nullptr;
+    k4a::image source;
 
-    if (this->Remapping == EKinectRemap::COLOUR_TO_DEPTH) {
+    if (IsColourRemapped(this->Remapping)) {
         auto colour = capture.get_color_image();
         if (!colour) {
             UE_LOG(AzureKinectDeviceLog,
@@ -512,19 +1191,26 @@ void UAzureKinectDevice::CaptureColourTexture(k4a::capture& capture) {
             return;
         }
 
-        if (!this->_remapImage || !this->_remapImage.is_valid()) {
-            this->_remapImage = k4a::image::create(
+        // The remapped image is handed over to the render thread, so it
+        // comes from a pool that recycles it once the upload is complete.
+        try {
+            // The registration only accepts BGRA32.
+            if (colour.get_format() != K4A_IMAGE_FORMAT_COLOR_BGRA32) {
+                colour = FAzureKinectColourDecoder::Decode(colour,
+                    *this->_colourPool);
+                if (!colour) {
+                    UE_LOG(AzureKinectDeviceLog,
+                        Warning,
+                        TEXT("Failed to decode Azure Kinect colour image."));
+                    return;
+                }
+            }
+
+            source = this->_colourRemapPool->Acquire(
                 K4A_IMAGE_FORMAT_COLOR_BGRA32,
                 width,
                 height,
                 width * static_cast<int>(sizeof(uint8) * 4));
-        }
-
-        try {
-            this->_transform.color_image_to_depth_camera(
-                depth,
-                colour,
-                &this->_remapImage);
         } catch (k4a::error ex) {
             FString msg(ANSI_TO_TCHAR(ex.what()));
             UE_LOG(AzureKinectDeviceLog,
@@ -533,7 +1219,14 @@ void UAzureKinectDevice::CaptureColourTexture(k4a::capture& capture) {
             return;
         }
 
-        source = this->_remapImage.get_buffer();
+        assert(colour.get_stride_bytes() == 4 * colour.get_width_pixels());
+        assert(depth.get_stride_bytes() == 2 * width);
+        this->_registration.ColourToDepth(
+            reinterpret_cast<uint32 *>(source.get_buffer()),
+            reinterpret_cast<const uint32 *>(colour.get_buffer()),
+            reinterpret_cast<const uint16 *>(depth.get_buffer()),
+            this->_workers,
+            this->ConversionTileRows);
 
     } else {
         auto colour = capture.get_color_image();
@@ -554,22 +1247,53 @@ void UAzureKinectDevice::CaptureColourTexture(k4a::capture& capture) {
             return;
         }
 
-        source = colour.get_buffer();
-    }
+        if (colour.get_format() == K4A_IMAGE_FORMAT_COLOR_BGRA32) {
+            source = MoveTemp(colour);
 
-    if (!HasSize(this->ColourTexture, width, height)) {
-        this->ColourTexture->InitCustomFormat(width, height,
-            EPixelFormat::PF_B8G8R8A8, false);
-        this->ColourTexture->RenderTargetFormat
-            = ETextureRenderTargetFormat::RTF_RGBA8;
-        this->ColourTexture->UpdateResource();
+        } else if (this->_colourDecoder.GetThreadCount() > 0) {
+            // The decoder uploads the image once it is done, which is why
+            // the texture must be ready before the image is submitted.
+            if (!HasSize(this->ColourTexture, width, height)) {
+                InitColourTexture(this->ColourTexture, width, height);
+            } else {
+                this->_colourDecoder.Submit(MoveTemp(colour),
+                    this->ColourTexture,
+                    this->GetFrameInfo(capture));
+            }
+            return;
 
-    } else {
-        Update(this->ColourTexture,
-            source,
+        } else {
+            try {
+                source = FAzureKinectColourDecoder::Decode(colour,
+                    *this->_colourPool);
+            } catch (k4a::error ex) {
+                FString msg(ANSI_TO_TCHAR(ex.what()));
+                UE_LOG(AzureKinectDeviceLog,
+                    Error,
+                    TEXT("Failed to allocate colour image: %s"), *msg);
+                return;
+            }
+
+            if (!source) {
+                UE_LOG(AzureKinectDeviceLog,
+                    Warning,
+                    TEXT("Failed to decode Azure Kinect colour image."));
+                return;
+            }
+        }
+    }
+
+    if (!HasSize(this->ColourTexture, width, height)) {
+        InitColourTexture(this->ColourTexture, width, height);
+
+    } else {
+        const auto pitch = source.get_stride_bytes();
+        uploads.Emplace(EKinectStream::COLOUR,
+            this->ColourTexture,
+            MoveTemp(source),
             width,
             height,
-            4 * width);
+            pitch);
     }
 }
 
@@ -577,13 +1301,14 @@ void UAzureKinectDevice::CaptureColourTexture(k4a::capture& capture) {
 /*
  * UAzureKinectDevice::CaptureDepthTexture
  */
-void UAzureKinectDevice::CaptureDepthTexture(k4a::capture& capture) {
+void UAzureKinectDevice::CaptureDepthTexture(k4a::capture& capture,
+        FAzureKinectTextureUploads& uploads) {
     assert(capture);
     int32 width = 0;
     int32 height = 0;
-    uint8 *source = nullptr;
+    k4a::image source;
 
-    if (this->Remapping == EKinectRemap::DEPTH_TO_COLOUR) {
+    if (IsDepthRemapped(this->Remapping)) {
         auto colour = capture.get_color_image();
         if (!colour) {
             UE_LOG(AzureKinectDeviceLog,
@@ -610,17 +1335,14 @@ void UAzureKinectDevice::CaptureDepthTexture(k4a::capture& capture) {
             return;
         }
 
-        if (!this->_remapImage) {
-            this->_remapImage = k4a::image::create(
+        // The remapped image might be handed over to the render thread, so
+        // it comes from a pool that recycles it once the upload is complete.
+        try {
+            source = this->_depthRemapPool->Acquire(
                 K4A_IMAGE_FORMAT_DEPTH16,
                 width,
                 height,
                 width * static_cast<int>(sizeof(uint16)));
-        }
-
-        try {
-            this->_transform.depth_image_to_color_camera(depth,
-                &this->_remapImage);
         } catch (k4a::error ex) {
             FString msg(ANSI_TO_TCHAR(ex.what()));
             UE_LOG(AzureKinectDeviceLog,
@@ -629,7 +1351,12 @@ void UAzureKinectDevice::CaptureDepthTexture(k4a::capture& capture) {
             return;
         }
 
-        source = this->_remapImage.get_buffer();
+        assert(depth.get_stride_bytes() == 2 * depth.get_width_pixels());
+        this->_registration.DepthToColour(
+            reinterpret_cast<uint16 *>(source.get_buffer()),
+            reinterpret_cast<const uint16 *>(depth.get_buffer()),
+            this->_workers,
+            this->ConversionTileRows);
 
     } else {
         auto depth = capture.get_depth_image();
@@ -640,6 +1367,9 @@ void UAzureKinectDevice::CaptureDepthTexture(k4a::capture& capture) {
             return;
         }
 
+        width = depth.get_width_pixels();
+        height = depth.get_height_pixels();
+
         if ((width == 0) || (height == 0)) {
             UE_LOG(AzureKinectDeviceLog,
                 Warning,
@@ -647,37 +1377,45 @@ void UAzureKinectDevice::CaptureDepthTexture(k4a::capture& capture) {
             return;
         }
 
-        source = depth.get_buffer();
+        source = MoveTemp(depth);
     }
 
-    if (!HasSize(this->DepthTexture, width, height)) {
-        this->DepthTexture->InitCustomFormat(width,
+    const auto format = this->SensorTextureFormat;
+    if (!HasSize(this->DepthTexture, width, height, ToPixelFormat(format))) {
+        InitSensorTexture(this->DepthTexture, width, height, format);
+
+    } else if (format != EKinectSensorTextureFormat::RGBA8) {
+        const auto pitch = source.get_stride_bytes();
+        uploads.Emplace(EKinectStream::DEPTH,
+            this->DepthTexture,
+            MoveTemp(source),
+            width,
             height,
-            EPixelFormat::PF_R8G8B8A8,
-            true);
-        this->DepthTexture->RenderTargetFormat
-            = ETextureRenderTargetFormat::RTF_RGBA8;
-        this->DepthTexture->UpdateResource();
+            pitch);
 
     } else {
-        TArray<uint8> data;
-        data.Reset(width * height * 4);
-
-        for (int h = 0; h < height; ++h) {
-            for (int w = 0; w < width; ++w) {
-                int index = h * width + w;
-                uint16 r = source[index * 2];
-                uint16 g = source[index * 2 + 1];
-                uint16 sample = g << 8 | r;
-
-                data.Push(source[index * 2]);
-                data.Push(source[index * 2 + 1]);
-                data.Push(sample > 0 ? 0x00 : 0xFF);
-                data.Push(0xFF);
-            }
+        k4a::image data;
+
+        try {
+            data = this->_depthPool->Acquire(K4A_IMAGE_FORMAT_CUSTOM,
+                width,
+                height,
+                4 * width);
+        } catch (k4a::error ex) {
+            FString msg(ANSI_TO_TCHAR(ex.what()));
+            UE_LOG(AzureKinectDeviceLog,
+                Error,
+                TEXT("Failed to allocate depth texture data: %s"), *msg);
+            return;
         }
 
-        Update(this->DepthTexture,
+        this->Expand16(data.get_buffer(),
+            reinterpret_cast<const uint16 *>(source.get_buffer()),
+            width,
+            height);
+
+        uploads.Emplace(EKinectStream::DEPTH,
+            this->DepthTexture,
             MoveTemp(data),
             width,
             height,
@@ -689,7 +1427,8 @@ void UAzureKinectDevice::CaptureDepthTexture(k4a::capture& capture) {
 /*
  * UAzureKinectDevice::CaptureInfraredTexture
  */
-void UAzureKinectDevice::CaptureInfraredTexture(k4a::capture& capture) {
+void UAzureKinectDevice::CaptureInfraredTexture(k4a::capture& capture,
+        FAzureKinectTextureUploads& uploads) {
     assert(capture);
     int32 width = 0;
     int32 height = 0;
@@ -712,33 +1451,43 @@ void UAzureKinectDevice::CaptureInfraredTexture(k4a::capture& capture) {
         return;
     }
 
-    if (!HasSize(this->InfraredTexture, width, height)) {
-        this->InfraredTexture->InitCustomFormat(width, height,
-            EPixelFormat::PF_R8G8B8A8, true);
-        this->InfraredTexture->RenderTargetFormat
-            = ETextureRenderTargetFormat::RTF_RGBA8;
-        this->InfraredTexture->UpdateResource();
+    const auto format = this->SensorTextureFormat;
+    if (!HasSize(this->InfraredTexture, width, height, ToPixelFormat(format))) {
+        InitSensorTexture(this->InfraredTexture, width, height, format);
+
+    } else if (format != EKinectSensorTextureFormat::RGBA8) {
+        const auto pitch = image.get_stride_bytes();
+        uploads.Emplace(EKinectStream::INFRARED,
+            this->InfraredTexture,
+            MoveTemp(image),
+            width,
+            height,
+            pitch);
 
     } else {
         auto source = image.get_buffer();
-        TArray<uint8> data;
-        data.Reset(width * height * 4);
-
-        for (int h = 0; h < height; ++h) {
-            for (int w = 0; w < width; ++w) {
-                int index = h * width + w;
-                uint16 r = source[index * 2];
-                uint16 g = source[index * 2 + 1];
-                uint16 sample = g << 8 | r;
-
-                data.Push(source[index * 2]);
-                data.Push(source[index * 2 + 1]);
-                data.Push(sample > 0 ? 0x00 : 0xFF);
-                data.Push(0xFF);
-            }
+        k4a::image data;
+
+        try {
+            data = this->_infraredPool->Acquire(K4A_IMAGE_FORMAT_CUSTOM,
+                width,
+                height,
+                4 * width);
+        } catch (k4a::error ex) {
+            FString msg(ANSI_TO_TCHAR(ex.what()));
+            UE_LOG(AzureKinectDeviceLog,
+                Error,
+                TEXT("Failed to allocate infrared texture data: %s"), *msg);
+            return;
         }
 
-        Update(this->InfraredTexture,
+        this->Expand16(data.get_buffer(),
+            reinterpret_cast<const uint16 *>(source),
+            width,
+            height);
+
+        uploads.Emplace(EKinectStream::INFRARED,
+            this->InfraredTexture,
             MoveTemp(data),
             width,
             height,
@@ -747,6 +1496,596 @@ void UAzureKinectDevice::CaptureInfraredTexture(k4a::capture& capture) {
 }
 
 
+/*
+ * UAzureKinectDevice::CapturePointCloud
+ */
+void UAzureKinectDevice::CapturePointCloud(k4a::capture& capture) {
+    assert(capture);
+    auto depth = capture.get_depth_image();
+    if (!depth) {
+        UE_LOG(AzureKinectDeviceLog,
+            Verbose,
+            TEXT("Azure Kinect depth capture is invalid."));
+        return;
+    }
+
+    const auto width = depth.get_width_pixels();
+    const auto height = depth.get_height_pixels();
+
+    if ((width != this->_registration.GetDepthWidth())
+            || (height != this->_registration.GetDepthHeight())) {
+        UE_LOG(AzureKinectDeviceLog,
+            Warning,
+            TEXT("The Azure Kinect depth image does not match the ")
+            TEXT("calibration."));
+        return;
+    }
+
+    k4a::image colour;
+    if (this->PointCloudColours && this->_registration.IsValid()) {
+        colour = capture.get_color_image();
+
+        if (colour && (colour.get_format() != K4A_IMAGE_FORMAT_COLOR_BGRA32)) {
+            try {
+                colour = FAzureKinectColourDecoder::Decode(colour,
+                    *this->_colourPool);
+            } catch (k4a::error ex) {
+                FString msg(ANSI_TO_TCHAR(ex.what()));
+                UE_LOG(AzureKinectDeviceLog,
+                    Error,
+                    TEXT("Failed to allocate colour image: %s"), *msg);
+                colour.reset();
+            }
+        }
+    }
+
+    // If readers pin all snapshots, we skip the frame rather than waiting.
+    auto cloud = this->_pointClouds.BeginPublish();
+    if (cloud == nullptr) {
+        return;
+    }
+
+    auto start = FPlatformTime::Seconds();
+
+    assert(depth.get_stride_bytes() == 2 * width);
+    const auto src = reinterpret_cast<const uint16 *>(depth.get_buffer());
+    cloud->Positions.SetNumUninitialized(width * height, EAllowShrinking::No);
+
+    if (colour) {
+        assert(colour.get_stride_bytes() == 4 * colour.get_width_pixels());
+        cloud->Colours.SetNumUninitialized(width * height, EAllowShrinking::No);
+        this->_registration.ColourToDepth(
+            reinterpret_cast<uint32 *>(cloud->Colours.GetData()),
+            reinterpret_cast<const uint32 *>(colour.get_buffer()),
+            src,
+            this->_workers,
+            this->ConversionTileRows);
+    } else {
+        cloud->Colours.Reset();
+    }
+
+    this->_pointCloudRows.SetNumUninitialized(height, EAllowShrinking::No);
+
+    auto positions = cloud->Positions.GetData();
+    auto colours = colour ? cloud->Colours.GetData() : nullptr;
+    auto rows = this->_pointCloudRows.GetData();
+    const auto raysX = this->_registration.GetRaysX();
+    const auto raysY = this->_registration.GetRaysY();
+
+    // Each row is compacted to its valid points in parallel, which leaves
+    // gaps between the rows that are closed afterwards.
+    this->_workers.ParallelForTiles(height, this->ConversionTileRows,
+            [=](const int32 b, const int32 e) {
+        for (int32 r = b; r < e; ++r) {
+            const auto offset = r * width;
+            auto p = positions + offset;
+            auto c = (colours != nullptr) ? colours + offset : nullptr;
+            auto d = src + offset;
+
+            FAzureKinectConversion::Unproject(reinterpret_cast<float *>(p),
+                d,
+                raysX + offset,
+                raysY + offset,
+                width);
+
+            int32 n = 0;
+            for (int32 i = 0; i < width; ++i) {
+                if ((d[i] != 0) && !FMath::IsNaN(p[i].Y)) {
+                    p[n] = p[i];
+                    if (c != nullptr) {
+                        c[n] = c[i];
+                    }
+                    ++n;
+                }
+            }
+
+            rows[r] = n;
+        }
+    });
+
+    int32 cnt = 0;
+    for (int32 r = 0; r < height; ++r) {
+        const auto offset = r * width;
+        if (cnt != offset) {
+            FMemory::Memmove(positions + cnt,
+                positions + offset,
+                rows[r] * sizeof(FVector3f));
+            if (colours != nullptr) {
+                FMemory::Memmove(colours + cnt,
+                    colours + offset,
+                    rows[r] * sizeof(FColor));
+            }
+        }
+
+        cnt += rows[r];
+    }
+
+    cloud->Positions.SetNum(cnt, EAllowShrinking::No);
+    if (colours != nullptr) {
+        cloud->Colours.SetNum(cnt, EAllowShrinking::No);
+    }
+
+    auto& statistics = cloud->Statistics;
+    statistics.ValidPoints = cnt;
+
+    {
+        const auto end = FPlatformTime::Seconds();
+        statistics.GenerationTime = static_cast<float>(1000.0 * (end - start));
+        start = end;
+    }
+
+    statistics.Points = this->_decimation.Decimate(*cloud,
+        this->PointCloudVoxelSize,
+        this->PointCloudMaxPoints,
+        this->PointCloudAveraging);
+    statistics.VoxelSize = this->_decimation.GetVoxelSize();
+    statistics.DecimationTime = static_cast<float>(
+        1000.0 * (FPlatformTime::Seconds() - start));
+
+    cloud->FrameInfo = this->GetFrameInfo(capture);
+    cloud->Sequence = ++this->_pointCloudSequence;
+    this->_pointClouds.EndPublish();
+}
+
+
+/*
+ * UAzureKinectDevice::CaptureSensorTexture
+ */
+void UAzureKinectDevice::CaptureSensorTexture(k4a::capture& capture,
+        const k4abt::frame *frame,
+        FAzureKinectTextureUploads& uploads) {
+    assert(capture);
+
+    auto depth = capture.get_depth_image();
+    auto infrared = capture.get_ir_image();
+    if (!depth || !infrared) {
+        UE_LOG(AzureKinectDeviceLog,
+            Verbose,
+            TEXT("Azure Kinect depth or infrared capture is invalid."));
+        return;
+    }
+
+    const auto width = depth.get_width_pixels();
+    const auto height = depth.get_height_pixels();
+
+    if ((width == 0) || (height == 0)
+            || (infrared.get_width_pixels() != width)
+            || (infrared.get_height_pixels() != height)) {
+        UE_LOG(AzureKinectDeviceLog,
+            Warning,
+            TEXT("Azure Kinect depth and infrared images do not match."));
+        return;
+    }
+
+    k4a::image indexMap;
+    if (frame != nullptr) {
+        indexMap = frame->get_body_index_map();
+
+        if (indexMap && ((indexMap.get_width_pixels() != width)
+                || (indexMap.get_height_pixels() != height))) {
+            UE_LOG(AzureKinectDeviceLog,
+                Warning,
+                TEXT("Body index map does not match the depth image."));
+            indexMap.reset();
+        }
+    }
+
+    const auto format = EPixelFormat::PF_R16G16B16A16_UINT;
+    if (!HasSize(this->SensorTexture, width, height, format)) {
+        this->SensorTexture->InitCustomFormat(width, height, format, true);
+        // There is no render target format for 16-bit integers, but the
+        // override format set by InitCustomFormat takes precedence anyway.
+        this->SensorTexture->RenderTargetFormat
+            = ETextureRenderTargetFormat::RTF_RGBA16f;
+        this->SensorTexture->UpdateResource();
+
+    } else {
+        k4a::image data;
+
+        try {
+            data = this->_sensorPool->Acquire(K4A_IMAGE_FORMAT_CUSTOM,
+                width,
+                height,
+                8 * width);
+        } catch (k4a::error ex) {
+            FString msg(ANSI_TO_TCHAR(ex.what()));
+            UE_LOG(AzureKinectDeviceLog,
+                Error,
+                TEXT("Failed to allocate sensor texture data: %s"), *msg);
+            return;
+        }
+
+        auto dst = reinterpret_cast<uint16 *>(data.get_buffer());
+        auto d = reinterpret_cast<const uint16 *>(depth.get_buffer());
+        auto r = reinterpret_cast<const uint16 *>(infrared.get_buffer());
+        auto b = indexMap ? indexMap.get_buffer() : nullptr;
+
+        this->_workers.ParallelForTiles(height, this->ConversionTileRows,
+                [dst, d, r, b, width](const int32 begin, const int32 end) {
+            const auto offset = begin * width;
+            FAzureKinectConversion::Pack16(dst + 4 * offset,
+                d + offset,
+                r + offset,
+                (b != nullptr) ? b + offset : nullptr,
+                (end - begin) * width);
+        });
+
+        uploads.Emplace(EKinectStream::SENSOR,
+            this->SensorTexture,
+            MoveTemp(data),
+            width,
+            height,
+            8 * width);
+    }
+}
+
+
+/*
+ * UAzureKinectDevice::ConvertAsync
+ */
+void UAzureKinectDevice::ConvertAsync(void) {
+    k4a::capture capture;
+
+    if (!this->_conversionQueue.Pop(capture, this->_frameTime)) {
+        return;
+    }
+
+    FAzureKinectTextureUploads uploads;
+    this->ConvertCapture(capture, nullptr, uploads);
+    this->_uploader->Submit(MoveTemp(uploads));
+}
+
+
+/*
+ * UAzureKinectDevice::ConvertCapture
+ */
+void UAzureKinectDevice::ConvertCapture(k4a::capture& capture,
+        const k4abt::frame *frame,
+        FAzureKinectTextureUploads& uploads) {
+    // The streams are independent of each other, so each one collects its
+    // uploads separately and we merge them once all are done.
+    FAzureKinectTextureUploads streams[5];
+
+    // The filtered images go into a copy of the handle, because the caller
+    // may still pass the original capture to the body tracker.
+    auto source = capture;
+    if (source
+            && this->DepthFilter.Enabled
+            && (this->DepthMode != EKinectDepthMode::OFF)) {
+        this->FilterDepth(source);
+    }
+
+    const auto cnt = static_cast<int32>(UE_ARRAY_COUNT(streams));
+    this->_workers.ParallelFor(cnt, [&](const int32 i) {
+        switch (static_cast<EKinectStream>(i)) {
+            case EKinectStream::COLOUR:
+                if (source
+                        && (this->ColourResolution
+                            != EKinectColourResolution::RESOLUTION_OFF)
+                        && (this->ColourTexture != nullptr)) {
+                    this->CaptureColourTexture(source, streams[i]);
+                }
+                break;
+
+            case EKinectStream::DEPTH:
+                if (source
+                        && (this->DepthMode != EKinectDepthMode::OFF)
+                        && (this->DepthTexture != nullptr)) {
+                    this->CaptureDepthTexture(source, streams[i]);
+                }
+                break;
+
+            case EKinectStream::INFRARED:
+                if (source
+                        && (this->DepthMode != EKinectDepthMode::OFF)
+                        && (this->InfraredTexture != nullptr)) {
+                    this->CaptureInfraredTexture(source, streams[i]);
+                }
+                break;
+
+            case EKinectStream::BODY_INDEX:
+                if ((frame != nullptr)
+                        && (this->BodyIndexTexture != nullptr)) {
+                    this->CaptureBodyIndexTexture(*frame, streams[i]);
+                }
+                break;
+
+            case EKinectStream::SENSOR:
+                // If there is a body tracker, we need to wait for its
+                // result, which comes with the original capture. The body
+                // index map must match the depth the tracker saw, so this
+                // one is never filtered.
+                if ((this->DepthMode != EKinectDepthMode::OFF)
+                        && (this->SensorTexture != nullptr)) {
+                    if (frame != nullptr) {
+                        auto c = frame->get_capture();
+                        if (c) {
+                            this->CaptureSensorTexture(c, frame, streams[i]);
+                        }
+                    } else if (source && !this->_bodyTracker) {
+                        this->CaptureSensorTexture(source, nullptr,
+                            streams[i]);
+                    }
+                }
+                break;
+        }
+    });
+
+    // The body index map and the sensor texture come from the capture of the
+    // tracker if there is one, which might be older than 'capture'.
+    {
+        const auto captureInfo = source
+            ? this->GetFrameInfo(source)
+            : FAzureKinectFrameInfo();
+        const auto frameInfo = (frame != nullptr)
+            ? this->GetFrameInfo(*frame)
+            : FAzureKinectFrameInfo();
+
+        for (int32 i = 0; i < cnt; ++i) {
+            const auto stream = static_cast<EKinectStream>(i);
+            const auto fromFrame = (frame != nullptr)
+                && ((stream == EKinectStream::BODY_INDEX)
+                || (stream == EKinectStream::SENSOR));
+            for (auto& u : streams[i]) {
+                u.FrameInfo = fromFrame ? frameInfo : captureInfo;
+            }
+
+            uploads.Append(MoveTemp(streams[i]));
+        }
+    }
+
+    // The point cloud is tiled itself, so there is nothing to gain from
+    // running it alongside the textures.
+    if (source
+            && this->GeneratePointCloud
+            && (this->DepthMode != EKinectDepthMode::OFF)) {
+        this->CapturePointCloud(source);
+    }
+
+    if (capture) {
+        this->_cntConverted.Increment();
+    }
+}
+
+
+/*
+ * UAzureKinectDevice::Expand16
+ */
+void UAzureKinectDevice::Expand16(uint8 *dst,
+        const uint16 *src,
+        const int32 width,
+        const int32 height) {
+    this->_workers.ParallelForTiles(height, this->ConversionTileRows,
+            [dst, src, width](const int32 begin, const int32 end) {
+        FAzureKinectConversion::Expand16(dst + 4 * begin * width,
+            src + begin * width,
+            (end - begin) * width);
+    });
+}
+
+
+/*
+ * UAzureKinectDevice::FilterDepth
+ */
+void UAzureKinectDevice::FilterDepth(k4a::capture& capture) {
+    auto depth = capture.get_depth_image();
+    if (!depth) {
+        return;
+    }
+
+    const auto width = depth.get_width_pixels();
+    const auto height = depth.get_height_pixels();
+
+    try {
+        auto filtered = this->_depthFilterPool->Acquire(
+            K4A_IMAGE_FORMAT_DEPTH16,
+            width,
+            height,
+            width * static_cast<int>(sizeof(uint16)));
+        filtered.set_device_timestamp(depth.get_device_timestamp());
+        filtered.set_system_timestamp(depth.get_system_timestamp());
+
+        this->_depthFilter.Apply(
+            reinterpret_cast<uint16 *>(filtered.get_buffer()),
+            reinterpret_cast<const uint16 *>(depth.get_buffer()),
+            width,
+            height,
+            this->DepthFilter,
+            this->_workers,
+            this->ConversionTileRows);
+
+        auto retval = k4a::capture::create();
+        retval.set_color_image(capture.get_color_image());
+        retval.set_depth_image(filtered);
+        retval.set_ir_image(capture.get_ir_image());
+        retval.set_temperature_c(capture.get_temperature_c());
+        capture = MoveTemp(retval);
+
+    } catch (k4a::error ex) {
+        FString msg(ANSI_TO_TCHAR(ex.what()));
+        UE_LOG(AzureKinectDeviceLog,
+            Error,
+            TEXT("Failed to filter depth image: %s"), *msg);
+    }
+}
+
+
+/*
+ * UAzureKinectDevice::GetBodyIndexLut
+ */
+void UAzureKinectDevice::GetBodyIndexLut(const k4abt::frame& frame,
+        uint32 (&lut)[256]) const {
+    if (this->BodyIndexMode == EKinectBodyIndexMode::PALETTE) {
+        FScopeLock l(&this->_bodyIndexLock);
+        const auto& palette = this->_bodyIndexColours;
+        const auto cntBodies = frame.get_num_bodies();
+        const auto cntColours = static_cast<uint32>(palette.Num());
+
+        for (uint32 i = 0; i < UE_ARRAY_COUNT(lut); ++i) {
+            if ((i < cntBodies) && (cntColours > 0)) {
+                const auto id = frame.get_body_id(i);
+                lut[i] = palette[id % cntColours];
+            } else {
+                lut[i] = 0;
+            }
+        }
+
+    } else {
+        for (uint32 i = 0; i < UE_ARRAY_COUNT(lut); ++i) {
+            lut[i] = 0xFF000000 | (i << 16) | (i << 8) | i;
+        }
+    }
+}
+
+
+/*
+ * UAzureKinectDevice::GetFrameInfo
+ */
+FAzureKinectFrameInfo UAzureKinectDevice::GetFrameInfo(
+        const k4a::capture& capture) const {
+    const auto image = GetReferenceImage(capture);
+    return image
+        ? this->GetFrameInfo(image.get_device_timestamp(),
+            image.get_system_timestamp())
+        : FAzureKinectFrameInfo();
+}
+
+
+/*
+ * UAzureKinectDevice::GetFrameInfo
+ */
+FAzureKinectFrameInfo UAzureKinectDevice::GetFrameInfo(
+        const k4abt::frame& frame) const {
+    return this->GetFrameInfo(frame.get_device_timestamp(),
+        frame.get_system_timestamp());
+}
+
+
+/*
+ * UAzureKinectDevice::GetFrameInfo
+ */
+FAzureKinectFrameInfo UAzureKinectDevice::GetFrameInfo(
+        const std::chrono::microseconds deviceTimestamp,
+        const std::chrono::nanoseconds systemTimestamp) const {
+    FAzureKinectFrameInfo retval;
+    retval.DeviceTimestamp = deviceTimestamp.count();
+    retval.SystemTimestamp = systemTimestamp.count();
+
+    // The capture stage has numbered the frame before forwarding it, so it
+    // is normally still in the history. If it has been evicted, which only
+    // happens if a stage lags far behind, we derive its number from the
+    // newest frame, which is at least consistent with the numbers of the
+    // frames that followed.
+    FScopeLock l(&this->_frameSequenceLock);
+    if (this->_frameSequence < 0) {
+        return retval;
+    }
+
+    for (const auto& f : this->_frameSequences) {
+        if (f.DeviceTimestamp == retval.DeviceTimestamp) {
+            retval.Sequence = f.Sequence;
+            return retval;
+        }
+    }
+
+    const auto& newest = this->_frameSequences[this->_frameSequence
+        % FrameSequenceHistory];
+    retval.Sequence = newest.Sequence - FMath::RoundToInt64(
+        static_cast<double>(newest.DeviceTimestamp - retval.DeviceTimestamp)
+        * this->_framesPerSecond / 1000000.0);
+
+    return retval;
+}
+
+
+/*
+ * UAzureKinectDevice::PopTrackerResultAsync
+ */
+void UAzureKinectDevice::PopTrackerResultAsync(void) {
+    k4abt::frame frame;
+
+    try {
+        if (!this->_bodyTracker.pop_result(&frame, this->_frameTime)) {
+            UE_LOG(AzureKinectDeviceLog,
+                VeryVerbose,
+                TEXT("No body tracking frame was completed in time."));
+            return;
+        }
+    } catch (k4a::error& ex) {
+        FString msg(ANSI_TO_TCHAR(ex.what()));
+        UE_LOG(AzureKinectDeviceLog,
+            Error,
+            TEXT("Failed to obtain body tracking frame: %s"), *msg);
+        return;
+    }
+
+    this->_cntTracked.Increment();
+
+    FAzureKinectTextureUploads uploads;
+    k4a::capture capture;
+
+    if (this->_texturesFromTracker) {
+        capture = frame.get_capture();
+    }
+
+    this->ConvertCapture(capture, &frame, uploads);
+    this->_uploader->Submit(MoveTemp(uploads));
+    this->UpdateSkeletons(frame);
+}
+
+
+/*
+ * UAzureKinectDevice::TrackAsync
+ */
+void UAzureKinectDevice::TrackAsync(void) {
+    // If the tracker was full the last time, we retry the same capture, which
+    // keeps the tracking queue filling up such that its policy is applied.
+    if (!this->_pendingTrackerCapture
+            && !this->_trackingQueue.Pop(this->_pendingTrackerCapture,
+            this->_frameTime)) {
+        return;
+    }
+
+    try {
+        if (this->_bodyTracker.enqueue_capture(this->_pendingTrackerCapture,
+                this->_frameTime)) {
+            this->_pendingTrackerCapture.reset();
+            this->_cntTrackerEnqueued.Increment();
+        } else {
+            UE_LOG(AzureKinectDeviceLog,
+                VeryVerbose,
+                TEXT("The body tracker queue is full."));
+        }
+    } catch (k4a::error& ex) {
+        FString msg(ANSI_TO_TCHAR(ex.what()));
+        UE_LOG(AzureKinectDeviceLog,
+            Error,
+            TEXT("Failed to queue body tracking: %s"), *msg);
+        this->_pendingTrackerCapture.reset();
+    }
+}
+
+
 /*
  * UAzureKinectDevice::UpdateAsync
  */
@@ -765,86 +2104,148 @@ void UAzureKinectDevice::UpdateAsync(void) {
             UE_LOG(AzureKinectDeviceLog,
                 Verbose,
                 TEXT("Azure Kinect capture timed out."));
+            this->_cntCaptureTimeouts.Increment();
+            return;
         }
     } catch (k4a::error ex) {
         FString msg(ANSI_TO_TCHAR(ex.what()));
         UE_LOG(AzureKinectDeviceLog,
             Error,
             TEXT("Failed capturing from Azure Kinect: %s"), *msg);
+        this->_cntCaptureTimeouts.Increment();
         return;
     }
 
-    if ((this->ColourResolution != EKinectColourResolution::RESOLUTION_OFF)
-            && (this->ColourTexture != nullptr)) {
-        this->CaptureColourTexture(capture);
+    this->_cntCaptured.Increment();
+    this->UpdateFrameSequence(capture);
+
+    // The capture is reference-counted, so both stages can share it. Unless
+    // the user explicitly asked for the tracking queue to block, pushing does
+    // not block, which ensures that a slow stage cannot make us miss frames
+    // on the device.
+    if (this->_trackingThread != nullptr) {
+        this->_trackingQueue.Push(k4a::capture(capture));
     }
 
-    if ((this->DepthMode != EKinectDepthMode::OFF)
-            && (this->DepthTexture != nullptr)) {
-        this->CaptureDepthTexture(capture);
+    if (this->_conversionThread != nullptr) {
+        this->_conversionQueue.Push(MoveTemp(capture));
     }
+}
 
-    if ((this->DepthMode != EKinectDepthMode::OFF)
-            && (this->InfraredTexture != nullptr)) {
-        this->CaptureInfraredTexture(capture);
+
+/*
+ * UAzureKinectDevice::UpdateBodyIndexColours
+ */
+void UAzureKinectDevice::UpdateBodyIndexColours(void) {
+    // Note: the packed ABGR representation is RGBA in little-endian memory.
+    TArray<uint32> colours;
+    colours.Reserve(this->BodyIndexPalette.Num());
+    for (const auto& c : this->BodyIndexPalette) {
+        colours.Add(c.ToPackedABGR());
     }
 
-    if ((this->SkeletonTracking != EKinectTrackerProcessing::DISABLED)
-            && this->_bodyTracker) {
-        this->UpdateSkeletons(capture);
+    FScopeLock l(&this->_bodyIndexLock);
+    this->_bodyIndexColours = MoveTemp(colours);
+}
+
+
+/*
+ * UAzureKinectDevice::UpdateFrameSequence
+ */
+void UAzureKinectDevice::UpdateFrameSequence(const k4a::capture& capture) {
+    const auto image = GetReferenceImage(capture);
+    if (!image) {
+        return;
     }
+
+    const auto timestamp = static_cast<int64>(
+        image.get_device_timestamp().count());
+
+    FScopeLock l(&this->_frameSequenceLock);
+    if (this->_frameSequence < 0) {
+        this->_frameSequence = 0;
+
+    } else {
+        // Frames the device has dropped advance the number by the frame
+        // periods they would have taken. The delta to the previous frame is
+        // only ever a few periods, so rounding it is robust against jitter
+        // regardless of the absolute timestamp. A capture always advances
+        // the number such that it remains unique.
+        const auto& previous = this->_frameSequences[this->_frameSequence
+            % FrameSequenceHistory];
+        const auto periods = FMath::RoundToInt64(
+            static_cast<double>(timestamp - previous.DeviceTimestamp)
+            * this->_framesPerSecond / 1000000.0);
+        this->_frameSequence += FMath::Max(periods, static_cast<int64>(1));
+    }
+
+    auto& f = this->_frameSequences[this->_frameSequence
+        % FrameSequenceHistory];
+    f.DeviceTimestamp = timestamp;
+    f.Sequence = this->_frameSequence;
 }
 
 
 /*
  * UAzureKinectDevice::UpdateSkeletons
  */
-void UAzureKinectDevice::UpdateSkeletons(k4a::capture& capture) {
-    assert(capture);
-    k4abt::frame frame;
-    TArray<int32> ids;
+void UAzureKinectDevice::UpdateSkeletons(k4abt::frame& frame) {
+    assert(frame);
 
-    try {
-        if (!this->_bodyTracker.enqueue_capture(capture, this->_frameTime)) {
-            UE_LOG(AzureKinectDeviceLog,
-                Warning,
-                TEXT("Failed to queue body tracking."));
-            return;
-        }
+    // Acquire the last snapshot before publishing a new one, because it
+    // provides the joints that are held and the start of the interpolation
+    // in GetSkeletonsAt.
+    const auto previous = this->_skeletons.Acquire();
 
-        if (!this->_bodyTracker.pop_result(&frame, this->_frameTime)) {
-            UE_LOG(AzureKinectDeviceLog,
-                Warning,
-                TEXT("Failed to obtain body tracking frame in time."));
-            return;
-        }
-    } catch (k4a::error& ex) {
-        FString msg(ANSI_TO_TCHAR(ex.what()));
+    auto snapshot = this->_skeletons.BeginPublish();
+    if (snapshot == nullptr) {
         UE_LOG(AzureKinectDeviceLog,
-            Error,
-            TEXT("Failed to obtain body tracking frame: %s"), *msg);
-    }
-
-    if (this->BodyIndexTexture) {
-        this->CaptureBodyIndexTexture(frame);
+            Verbose,
+            TEXT("Skipping skeleton update as all snapshots are in use."));
+        return;
     }
 
-    FScopeLock l(&this->_lock);
-    this->_cntTrackedSkeletons = frame.get_num_bodies();
-    this->_skeletons.Reset(this->_cntTrackedSkeletons);
+    // Note that the snapshot might be recycled, so we resize the array
+    // rather than resetting it such that its memory is reused. The joints
+    // are stored inline, so there is no allocation per body.
+    const int32 cntSkeletons = frame.get_num_bodies();
+    snapshot->FrameInfo = this->GetFrameInfo(frame);
+    snapshot->Sequence = ++this->_skeletonSequence;
+    snapshot->Skeletons.SetNumUninitialized(cntSkeletons);
 
-    for (int32 s = 0; s < this->_cntTrackedSkeletons; ++s) {
+    for (int32 s = 0; s < cntSkeletons; ++s) {
         k4abt_body_t body;
-        FAzureKinectSkeleton skeleton;
+        auto& skeleton = snapshot->Skeletons[s];
 
         frame.get_body_skeleton(s, body.skeleton);
         skeleton.ID = frame.get_body_id(s);
 
-        skeleton.Joints.Reset(K4ABT_JOINT_COUNT);
         for (int32 j = 0; j < K4ABT_JOINT_COUNT; ++j) {
-            skeleton.Joints.Push(ToTransform(body.skeleton.joints[j], j));
+            ToJoint(skeleton.Positions[j],
+                skeleton.Rotations[j],
+                skeleton.Confidences[j],
+                body.skeleton.joints[j]);
         }
 
-        this->_skeletons.Push(skeleton);
+        this->ApplyJointPolicy(skeleton, previous.Get());
+    }
+
+    {
+        this->_skeletonFilter.Apply(snapshot->Skeletons.GetData(),
+            cntSkeletons,
+            snapshot->FrameInfo.GetDeviceTime(),
+            this->SkeletonFilter);
     }
+
+    // The skeletons are trivially copyable, so keeping the previous frame
+    // costs a single memcpy into memory the snapshot already owns.
+    snapshot->PreviousSkeletons.Reset();
+    if (previous) {
+        snapshot->PreviousFrameInfo = previous->FrameInfo;
+        snapshot->PreviousSkeletons.Append(previous->Skeletons);
+    } else {
+        snapshot->PreviousFrameInfo = FAzureKinectFrameInfo();
+    }
+
+    this->_skeletons.EndPublish();
 }
@@ -37,19 +37,24 @@ DEFINE_LOG_CATEGORY(AzureKinectThreadLog);
  * FAzureKinectDeviceThread::FAzureKinectDeviceThread
  */
 FAzureKinectDeviceThread::FAzureKinectDeviceThread(
-        UAzureKinectDevice *Device)
+        UAzureKinectDevice *Device,
+        WorkType Work,
+        const TCHAR *Name)
     : _device(Device),
         _stopCounter(0),
-        _thread(nullptr) {
+        _thread(nullptr),
+        _work(Work) {
+    check(Work != nullptr);
     this->_thread= FRunnableThread::Create(this,
-        TEXT("Azure Kinect device thread"),
+        Name,
         0,
         TPri_BelowNormal); //windows default = 8mb for thread, could specify more
 
     if (!this->_thread) {
         UE_LOG(AzureKinectThreadLog,
             Error,
-            TEXT("Failed to create Azure Kinect device worker thread."));
+            TEXT("Failed to create Azure Kinect worker thread \"%s\"."),
+            Name);
     }
 
 }
@@ -86,8 +91,9 @@ uint32 FAzureKinectDeviceThread::Run(void) {
     }
 
     while (this->_stopCounter.GetValue() == 0) {
-        // Do the Kinect capture, enqueue, pop body frame stuff
-        this->_device->UpdateAsync();
+        // Run one iteration of our pipeline stage, which is expected to block
+        // at most for one frame such that we can react to stop requests.
+        (this->_device->*this->_work)();
     }
 
     return 0;
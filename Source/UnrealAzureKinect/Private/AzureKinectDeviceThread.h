@@ -38,11 +38,23 @@ DECLARE_LOG_CATEGORY_EXTERN(AzureKinectThreadLog, Log, All);
 class UAzureKinectDevice;
 
 
+/// <summary>
+/// A worker thread running one stage of the capture pipeline of a
+/// <see cref="UAzureKinectDevice" />.
+/// </summary>
 class FAzureKinectDeviceThread : public FRunnable {
 
 public:
 
-    FAzureKinectDeviceThread(UAzureKinectDevice *Device);
+    /// <summary>
+    /// The type of the method of the device that is called repeatedly by the
+    /// thread until it is stopped.
+    /// </summary>
+    typedef void (UAzureKinectDevice::*WorkType)(void);
+
+    FAzureKinectDeviceThread(UAzureKinectDevice *Device,
+        WorkType Work,
+        const TCHAR *Name);
 
     virtual ~FAzureKinectDeviceThread();
 
@@ -62,4 +74,5 @@ private:
     UAzureKinectDevice *_device;
     FThreadSafeCounter _stopCounter;
     FRunnableThread *_thread;
+    WorkType _work;
 };
@@ -0,0 +1,172 @@
+﻿// <copyright file="AzureKinectGpuBuffers.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectGpuBuffers.h"
+
+#include <cassert>
+
+#include "RenderingThread.h"
+
+#include "k4abt.hpp"
+
+
+static_assert(FAzureKinectGpuBuffers::JointCount == K4ABT_JOINT_COUNT,
+    "The GPU buffers must hold all joints of a skeleton.");
+
+
+/*
+ * FAzureKinectGpuBuffers::FAzureKinectGpuBuffers
+ */
+FAzureKinectGpuBuffers::FAzureKinectGpuBuffers(void)
+    : _colourCount(0),
+    _pointCloudSequence(0),
+    _pointCount(0),
+    _skeletonCount(0),
+    _skeletonSequence(0) { }
+
+
+/*
+ * FAzureKinectGpuBuffers::~FAzureKinectGpuBuffers
+ */
+FAzureKinectGpuBuffers::~FAzureKinectGpuBuffers(void) {
+    // The last reference might be dropped on any thread, but the resources
+    // must be released on the render thread, so the command takes over our
+    // references.
+    ENQUEUE_RENDER_COMMAND(ReleaseAzureKinectGpuBuffers)(
+            [colours = this->_colours,
+            joints = this->_joints,
+            points = this->_points,
+            skeletonIDs = this->_skeletonIDs](
+            FRHICommandListImmediate&) mutable {
+        colours.Release();
+        joints.Release();
+        points.Release();
+        skeletonIDs.Release();
+    });
+}
+
+
+/*
+ * FAzureKinectGpuBuffers::Update
+ */
+void FAzureKinectGpuBuffers::Update(FRHICommandListBase& cmdList,
+        const PointCloudType& pointCloud,
+        const SkeletonsType& skeletons) {
+    assert(IsInRenderingThread());
+
+    // Sequence numbers start at one, so the initial state uploads empty
+    // buffers once and thereby makes sure that the views exist.
+    const auto pointCloudSequence = pointCloud ? pointCloud->Sequence : 0;
+    if ((pointCloudSequence != this->_pointCloudSequence)
+            || (this->_points.SRV == nullptr)) {
+        const auto cntPoints = pointCloud ? pointCloud->Positions.Num() : 0;
+        const auto cntColours = pointCloud ? pointCloud->Colours.Num() : 0;
+        assert((cntColours == 0) || (cntColours == cntPoints));
+
+        {
+            auto dst = Lock(cmdList, this->_points,
+                TEXT("AzureKinectPoints"),
+                PF_R32_FLOAT,
+                sizeof(float),
+                3 * cntPoints);
+            if (cntPoints > 0) {
+                FMemory::Memcpy(dst, pointCloud->Positions.GetData(),
+                    cntPoints * sizeof(FVector3f));
+            }
+            cmdList.UnlockBuffer(this->_points.Buffer);
+        }
+
+        // BGRA views of typed buffers are not supported by all RHIs, so the
+        // colours are viewed as RGBA and swizzled in the shaders.
+        {
+            auto dst = Lock(cmdList, this->_colours,
+                TEXT("AzureKinectColours"),
+                PF_R8G8B8A8,
+                sizeof(FColor),
+                cntColours);
+            if (cntColours > 0) {
+                FMemory::Memcpy(dst, pointCloud->Colours.GetData(),
+                    cntColours * sizeof(FColor));
+            }
+            cmdList.UnlockBuffer(this->_colours.Buffer);
+        }
+
+        this->_colourCount = cntColours;
+        this->_pointCloudSequence = pointCloudSequence;
+        this->_pointCount = cntPoints;
+    }
+
+    const auto skeletonSequence = skeletons ? skeletons->Sequence : 0;
+    if ((skeletonSequence != this->_skeletonSequence)
+            || (this->_joints.SRV == nullptr)) {
+        const auto cntSkeletons = skeletons ? skeletons->Skeletons.Num() : 0;
+
+        {
+            auto dst = static_cast<FVector4f *>(Lock(cmdList, this->_joints,
+                TEXT("AzureKinectJoints"),
+                PF_A32B32G32R32F,
+                sizeof(FVector4f),
+                2 * JointCount * cntSkeletons));
+
+            for (int32 s = 0; s < cntSkeletons; ++s) {
+                const auto& skeleton = skeletons->Skeletons[s];
+
+                for (int32 j = 0; j < JointCount; ++j) {
+                    const auto& p = skeleton.Positions[j];
+                    const auto& r = skeleton.Rotations[j];
+                    const auto w = (skeleton.Confidences[j]
+                        != EKinectJointConfidence::NONE) ? 1.0f : 0.0f;
+                    *dst++ = FVector4f(p.X, p.Y, p.Z, w);
+                    *dst++ = FVector4f(r.X, r.Y, r.Z, r.W);
+                }
+            }
+
+            cmdList.UnlockBuffer(this->_joints.Buffer);
+        }
+
+        {
+            auto dst = static_cast<int32 *>(Lock(cmdList, this->_skeletonIDs,
+                TEXT("AzureKinectSkeletonIDs"),
+                PF_R32_SINT,
+                sizeof(int32),
+                cntSkeletons));
+            for (int32 s = 0; s < cntSkeletons; ++s) {
+                dst[s] = skeletons->Skeletons[s].ID;
+            }
+            cmdList.UnlockBuffer(this->_skeletonIDs.Buffer);
+        }
+
+        this->_skeletonCount = cntSkeletons;
+        this->_skeletonSequence = skeletonSequence;
+    }
+}
+
+
+/*
+ * FAzureKinectGpuBuffers::Lock
+ */
+void *FAzureKinectGpuBuffers::Lock(FRHICommandListBase& cmdList,
+        FReadBuffer& buffer,
+        const TCHAR *name,
+        const EPixelFormat format,
+        const uint32 bytesPerElement,
+        const int32 cnt) {
+    // Empty buffers cannot be created, so there is always one element, which
+    // also allows for binding the view if there is no data.
+    const auto size = FMath::Max(cnt, 1) * bytesPerElement;
+
+    if (buffer.NumBytes < size) {
+        // Grow to the next power of two such that point clouds of varying
+        // size do not cause reallocations every frame.
+        const auto capacity = FMath::RoundUpToPowerOfTwo(
+            FMath::Max(cnt, 1));
+        buffer.Release();
+        buffer.Initialize(cmdList, name, bytesPerElement, capacity, format,
+            BUF_Dynamic);
+    }
+
+    return cmdList.LockBuffer(buffer.Buffer, 0, size, RLM_WriteOnly);
+}
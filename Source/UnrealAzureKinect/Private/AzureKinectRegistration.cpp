@@ -0,0 +1,463 @@
+﻿// <copyright file="AzureKinectRegistration.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectRegistration.h"
+
+#include <cassert>
+#include <limits>
+
+#include "AzureKinectConversion.h"
+
+
+namespace {
+
+    /// <summary>
+    /// The relative difference of the depths of a quad beyond which the quad
+    /// is considered to span a discontinuity.
+    /// </summary>
+    constexpr float DiscontinuityThreshold = 1.0f / 16.0f;
+
+    /// <summary>
+    /// The largest extent of a quad in colour pixels that is rasterised,
+    /// which prevents degenerate quads from covering large areas.
+    /// </summary>
+    constexpr float MaxQuadSize = 32.0f;
+
+    /*
+     * ::Splat
+     */
+    inline void Splat(uint16 *dst, const float z) {
+        const auto d = static_cast<uint16>(FMath::Clamp(
+            FMath::FloorToInt(z + 0.5f), 1, 0xFFFF));
+        if ((*dst == 0) || (d < *dst)) {
+            *dst = d;
+        }
+    }
+
+} /* namespace */
+
+
+/*
+ * FAzureKinectRegistration::FAzureKinectRegistration
+ */
+FAzureKinectRegistration::FAzureKinectRegistration(void)
+        : _colourGridHeight(0),
+        _colourGridMinX(0.0f),
+        _colourGridMinY(0.0f),
+        _colourGridScale(0.0f),
+        _colourGridWidth(0),
+        _colourHeight(0),
+        _colourWidth(0),
+        _depthHeight(0),
+        _depthWidth(0) {
+    FMemory::Memzero(this->_transform);
+}
+
+
+/*
+ * FAzureKinectRegistration::ColourToDepth
+ */
+void FAzureKinectRegistration::ColourToDepth(uint32 *dst,
+        const uint32 *colour,
+        const uint16 *depth,
+        FAzureKinectWorkerPool& workers,
+        const int32 tileRows) const {
+    assert(this->IsValid());
+    assert(dst != nullptr);
+    assert(colour != nullptr);
+    assert(depth != nullptr);
+    const auto width = this->_depthWidth;
+
+    workers.ParallelForTiles(this->_depthHeight, tileRows,
+            [this, dst, colour, depth, width](const int32 b, const int32 e) {
+        float x[MaxDepthWidth];
+        float y[MaxDepthWidth];
+        float z[MaxDepthWidth];
+
+        for (int32 r = b; r < e; ++r) {
+            const auto offset = r * width;
+            FAzureKinectConversion::Reproject(x,
+                y,
+                z,
+                depth + offset,
+                this->_raysX.GetData() + offset,
+                this->_raysY.GetData() + offset,
+                this->_transform,
+                width);
+
+            auto d = dst + offset;
+            for (int32 i = 0; i < width; ++i) {
+                float u, v;
+                d[i] = 0;
+
+                if ((z[i] > 0.0f) && this->Project(u, v, x[i], y[i])) {
+                    const auto cu = FMath::FloorToInt(u + 0.5f);
+                    const auto cv = FMath::FloorToInt(v + 0.5f);
+                    if ((cu >= 0) && (cu < this->_colourWidth)
+                            && (cv >= 0) && (cv < this->_colourHeight)) {
+                        d[i] = colour[cv * this->_colourWidth + cu];
+                    }
+                }
+            }
+        }
+    });
+}
+
+
+/*
+ * FAzureKinectRegistration::DepthToColour
+ */
+void FAzureKinectRegistration::DepthToColour(uint16 *dst,
+        const uint16 *depth,
+        FAzureKinectWorkerPool& workers,
+        const int32 tileRows) {
+    assert(this->IsValid());
+    assert(dst != nullptr);
+    assert(depth != nullptr);
+
+    workers.ParallelForTiles(this->_depthHeight, tileRows,
+            [this, depth](const int32 b, const int32 e) {
+        this->ProjectRows(depth, b, e);
+    });
+
+    // The quads are rasterised in tiles of colour rows. Each tile visits all
+    // quads, but skips depth rows that do not project into the tile, such
+    // that every pixel is written by a single thread only.
+    const auto dh = this->_depthHeight;
+    const auto dw = this->_depthWidth;
+    const auto cw = this->_colourWidth;
+    const auto pu = this->_projectedU.GetData();
+    const auto pv = this->_projectedV.GetData();
+    const auto pz = this->_projectedZ.GetData();
+
+    workers.ParallelForTiles(this->_colourHeight, tileRows,
+            [this, dst, dh, dw, cw, pu, pv, pz](const int32 b, const int32 e) {
+        FMemory::Memzero(dst + b * cw, (e - b) * cw * sizeof(uint16));
+
+        for (int32 y = 0; y < dh; ++y) {
+            const auto y1 = FMath::Min(y + 1, dh - 1);
+            const auto minV = FMath::Min(this->_projectedMinV[y],
+                this->_projectedMinV[y1]);
+            const auto maxV = FMath::Max(this->_projectedMaxV[y],
+                this->_projectedMaxV[y1]);
+            if ((maxV < b - 1) || (minV > e)) {
+                continue;
+            }
+
+            for (int32 x = 0; x < dw; ++x) {
+                const auto i = y * dw + x;
+                const auto z0 = pz[i];
+                if (z0 <= 0.0f) {
+                    continue;
+                }
+
+                // The pixel itself.
+                {
+                    const auto cu = FMath::FloorToInt(pu[i] + 0.5f);
+                    const auto cv = FMath::FloorToInt(pv[i] + 0.5f);
+                    if ((cv >= b) && (cv < e) && (cu >= 0) && (cu < cw)) {
+                        Splat(dst + cv * cw + cu, z0);
+                    }
+                }
+
+                // The quad spanned with the right and lower neighbours.
+                if ((x + 1 >= dw) || (y + 1 >= dh)) {
+                    continue;
+                }
+
+                const int32 q[] = { i, i + 1, i + dw, i + dw + 1 };
+                auto minZ = z0;
+                auto maxZ = z0;
+                auto sumZ = 0.0f;
+                auto minU = pu[i];
+                auto maxU = pu[i];
+                auto quadMinV = pv[i];
+                auto quadMaxV = pv[i];
+                bool valid = true;
+
+                for (auto j : q) {
+                    const auto z = pz[j];
+                    valid = valid && (z > 0.0f);
+                    minZ = FMath::Min(minZ, z);
+                    maxZ = FMath::Max(maxZ, z);
+                    sumZ += z;
+                    minU = FMath::Min(minU, pu[j]);
+                    maxU = FMath::Max(maxU, pu[j]);
+                    quadMinV = FMath::Min(quadMinV, pv[j]);
+                    quadMaxV = FMath::Max(quadMaxV, pv[j]);
+                }
+
+                if (!valid
+                        || (maxZ - minZ > minZ * DiscontinuityThreshold)
+                        || (maxU - minU > MaxQuadSize)
+                        || (quadMaxV - quadMinV > MaxQuadSize)) {
+                    continue;
+                }
+
+                const auto r0 = FMath::Max(FMath::CeilToInt(quadMinV), b);
+                const auto r1 = FMath::Min(FMath::FloorToInt(quadMaxV), e - 1);
+                const auto c0 = FMath::Max(FMath::CeilToInt(minU), 0);
+                const auto c1 = FMath::Min(FMath::FloorToInt(maxU), cw - 1);
+                const auto z = 0.25f * sumZ;
+
+                for (int32 r = r0; r <= r1; ++r) {
+                    for (int32 c = c0; c <= c1; ++c) {
+                        Splat(dst + r * cw + c, z);
+                    }
+                }
+            }
+        }
+    });
+}
+
+
+/*
+ * FAzureKinectRegistration::Reset
+ */
+void FAzureKinectRegistration::Reset(const k4a::calibration& calibration) {
+    this->Reset();
+
+    const auto& dc = calibration.depth_camera_calibration;
+    const auto& cc = calibration.color_camera_calibration;
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+
+    // Compute the rays of the depth pixels, which are the points at a depth
+    // of one.
+    if ((dc.resolution_width > 0) && (dc.resolution_height > 0)) {
+        assert(dc.resolution_width <= MaxDepthWidth);
+        const auto cnt = dc.resolution_width * dc.resolution_height;
+        this->_raysX.SetNumUninitialized(cnt);
+        this->_raysY.SetNumUninitialized(cnt);
+
+        for (int32 y = 0, i = 0; y < dc.resolution_height; ++y) {
+            for (int32 x = 0; x < dc.resolution_width; ++x, ++i) {
+                k4a_float2_t p;
+                p.xy.x = static_cast<float>(x);
+                p.xy.y = static_cast<float>(y);
+                k4a_float3_t r;
+
+                if (calibration.convert_2d_to_3d(p, 1.0f,
+                        K4A_CALIBRATION_TYPE_DEPTH,
+                        K4A_CALIBRATION_TYPE_DEPTH,
+                        &r)) {
+                    this->_raysX[i] = r.xyz.x / r.xyz.z;
+                    this->_raysY[i] = r.xyz.y / r.xyz.z;
+                } else {
+                    this->_raysX[i] = nan;
+                    this->_raysY[i] = nan;
+                }
+            }
+        }
+
+        this->_depthHeight = dc.resolution_height;
+        this->_depthWidth = dc.resolution_width;
+        this->_projectedMaxV.SetNumUninitialized(this->_depthHeight);
+        this->_projectedMinV.SetNumUninitialized(this->_depthHeight);
+        this->_projectedU.SetNumUninitialized(cnt);
+        this->_projectedV.SetNumUninitialized(cnt);
+        this->_projectedZ.SetNumUninitialized(cnt);
+    }
+
+    if ((cc.resolution_width < 1) || (cc.resolution_height < 1)) {
+        return;
+    }
+
+    // Determine the extents of the colour image in normalised coordinates by
+    // unprojecting its border.
+    auto minX = std::numeric_limits<float>::max();
+    auto minY = std::numeric_limits<float>::max();
+    auto maxX = std::numeric_limits<float>::lowest();
+    auto maxY = std::numeric_limits<float>::lowest();
+
+    auto extend = [&](const float u, const float v) {
+        k4a_float2_t p;
+        p.xy.x = u;
+        p.xy.y = v;
+        k4a_float3_t r;
+
+        if (calibration.convert_2d_to_3d(p, 1.0f,
+                K4A_CALIBRATION_TYPE_COLOR,
+                K4A_CALIBRATION_TYPE_COLOR,
+                &r)) {
+            minX = FMath::Min(minX, r.xyz.x / r.xyz.z);
+            minY = FMath::Min(minY, r.xyz.y / r.xyz.z);
+            maxX = FMath::Max(maxX, r.xyz.x / r.xyz.z);
+            maxY = FMath::Max(maxY, r.xyz.y / r.xyz.z);
+        }
+    };
+
+    {
+        const auto right = cc.resolution_width - 0.5f;
+        const auto bottom = cc.resolution_height - 0.5f;
+        const auto step = static_cast<int32>(GridSpacing);
+
+        for (int32 u = 0; u < cc.resolution_width; u += step) {
+            extend(static_cast<float>(u), -0.5f);
+            extend(static_cast<float>(u), bottom);
+        }
+
+        for (int32 v = 0; v < cc.resolution_height; v += step) {
+            extend(-0.5f, static_cast<float>(v));
+            extend(right, static_cast<float>(v));
+        }
+
+        extend(right, bottom);
+    }
+
+    const auto fx = cc.intrinsics.parameters.param.fx;
+    if ((minX > maxX) || (minY > maxY) || !(fx > 0.0f)) {
+        return;
+    }
+
+    // Sample the projection on a regular grid in normalised coordinates,
+    // which is padded such that the bilinear interpolation covers the whole
+    // image.
+    constexpr int32 padding = 2;
+    const auto step = GridSpacing / fx;
+    this->_colourGridMinX = minX - padding * step;
+    this->_colourGridMinY = minY - padding * step;
+    this->_colourGridScale = 1.0f / step;
+    this->_colourGridWidth = FMath::CeilToInt((maxX - minX) / step)
+        + 2 * padding + 1;
+    this->_colourGridHeight = FMath::CeilToInt((maxY - minY) / step)
+        + 2 * padding + 1;
+    this->_colourGrid.SetNumUninitialized(this->_colourGridWidth
+        * this->_colourGridHeight);
+
+    for (int32 y = 0, i = 0; y < this->_colourGridHeight; ++y) {
+        for (int32 x = 0; x < this->_colourGridWidth; ++x, ++i) {
+            k4a_float3_t p;
+            p.xyz.x = this->_colourGridMinX + x * step;
+            p.xyz.y = this->_colourGridMinY + y * step;
+            p.xyz.z = 1.0f;
+            k4a_float2_t r;
+
+            if (calibration.convert_3d_to_2d(p,
+                    K4A_CALIBRATION_TYPE_COLOR,
+                    K4A_CALIBRATION_TYPE_COLOR,
+                    &r)) {
+                this->_colourGrid[i] = FVector2f(r.xy.x, r.xy.y);
+            } else {
+                this->_colourGrid[i] = FVector2f(nan, nan);
+            }
+        }
+    }
+
+    this->_colourHeight = cc.resolution_height;
+    this->_colourWidth = cc.resolution_width;
+
+    // The rotation is row-major and the translation is in millimetres like
+    // the depth samples.
+    {
+        const auto& e = calibration.extrinsics[K4A_CALIBRATION_TYPE_DEPTH]
+            [K4A_CALIBRATION_TYPE_COLOR];
+        for (int32 r = 0; r < 3; ++r) {
+            this->_transform[4 * r + 0] = e.rotation[3 * r + 0];
+            this->_transform[4 * r + 1] = e.rotation[3 * r + 1];
+            this->_transform[4 * r + 2] = e.rotation[3 * r + 2];
+            this->_transform[4 * r + 3] = e.translation[r];
+        }
+    }
+}
+
+
+/*
+ * FAzureKinectRegistration::Reset
+ */
+void FAzureKinectRegistration::Reset(void) {
+    this->_colourGrid.Empty();
+    this->_colourGridHeight = 0;
+    this->_colourGridMinX = 0.0f;
+    this->_colourGridMinY = 0.0f;
+    this->_colourGridScale = 0.0f;
+    this->_colourGridWidth = 0;
+    this->_colourHeight = 0;
+    this->_colourWidth = 0;
+    this->_depthHeight = 0;
+    this->_depthWidth = 0;
+    this->_projectedMaxV.Empty();
+    this->_projectedMinV.Empty();
+    this->_projectedU.Empty();
+    this->_projectedV.Empty();
+    this->_projectedZ.Empty();
+    this->_raysX.Empty();
+    this->_raysY.Empty();
+    FMemory::Memzero(this->_transform);
+}
+
+
+/*
+ * FAzureKinectRegistration::Project
+ */
+bool FAzureKinectRegistration::Project(float& u,
+        float& v,
+        const float x,
+        const float y) const noexcept {
+    const auto gx = (x - this->_colourGridMinX) * this->_colourGridScale;
+    const auto gy = (y - this->_colourGridMinY) * this->_colourGridScale;
+
+    // Note: the comparisons also reject NaN.
+    if (!((gx >= 0.0f) && (gx < this->_colourGridWidth - 1)
+            && (gy >= 0.0f) && (gy < this->_colourGridHeight - 1))) {
+        return false;
+    }
+
+    const auto ix = static_cast<int32>(gx);
+    const auto iy = static_cast<int32>(gy);
+    const auto fx = gx - ix;
+    const auto fy = gy - iy;
+    const auto g = this->_colourGrid.GetData()
+        + iy * this->_colourGridWidth + ix;
+    const auto top = g[0] + (g[1] - g[0]) * fx;
+    const auto bottom = g[this->_colourGridWidth]
+        + (g[this->_colourGridWidth + 1] - g[this->_colourGridWidth]) * fx;
+    const auto p = top + (bottom - top) * fy;
+
+    u = p.X;
+    v = p.Y;
+    return !FMath::IsNaN(u) && !FMath::IsNaN(v);
+}
+
+
+/*
+ * FAzureKinectRegistration::ProjectRows
+ */
+void FAzureKinectRegistration::ProjectRows(const uint16 *depth,
+        const int32 begin,
+        const int32 end) {
+    const auto width = this->_depthWidth;
+
+    for (int32 r = begin; r < end; ++r) {
+        const auto offset = r * width;
+        auto pu = this->_projectedU.GetData() + offset;
+        auto pv = this->_projectedV.GetData() + offset;
+        auto pz = this->_projectedZ.GetData() + offset;
+
+        FAzureKinectConversion::Reproject(pu,
+            pv,
+            pz,
+            depth + offset,
+            this->_raysX.GetData() + offset,
+            this->_raysY.GetData() + offset,
+            this->_transform,
+            width);
+
+        auto minV = std::numeric_limits<float>::max();
+        auto maxV = std::numeric_limits<float>::lowest();
+
+        for (int32 i = 0; i < width; ++i) {
+            if ((pz[i] > 0.0f) && this->Project(pu[i], pv[i], pu[i], pv[i])) {
+                minV = FMath::Min(minV, pv[i]);
+                maxV = FMath::Max(maxV, pv[i]);
+            } else {
+                pz[i] = 0.0f;
+            }
+        }
+
+        this->_projectedMaxV[r] = maxV;
+        this->_projectedMinV[r] = minV;
+    }
+}
@@ -0,0 +1,242 @@
+﻿// <copyright file="AzureKinectSkeletonFilter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectSkeletonFilter.h"
+
+#include <cassert>
+
+
+namespace {
+
+    /// <summary>
+    /// The number of joint groups with their own parameters.
+    /// </summary>
+    constexpr int32 GroupCount = 6;
+
+    /// <summary>
+    /// The group of each joint as index into the parameters collected by
+    /// <see cref="GetGroups" />.
+    /// </summary>
+    constexpr uint8 JointGroups[FAzureKinectSkeletonData::JointCount] = {
+        0, 0, 0, 0,                     // Pelvis to neck
+        0, 2, 2, 2, 3, 3, 3,            // Left arm
+        0, 2, 2, 2, 3, 3, 3,            // Right arm
+        4, 4, 5, 5,                     // Left leg
+        4, 4, 5, 5,                     // Right leg
+        1, 1, 1, 1, 1, 1                // Head
+    };
+
+    /// <summary>
+    /// The standard deviation of the velocity of a joint that has just been
+    /// observed in centimetres per second.
+    /// </summary>
+    constexpr float InitialVelocityNoise = 100.0f;
+
+    /// <summary>
+    /// The parameters of a joint group for the current time step.
+    /// </summary>
+    struct FGroup {
+        float Alpha;
+        float Beta;
+        float MinCutoff;
+        float Q00;
+        float Q01;
+        float Q11;
+        float R;
+    };
+
+    /*
+     * ::GetAlpha
+     */
+    inline float GetAlpha(const float cutoff, const float dt) {
+        if (dt <= 0.0f) {
+            return 0.0f;
+        }
+
+        const auto tau = 1.0f / (2.0f * PI * cutoff);
+        return 1.0f / (1.0f + tau / dt);
+    }
+
+    /*
+     * ::GetGroups
+     */
+    void GetGroups(FGroup (&dst)[GroupCount],
+            const FAzureKinectSkeletonFilterSettings& settings,
+            const float dt) {
+        const FAzureKinectJointFilterSettings *groups[] = {
+            &settings.Torso,
+            &settings.Head,
+            &settings.Arms,
+            &settings.Hands,
+            &settings.Legs,
+            &settings.Feet
+        };
+        static_assert(UE_ARRAY_COUNT(groups) == GroupCount,
+            "All joint groups must be configured.");
+
+        // All parameters but the measurement noise are zero for a time step
+        // of zero, which is only used for initialising the joints.
+        for (int32 g = 0; g < GroupCount; ++g) {
+            const auto& s = *groups[g];
+            // The process noise is the one of a piecewise constant white
+            // acceleration during the time step.
+            const auto q = FMath::Square(FMath::Max(s.ProcessNoise, 0.01f));
+            const auto dt2 = dt * dt;
+
+            dst[g].Alpha = GetAlpha(FMath::Max(s.DerivativeCutoff, 0.01f), dt);
+            dst[g].Beta = FMath::Max(s.Beta, 0.0f);
+            dst[g].MinCutoff = FMath::Max(s.MinCutoff, 0.01f);
+            dst[g].Q00 = 0.25f * q * dt2 * dt2;
+            dst[g].Q01 = 0.5f * q * dt2 * dt;
+            dst[g].Q11 = q * dt2;
+            dst[g].R = FMath::Square(FMath::Max(s.MeasurementNoise, 0.01f));
+        }
+    }
+
+} /* namespace */
+
+
+/*
+ * FAzureKinectSkeletonFilter::FAzureKinectSkeletonFilter
+ */
+FAzureKinectSkeletonFilter::FAzureKinectSkeletonFilter(void)
+    : _filter(EKinectSkeletonFilter::NONE), _time(0.0) { }
+
+
+/*
+ * FAzureKinectSkeletonFilter::Apply
+ */
+void FAzureKinectSkeletonFilter::Apply(FAzureKinectSkeletonData *skeletons,
+        const int32 cnt,
+        const double time,
+        const FAzureKinectSkeletonFilterSettings& settings) {
+    constexpr auto JointCount = FAzureKinectSkeletonData::JointCount;
+    assert((skeletons != nullptr) || (cnt == 0));
+
+    if (settings.Filter == EKinectSkeletonFilter::NONE) {
+        this->Reset();
+        return;
+    }
+
+    if ((settings.Filter != this->_filter) || (time <= this->_time)) {
+        this->Reset();
+        this->_filter = settings.Filter;
+    }
+
+    const auto dt = (this->_time > 0.0)
+        ? static_cast<float>(time - this->_time)
+        : 0.0f;
+    this->_time = time;
+
+    // Rebuild the state in the order of the skeletons, which only copies
+    // whole blocks of joints, such that the filter itself is a single pass.
+    Swap(this->_ids, this->_previousIDs);
+    Swap(this->_joints, this->_previous);
+    this->_ids.SetNumUninitialized(cnt);
+    this->_joints.SetNumUninitialized(cnt * JointCount);
+
+    for (int32 s = 0; s < cnt; ++s) {
+        const auto id = skeletons[s].ID;
+        const auto p = this->_previousIDs.Find(id);
+        auto dst = this->_joints.GetData() + s * JointCount;
+        this->_ids[s] = id;
+
+        if (p != INDEX_NONE) {
+            FMemory::Memcpy(dst, this->_previous.GetData() + p * JointCount,
+                JointCount * sizeof(FJoint));
+        } else {
+            for (int32 j = 0; j < JointCount; ++j) {
+                dst[j].Valid = false;
+            }
+        }
+    }
+
+    FGroup groups[GroupCount];
+    GetGroups(groups, settings, dt);
+
+    const auto kalman = (settings.Filter == EKinectSkeletonFilter::KALMAN);
+    auto state = this->_joints.GetData();
+
+    for (int32 i = 0; i < cnt * JointCount; ++i) {
+        auto& skeleton = skeletons[i / JointCount];
+        auto& joint = state[i];
+        const auto j = i % JointCount;
+
+        if (skeleton.Confidences[j] == EKinectJointConfidence::NONE) {
+            continue;
+        }
+
+        const auto z = skeleton.Positions[j];
+        auto q = skeleton.Rotations[j];
+
+        const auto& g = groups[JointGroups[j]];
+
+        if (!joint.Valid || (dt <= 0.0f)) {
+            joint.Covariance[0] = g.R;
+            joint.Covariance[1] = 0.0f;
+            joint.Covariance[2] = FMath::Square(InitialVelocityNoise);
+            joint.Position = z;
+            joint.Rotation = q;
+            joint.Valid = true;
+            joint.Velocity = FVector3f::ZeroVector;
+            continue;
+        }
+
+        float share;
+
+        if (kalman) {
+            auto& p = joint.Covariance;
+
+            // Predict with constant velocity.
+            joint.Position += joint.Velocity * dt;
+            p[0] += dt * (2.0f * p[1] + dt * p[2]) + g.Q00;
+            p[1] += dt * p[2] + g.Q01;
+            p[2] += g.Q11;
+
+            // Correct with the tracked position.
+            const auto k0 = p[0] / (p[0] + g.R);
+            const auto k1 = p[1] / (p[0] + g.R);
+            const auto y = z - joint.Position;
+            joint.Position += k0 * y;
+            joint.Velocity += k1 * y;
+            p[2] -= k1 * p[1];
+            p[1] *= 1.0f - k0;
+            p[0] *= 1.0f - k0;
+            share = k0;
+
+        } else {
+            // Smooth the speed first and derive the cutoff from it, such
+            // that fast movements are smoothed less.
+            const auto v = (z - joint.Position) / dt;
+            joint.Velocity += g.Alpha * (v - joint.Velocity);
+            const auto cutoff = g.MinCutoff + g.Beta * joint.Velocity.Size();
+            share = GetAlpha(cutoff, dt);
+            joint.Position += share * (z - joint.Position);
+        }
+
+        // Interpolate along the shorter arc.
+        if ((joint.Rotation | q) < 0.0f) {
+            q = -q;
+        }
+        joint.Rotation = FQuat4f::Slerp(joint.Rotation, q, share);
+
+        skeleton.Positions[j] = joint.Position;
+        skeleton.Rotations[j] = joint.Rotation;
+    }
+}
+
+
+/*
+ * FAzureKinectSkeletonFilter::Reset
+ */
+void FAzureKinectSkeletonFilter::Reset(void) {
+    this->_filter = EKinectSkeletonFilter::NONE;
+    this->_ids.Reset();
+    this->_joints.Reset();
+    this->_previous.Reset();
+    this->_previousIDs.Reset();
+    this->_time = 0.0;
+}
@@ -0,0 +1,238 @@
+﻿// <copyright file="AzureKinectTextureUpload.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectTextureUpload.h"
+
+#include <cassert>
+
+#include "RenderingThread.h"
+#include "RHICommandList.h"
+#include "TextureResource.h"
+
+#include "AzureKinectDevice.h"
+
+
+/*
+ * FAzureKinectTextureUploader::FAzureKinectTextureUploader
+ */
+FAzureKinectTextureUploader::FAzureKinectTextureUploader(void)
+    : _maxInFlight(1) { }
+
+
+/*
+ * FAzureKinectTextureUploader::GetFrameInfo
+ */
+void FAzureKinectTextureUploader::GetFrameInfo(const EKinectStream stream,
+        FAzureKinectFrameInfo& frameInfo) const {
+    const auto& s = this->_streams[static_cast<int32>(stream)];
+    FScopeLock l(&this->_lock);
+    frameInfo = s.FrameInfo;
+}
+
+
+/*
+ * FAzureKinectTextureUploader::GetStatistics
+ */
+void FAzureKinectTextureUploader::GetStatistics(const EKinectStream stream,
+        FAzureKinectStageStatistics& statistics) const {
+    const auto& s = this->_streams[static_cast<int32>(stream)];
+    const auto mask = 1u << static_cast<int32>(stream);
+    FScopeLock l(&this->_lock);
+    statistics.Capacity = this->_maxInFlight;
+    statistics.Dropped = s.Dropped;
+    statistics.Pending = s.InFlight;
+    for (const auto& p : this->_pending) {
+        statistics.Pending += ((p.Streams & mask) != 0) ? 1 : 0;
+    }
+    statistics.Processed = s.Uploaded;
+}
+
+
+/*
+ * FAzureKinectTextureUploader::Reset
+ */
+void FAzureKinectTextureUploader::Reset(const int32 maxInFlight) {
+    TArray<FPending, TInlineAllocator<2>> stale;
+
+    {
+        FScopeLock l(&this->_lock);
+        this->_maxInFlight = FMath::Max(maxInFlight, 1);
+        stale = MoveTemp(this->_pending);
+        this->_pending.Reset();
+
+        // Uploads that are still in flight will be accounted for once they
+        // complete, so the number of those must be preserved.
+        for (auto& s : this->_streams) {
+            s.Dropped = 0;
+            s.FrameInfo = FAzureKinectFrameInfo();
+            s.Uploaded = 0;
+        }
+    }
+
+    // 'stale' releases the buffers once we leave, which must not happen while
+    // holding the lock as this might return them to their pool.
+}
+
+
+/*
+ * FAzureKinectTextureUploader::Submit
+ */
+void FAzureKinectTextureUploader::Submit(
+        FAzureKinectTextureUploads&& uploads) {
+    TArray<FPending, TInlineAllocator<2>> stale;
+    const auto streams = GetStreams(uploads);
+    auto admitted = false;
+
+    if (streams == 0) {
+        return;
+    }
+
+    {
+        FScopeLock l(&this->_lock);
+
+        // Any batch waiting in the mailbox that shares a stream with the one
+        // we are processing is older, so it is superseded in both cases. It
+        // is dropped as a whole, because keeping the rest of it would allow
+        // its textures to be mixed with the ones of newer captures.
+        for (int32 i = this->_pending.Num() - 1; i >= 0; --i) {
+            if ((this->_pending[i].Streams & streams) != 0) {
+                for (const auto& u : this->_pending[i].Uploads) {
+                    ++this->_streams[static_cast<int32>(u.Stream)].Dropped;
+                }
+
+                stale.Add(MoveTemp(this->_pending[i]));
+                this->_pending.RemoveAt(i);
+            }
+        }
+
+        admitted = this->TryAdmit(streams);
+        if (!admitted) {
+            this->_pending.Add(FPending { streams, MoveTemp(uploads) });
+        }
+    }
+
+    if (admitted) {
+        // The render command holds a reference to the images, which keeps
+        // the buffers alive until they have been uploaded. All targets of a
+        // capture are updated in the same command such that they cannot
+        // diverge.
+        ENQUEUE_RENDER_COMMAND(UpdateRTCommand)(
+            [self = this->AsShared(), u = MoveTemp(uploads)](
+                    FRHICommandListImmediate& cmdList) mutable {
+                self->Upload(cmdList, MoveTemp(u));
+            });
+    }
+
+    uploads.Reset();
+}
+
+
+/*
+ * FAzureKinectTextureUploader::GetStreams
+ */
+uint32 FAzureKinectTextureUploader::GetStreams(
+        const FAzureKinectTextureUploads& uploads) {
+    uint32 retval = 0;
+
+    for (const auto& u : uploads) {
+        const auto mask = 1u << static_cast<int32>(u.Stream);
+        assert((retval & mask) == 0);
+        retval |= mask;
+    }
+
+    return retval;
+}
+
+
+/*
+ * FAzureKinectTextureUploader::Write
+ */
+void FAzureKinectTextureUploader::Write(FRHICommandListImmediate& cmdList,
+        const FAzureKinectTextureUpload& upload) {
+    assert(upload.Target);
+    assert(upload.Image);
+    assert(upload.Image.get_size()
+        >= static_cast<size_t>(upload.Height * upload.Pitch));
+
+    auto res = upload.Target->GetRenderTargetResource();
+    if (res) {
+        FUpdateTextureRegion2D region(0, 0, 0, 0,
+            upload.Width,
+            upload.Height);
+        GDynamicRHI->RHIUpdateTexture2D(
+            cmdList,
+            res->GetRenderTargetTexture(),
+            0,
+            region,
+            upload.Pitch,
+            upload.Image.get_buffer());
+    } else {
+        UE_LOG(AzureKinectDeviceLog,
+            Warning,
+            TEXT("Failed to obtain resource from render target."));
+    }
+}
+
+
+/*
+ * FAzureKinectTextureUploader::TryAdmit
+ */
+bool FAzureKinectTextureUploader::TryAdmit(const uint32 streams) {
+    for (int32 i = 0; i < StreamCount; ++i) {
+        if (((streams & (1u << i)) != 0)
+                && (this->_streams[i].InFlight >= this->_maxInFlight)) {
+            return false;
+        }
+    }
+
+    for (int32 i = 0; i < StreamCount; ++i) {
+        if ((streams & (1u << i)) != 0) {
+            ++this->_streams[i].InFlight;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+ * FAzureKinectTextureUploader::Upload
+ */
+void FAzureKinectTextureUploader::Upload(FRHICommandListImmediate& cmdList,
+        FAzureKinectTextureUploads&& uploads) {
+    FAzureKinectTextureUploads next(MoveTemp(uploads));
+
+    // If batches have accumulated in the mailbox while we were stalled, the
+    // first one whose streams are all below the limit now takes over the
+    // slots of the one just completed.
+    while (next.Num() > 0) {
+        for (const auto& u : next) {
+            Write(cmdList, u);
+        }
+
+        // 'done' releases the buffers at the end of the iteration, which must
+        // not happen while holding the lock as this might return them to
+        // their pool.
+        auto done = MoveTemp(next);
+        next.Reset();
+
+        FScopeLock l(&this->_lock);
+        for (const auto& u : done) {
+            auto& s = this->_streams[static_cast<int32>(u.Stream)];
+            s.FrameInfo = u.FrameInfo;
+            ++s.Uploaded;
+            --s.InFlight;
+        }
+
+        for (int32 i = 0; i < this->_pending.Num(); ++i) {
+            if (this->TryAdmit(this->_pending[i].Streams)) {
+                next = MoveTemp(this->_pending[i].Uploads);
+                this->_pending.RemoveAt(i);
+                break;
+            }
+        }
+    }
+}
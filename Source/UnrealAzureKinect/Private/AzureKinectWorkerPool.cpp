@@ -0,0 +1,211 @@
+﻿// <copyright file="AzureKinectWorkerPool.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "AzureKinectWorkerPool.h"
+
+#include <cassert>
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformAffinity.h"
+#include "HAL/PlatformProcess.h"
+
+#include "AzureKinectDeviceThread.h"
+
+
+/*
+ * FAzureKinectWorkerPool::FAzureKinectWorkerPool
+ */
+FAzureKinectWorkerPool::FAzureKinectWorkerPool(void)
+    : _event(FPlatformProcess::GetSynchEventFromPool(true)),
+        _stopCounter(0) { }
+
+
+/*
+ * FAzureKinectWorkerPool::~FAzureKinectWorkerPool
+ */
+FAzureKinectWorkerPool::~FAzureKinectWorkerPool(void) {
+    this->Shutdown();
+    FPlatformProcess::ReturnSynchEventToPool(this->_event);
+}
+
+
+/*
+ * FAzureKinectWorkerPool::ParallelFor
+ */
+void FAzureKinectWorkerPool::ParallelFor(const int32 cnt, BodyType body) {
+    if (cnt < 1) {
+        return;
+    }
+
+    if (cnt == 1) {
+        body(0);
+        return;
+    }
+
+    if (this->_threads.Num() < 1) {
+        ::ParallelFor(cnt, body);
+        return;
+    }
+
+    auto job = MakeShared<FJob, ESPMode::ThreadSafe>(cnt, body);
+    job->Done = FPlatformProcess::GetSynchEventFromPool(false);
+
+    {
+        FScopeLock l(&this->_lock);
+        this->_jobs.Add(job);
+        this->_event->Trigger();
+    }
+
+    // Work on our own job, which guarantees progress even if all workers are
+    // busy, and wait for the items the workers have taken.
+    Execute(*job);
+    this->Retire(job);
+    job->Done->Wait();
+
+    FPlatformProcess::ReturnSynchEventToPool(job->Done);
+    job->Done = nullptr;
+}
+
+
+/*
+ * FAzureKinectWorkerPool::ParallelForTiles
+ */
+void FAzureKinectWorkerPool::ParallelForTiles(const int32 cnt,
+        const int32 grain,
+        TileBodyType body) {
+    if ((grain < 1) || (grain >= cnt)) {
+        if (cnt > 0) {
+            body(0, cnt);
+        }
+        return;
+    }
+
+    const auto tiles = (cnt + grain - 1) / grain;
+    this->ParallelFor(tiles, [cnt, grain, &body](const int32 t) {
+        const auto begin = t * grain;
+        body(begin, FMath::Min(begin + grain, cnt));
+    });
+}
+
+
+/*
+ * FAzureKinectWorkerPool::Run
+ */
+uint32 FAzureKinectWorkerPool::Run(void) {
+    while (this->_stopCounter.GetValue() == 0) {
+        JobType job;
+
+        {
+            FScopeLock l(&this->_lock);
+            if (this->_jobs.Num() > 0) {
+                // Prefer the newest job, which is the innermost one if calls
+                // are nested and therefore blocks the older ones.
+                job = this->_jobs.Last();
+            }
+        }
+
+        if (job.IsValid()) {
+            Execute(*job);
+            this->Retire(job);
+        } else {
+            this->_event->Wait();
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * FAzureKinectWorkerPool::Shutdown
+ */
+void FAzureKinectWorkerPool::Shutdown(void) {
+    this->Stop();
+
+    for (auto t : this->_threads) {
+        t->WaitForCompletion();
+        delete t;
+    }
+
+    this->_threads.Reset();
+    this->_stopCounter.Reset();
+
+    // Stopping has signalled the event, which would make restarted workers
+    // spin if we left it set.
+    {
+        FScopeLock l(&this->_lock);
+        if (this->_jobs.Num() < 1) {
+            this->_event->Reset();
+        }
+    }
+}
+
+
+/*
+ * FAzureKinectWorkerPool::Start
+ */
+void FAzureKinectWorkerPool::Start(const int32 threads,
+        const uint64 affinityMask) {
+    this->Shutdown();
+
+    const auto mask = (affinityMask != 0)
+        ? affinityMask
+        : FPlatformAffinity::GetNoAffinityMask();
+
+    for (int32 i = 0; i < threads; ++i) {
+        const auto name = FString::Printf(TEXT("Azure Kinect worker %d"), i);
+        auto thread = FRunnableThread::Create(this,
+            *name,
+            0,
+            TPri_BelowNormal,
+            mask);
+
+        if (thread != nullptr) {
+            this->_threads.Add(thread);
+        } else {
+            UE_LOG(AzureKinectThreadLog,
+                Error,
+                TEXT("Failed to create Azure Kinect worker thread \"%s\"."),
+                *name);
+        }
+    }
+}
+
+
+/*
+ * FAzureKinectWorkerPool::Stop
+ */
+void FAzureKinectWorkerPool::Stop(void) {
+    this->_stopCounter.Increment();
+    this->_event->Trigger();
+}
+
+
+/*
+ * FAzureKinectWorkerPool::Execute
+ */
+void FAzureKinectWorkerPool::Execute(FJob& job) {
+    for (auto i = job.Next++; i < job.Count; i = job.Next++) {
+        job.Body(i);
+
+        if (--job.Pending == 0) {
+            job.Done->Trigger();
+        }
+    }
+}
+
+
+/*
+ * FAzureKinectWorkerPool::Retire
+ */
+void FAzureKinectWorkerPool::Retire(const JobType& job) {
+    FScopeLock l(&this->_lock);
+    this->_jobs.RemoveSingle(job);
+
+    if (this->_jobs.Num() < 1) {
+        this->_event->Reset();
+    }
+}
@@ -0,0 +1,648 @@
+﻿// <copyright file="NiagaraDataInterfaceAzureKinect.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "NiagaraDataInterfaceAzureKinect.h"
+
+#include "NiagaraCompileHashVisitor.h"
+#include "NiagaraGpuComputeDispatchInterface.h"
+#include "NiagaraRenderer.h"
+#include "NiagaraShaderParametersBuilder.h"
+#include "NiagaraSystemInstance.h"
+#include "NiagaraTypes.h"
+
+#include "AzureKinectGpuBuffers.h"
+
+#define LOCTEXT_NAMESPACE "NiagaraDataInterfaceAzureKinect"
+
+
+namespace {
+
+    /// <summary>
+    /// The parameters bound to the shaders of GPU simulations.
+    /// </summary>
+    BEGIN_SHADER_PARAMETER_STRUCT(FShaderParameters, )
+        SHADER_PARAMETER(uint32, ColourCount)
+        SHADER_PARAMETER(uint32, PointCount)
+        SHADER_PARAMETER(uint32, SkeletonCount)
+        SHADER_PARAMETER_SRV(Buffer<float4>, Colours)
+        SHADER_PARAMETER_SRV(Buffer<float4>, Joints)
+        SHADER_PARAMETER_SRV(Buffer<float>, Points)
+        SHADER_PARAMETER_SRV(Buffer<int>, SkeletonIDs)
+    END_SHADER_PARAMETER_STRUCT()
+
+    /// <summary>
+    /// The data of a system instance, which is passed from the game thread to
+    /// the render thread.
+    /// </summary>
+    struct FInstanceData {
+        TSharedPtr<FAzureKinectGpuBuffers, ESPMode::ThreadSafe> Buffers;
+        FAzureKinectGpuBuffers::PointCloudType PointCloud;
+        FAzureKinectGpuBuffers::SkeletonsType Skeletons;
+    };
+
+    /// <summary>
+    /// The render thread counterpart of the data interface.
+    /// </summary>
+    struct FProxy : public FNiagaraDataInterfaceProxy {
+
+        virtual void ConsumePerInstanceDataFromGameThread(void *data,
+                const FNiagaraSystemInstanceID& instance) override {
+            auto d = static_cast<FInstanceData *>(data);
+            this->Instances.FindOrAdd(instance) = MoveTemp(*d);
+            d->~FInstanceData();
+        }
+
+        virtual int32 PerInstanceDataPassedToRenderThreadSize(
+                void) const override {
+            return sizeof(FInstanceData);
+        }
+
+        virtual void PreStage(
+                const FNDIGpuComputePreStageContext& context) override {
+            // The buffers remember what they hold, so this only uploads
+            // once per frame no matter how many emitters use the device.
+            auto d = this->Instances.Find(context.GetSystemInstanceID());
+            if ((d != nullptr) && d->Buffers) {
+                d->Buffers->Update(context.GetGraphBuilder().RHICmdList,
+                    d->PointCloud,
+                    d->Skeletons);
+            }
+        }
+
+        TMap<FNiagaraSystemInstanceID, FInstanceData> Instances;
+    };
+
+    const FName GetJointName(TEXT("GetJoint"));
+    const FName GetJointCountName(TEXT("GetJointCount"));
+    const FName GetPointName(TEXT("GetPoint"));
+    const FName GetPointCountName(TEXT("GetPointCount"));
+    const FName GetSkeletonCountName(TEXT("GetSkeletonCount"));
+    const FName GetSkeletonIDName(TEXT("GetSkeletonID"));
+
+    /// <summary>
+    /// Changes whenever the generated HLSL changes.
+    /// </summary>
+    constexpr int32 HlslVersion = 2;
+
+} /* namespace */
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::UNiagaraDataInterfaceAzureKinect
+ */
+UNiagaraDataInterfaceAzureKinect::UNiagaraDataInterfaceAzureKinect(
+        const FObjectInitializer& initialiser)
+        : Super(initialiser), Device(nullptr) {
+    this->Proxy.Reset(new FProxy());
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::BuildShaderParameters
+ */
+void UNiagaraDataInterfaceAzureKinect::BuildShaderParameters(
+        FNiagaraShaderParametersBuilder& builder) const {
+    builder.AddNestedStruct<FShaderParameters>();
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::CanExecuteOnTarget
+ */
+bool UNiagaraDataInterfaceAzureKinect::CanExecuteOnTarget(
+        ENiagaraSimTarget target) const {
+    return true;
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::DestroyPerInstanceData
+ */
+void UNiagaraDataInterfaceAzureKinect::DestroyPerInstanceData(void *data,
+        FNiagaraSystemInstance *instance) {
+    static_cast<FInstanceData *>(data)->~FInstanceData();
+
+    ENQUEUE_RENDER_COMMAND(RemoveAzureKinectInstance)(
+            [proxy = this->GetProxyAs<FProxy>(), id = instance->GetId()](
+            FRHICommandListImmediate& cmdList) {
+        proxy->Instances.Remove(id);
+    });
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::Equals
+ */
+bool UNiagaraDataInterfaceAzureKinect::Equals(
+        const UNiagaraDataInterface *other) const {
+    if (!Super::Equals(other)) {
+        return false;
+    }
+
+    auto that = CastChecked<const UNiagaraDataInterfaceAzureKinect>(other);
+    return (that->Device == this->Device);
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::GetVMExternalFunction
+ */
+void UNiagaraDataInterfaceAzureKinect::GetVMExternalFunction(
+        const FVMExternalFunctionBindingInfo& bindingInfo,
+        void *data,
+        FVMExternalFunction& outFunc) {
+    if (bindingInfo.Name == GetJointName) {
+        outFunc = FVMExternalFunction::CreateUObject(this,
+            &UNiagaraDataInterfaceAzureKinect::VMGetJoint);
+    } else if (bindingInfo.Name == GetJointCountName) {
+        outFunc = FVMExternalFunction::CreateUObject(this,
+            &UNiagaraDataInterfaceAzureKinect::VMGetJointCount);
+    } else if (bindingInfo.Name == GetPointName) {
+        outFunc = FVMExternalFunction::CreateUObject(this,
+            &UNiagaraDataInterfaceAzureKinect::VMGetPoint);
+    } else if (bindingInfo.Name == GetPointCountName) {
+        outFunc = FVMExternalFunction::CreateUObject(this,
+            &UNiagaraDataInterfaceAzureKinect::VMGetPointCount);
+    } else if (bindingInfo.Name == GetSkeletonCountName) {
+        outFunc = FVMExternalFunction::CreateUObject(this,
+            &UNiagaraDataInterfaceAzureKinect::VMGetSkeletonCount);
+    } else if (bindingInfo.Name == GetSkeletonIDName) {
+        outFunc = FVMExternalFunction::CreateUObject(this,
+            &UNiagaraDataInterfaceAzureKinect::VMGetSkeletonID);
+    }
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::HasPreSimulateTick
+ */
+bool UNiagaraDataInterfaceAzureKinect::HasPreSimulateTick(void) const {
+    return true;
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::InitPerInstanceData
+ */
+bool UNiagaraDataInterfaceAzureKinect::InitPerInstanceData(void *data,
+        FNiagaraSystemInstance *instance) {
+    new (data) FInstanceData();
+    return true;
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::PerInstanceDataSize
+ */
+int32 UNiagaraDataInterfaceAzureKinect::PerInstanceDataSize(void) const {
+    return sizeof(FInstanceData);
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::PerInstanceTick
+ */
+bool UNiagaraDataInterfaceAzureKinect::PerInstanceTick(void *data,
+        FNiagaraSystemInstance *instance,
+        float deltaSeconds) {
+    auto d = static_cast<FInstanceData *>(data);
+
+    // Only the snapshots are retrieved here, which is lock-free and does
+    // not copy anything.
+    if (this->Device != nullptr) {
+        d->Buffers = this->Device->GetGpuBuffers();
+        d->PointCloud = this->Device->GetPointCloudSnapshot();
+        d->Skeletons = this->Device->GetSkeletonSnapshot();
+    } else {
+        d->Buffers.Reset();
+        d->PointCloud.Reset();
+        d->Skeletons.Reset();
+    }
+
+    return false;
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::PostInitProperties
+ */
+void UNiagaraDataInterfaceAzureKinect::PostInitProperties(void) {
+    Super::PostInitProperties();
+
+    if (this->HasAnyFlags(RF_ClassDefaultObject)) {
+        const auto flags = ENiagaraTypeRegistryFlags::AllowAnyVariable
+            | ENiagaraTypeRegistryFlags::AllowParameter;
+        FNiagaraTypeRegistry::Register(
+            FNiagaraTypeDefinition(this->GetClass()),
+            flags);
+    }
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::ProvidePerInstanceDataForRenderThread
+ */
+void UNiagaraDataInterfaceAzureKinect::ProvidePerInstanceDataForRenderThread(
+        void *dataForRenderThread,
+        void *data,
+        const FNiagaraSystemInstanceID& instance) {
+    new (dataForRenderThread) FInstanceData(
+        *static_cast<FInstanceData *>(data));
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::SetShaderParameters
+ */
+void UNiagaraDataInterfaceAzureKinect::SetShaderParameters(
+        const FNiagaraDataInterfaceSetShaderParametersContext& context) const {
+    auto& proxy = context.GetProxy<FProxy>();
+    auto params = context.GetParameterNestedStruct<FShaderParameters>();
+    auto d = proxy.Instances.Find(context.GetSystemInstanceID());
+    auto buffers = (d != nullptr) ? d->Buffers.Get() : nullptr;
+
+    if ((buffers != nullptr) && (buffers->GetPoints() != nullptr)) {
+        params->ColourCount = buffers->GetColourCount();
+        params->PointCount = buffers->GetPointCount();
+        params->SkeletonCount = buffers->GetSkeletonCount();
+        params->Colours = buffers->GetColours();
+        params->Joints = buffers->GetJoints();
+        params->Points = buffers->GetPoints();
+        params->SkeletonIDs = buffers->GetSkeletonIDs();
+
+    } else {
+        params->ColourCount = 0;
+        params->PointCount = 0;
+        params->SkeletonCount = 0;
+        params->Colours = FNiagaraRenderer::GetDummyFloat4Buffer();
+        params->Joints = FNiagaraRenderer::GetDummyFloat4Buffer();
+        params->Points = FNiagaraRenderer::GetDummyFloatBuffer();
+        params->SkeletonIDs = FNiagaraRenderer::GetDummyIntBuffer();
+    }
+}
+
+
+#if WITH_EDITORONLY_DATA
+/*
+ * UNiagaraDataInterfaceAzureKinect::AppendCompileHash
+ */
+bool UNiagaraDataInterfaceAzureKinect::AppendCompileHash(
+        FNiagaraCompileHashVisitor *visitor) const {
+    auto retval = Super::AppendCompileHash(visitor);
+    retval &= visitor->UpdatePOD(TEXT("AzureKinectHlslVersion"), HlslVersion);
+    retval &= visitor->UpdateShaderParameters<FShaderParameters>();
+    return retval;
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::GetFunctionHLSL
+ */
+bool UNiagaraDataInterfaceAzureKinect::GetFunctionHLSL(
+        const FNiagaraDataInterfaceGPUParamInfo& paramInfo,
+        const FNiagaraDataInterfaceGeneratedFunction& functionInfo,
+        int functionInstanceIndex,
+        FString& outHlsl) {
+    const TMap<FString, FStringFormatArg> args = {
+        { TEXT("Function"), functionInfo.InstanceName },
+        { TEXT("Symbol"), paramInfo.DataInterfaceHLSLSymbol },
+        { TEXT("JointCount"), FAzureKinectGpuBuffers::JointCount },
+    };
+
+    if (functionInfo.DefinitionName == GetJointName) {
+        outHlsl += FString::Format(TEXT(R"(
+void {Function}(int Skeleton, int Joint, out float3 Position, out float4 Rotation, out bool Valid) {
+    Valid = (Skeleton >= 0) && (Skeleton < (int) {Symbol}_SkeletonCount) && (Joint >= 0) && (Joint < {JointCount});
+    const int Index = Valid ? 2 * (Skeleton * {JointCount} + Joint) : 0;
+    const float4 P = Valid ? {Symbol}_Joints[Index] : float4(0, 0, 0, 0);
+    Position = P.xyz;
+    Rotation = Valid ? {Symbol}_Joints[Index + 1] : float4(0, 0, 0, 1);
+    Valid = Valid && (P.w != 0);
+}
+)"), args);
+        return true;
+
+    } else if (functionInfo.DefinitionName == GetJointCountName) {
+        outHlsl += FString::Format(TEXT(R"(
+void {Function}(out int Count) {
+    Count = {JointCount};
+}
+)"), args);
+        return true;
+
+    } else if (functionInfo.DefinitionName == GetPointName) {
+        // FColor is sRGB, so the colours are linearised like by the
+        // conversion of FColor to FLinearColor. The BGRA8 colours are bound
+        // as RGBA8, so red and blue must be swapped.
+        outHlsl += FString::Format(TEXT(R"(
+void {Function}(int Index, out float3 Position, out float4 Colour) {
+    const bool Valid = (Index >= 0) && (Index < (int) {Symbol}_PointCount);
+    const int I = Valid ? Index : 0;
+    Position = Valid
+        ? float3({Symbol}_Points[3 * I], {Symbol}_Points[3 * I + 1], {Symbol}_Points[3 * I + 2])
+        : float3(0, 0, 0);
+    if (Valid && (I < (int) {Symbol}_ColourCount)) {
+        const float4 C = {Symbol}_Colours[I].bgra;
+        const float3 L = C.rgb / 12.92f;
+        const float3 H = pow((C.rgb + 0.055f) / 1.055f, 2.4f);
+        Colour = float4(lerp(H, L, step(C.rgb, 0.04045f)), C.a);
+    } else {
+        Colour = float4(1, 1, 1, 1);
+    }
+}
+)"), args);
+        return true;
+
+    } else if (functionInfo.DefinitionName == GetPointCountName) {
+        outHlsl += FString::Format(TEXT(R"(
+void {Function}(out int Count) {
+    Count = {Symbol}_PointCount;
+}
+)"), args);
+        return true;
+
+    } else if (functionInfo.DefinitionName == GetSkeletonCountName) {
+        outHlsl += FString::Format(TEXT(R"(
+void {Function}(out int Count) {
+    Count = {Symbol}_SkeletonCount;
+}
+)"), args);
+        return true;
+
+    } else if (functionInfo.DefinitionName == GetSkeletonIDName) {
+        outHlsl += FString::Format(TEXT(R"(
+void {Function}(int Skeleton, out int ID) {
+    const bool Valid = (Skeleton >= 0) && (Skeleton < (int) {Symbol}_SkeletonCount);
+    ID = Valid ? {Symbol}_SkeletonIDs[Skeleton] : -1;
+}
+)"), args);
+        return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::GetParameterDefinitionHLSL
+ */
+void UNiagaraDataInterfaceAzureKinect::GetParameterDefinitionHLSL(
+        const FNiagaraDataInterfaceGPUParamInfo& paramInfo,
+        FString& outHlsl) {
+    const TMap<FString, FStringFormatArg> args = {
+        { TEXT("Symbol"), paramInfo.DataInterfaceHLSLSymbol },
+    };
+
+    outHlsl += FString::Format(TEXT(R"(
+uint {Symbol}_ColourCount;
+uint {Symbol}_PointCount;
+uint {Symbol}_SkeletonCount;
+Buffer<float4> {Symbol}_Colours;
+Buffer<float4> {Symbol}_Joints;
+Buffer<float> {Symbol}_Points;
+Buffer<int> {Symbol}_SkeletonIDs;
+)"), args);
+}
+#endif /* WITH_EDITORONLY_DATA */
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::CopyToInternal
+ */
+bool UNiagaraDataInterfaceAzureKinect::CopyToInternal(
+        UNiagaraDataInterface *destination) const {
+    if (!Super::CopyToInternal(destination)) {
+        return false;
+    }
+
+    auto that = CastChecked<UNiagaraDataInterfaceAzureKinect>(destination);
+    that->Device = this->Device;
+    return true;
+}
+
+
+#if WITH_EDITORONLY_DATA
+/*
+ * UNiagaraDataInterfaceAzureKinect::GetFunctionsInternal
+ */
+void UNiagaraDataInterfaceAzureKinect::GetFunctionsInternal(
+        TArray<FNiagaraFunctionSignature>& outFunctions) const {
+    FNiagaraFunctionSignature prototype;
+    prototype.bMemberFunction = true;
+    prototype.bRequiresContext = false;
+    prototype.Inputs.Emplace(FNiagaraTypeDefinition(this->GetClass()),
+        TEXT("AzureKinect"));
+
+    {
+        auto& s = outFunctions.Add_GetRef(prototype);
+        s.Name = GetJointName;
+        s.Inputs.Emplace(FNiagaraTypeDefinition::GetIntDef(),
+            TEXT("Skeleton"));
+        s.Inputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("Joint"));
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetVec3Def(),
+            TEXT("Position"));
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetQuatDef(),
+            TEXT("Rotation"));
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetBoolDef(),
+            TEXT("Valid"));
+        s.SetDescription(LOCTEXT("GetJointDescription",
+            "Returns the position and the rotation of a joint of a "
+            "skeleton. The joints are numbered like k4abt_joint_id_t. "
+            "Joints that are out of range are not valid."));
+    }
+
+    {
+        auto& s = outFunctions.Add_GetRef(prototype);
+        s.Name = GetJointCountName;
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(),
+            TEXT("Count"));
+        s.SetDescription(LOCTEXT("GetJointCountDescription",
+            "Returns the number of joints of each skeleton."));
+    }
+
+    {
+        auto& s = outFunctions.Add_GetRef(prototype);
+        s.Name = GetPointName;
+        s.Inputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("Index"));
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetVec3Def(),
+            TEXT("Position"));
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetColorDef(),
+            TEXT("Colour"));
+        s.SetDescription(LOCTEXT("GetPointDescription",
+            "Returns the position and the colour of a point of the point "
+            "cloud. The colour is white if the point cloud has no "
+            "colours."));
+    }
+
+    {
+        auto& s = outFunctions.Add_GetRef(prototype);
+        s.Name = GetPointCountName;
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(),
+            TEXT("Count"));
+        s.SetDescription(LOCTEXT("GetPointCountDescription",
+            "Returns the number of points in the most recent point cloud."));
+    }
+
+    {
+        auto& s = outFunctions.Add_GetRef(prototype);
+        s.Name = GetSkeletonCountName;
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(),
+            TEXT("Count"));
+        s.SetDescription(LOCTEXT("GetSkeletonCountDescription",
+            "Returns the number of skeletons tracked in the most recent "
+            "frame."));
+    }
+
+    {
+        auto& s = outFunctions.Add_GetRef(prototype);
+        s.Name = GetSkeletonIDName;
+        s.Inputs.Emplace(FNiagaraTypeDefinition::GetIntDef(),
+            TEXT("Skeleton"));
+        s.Outputs.Emplace(FNiagaraTypeDefinition::GetIntDef(), TEXT("ID"));
+        s.SetDescription(LOCTEXT("GetSkeletonIDDescription",
+            "Returns the ID the body tracker assigned to a skeleton, or -1 "
+            "if the skeleton does not exist."));
+    }
+}
+#endif /* WITH_EDITORONLY_DATA */
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::VMGetJoint
+ */
+void UNiagaraDataInterfaceAzureKinect::VMGetJoint(
+        FVectorVMExternalFunctionContext& context) {
+    VectorVM::FUserPtrHandler<FInstanceData> instance(context);
+    FNDIInputParam<int32> inSkeleton(context);
+    FNDIInputParam<int32> inJoint(context);
+    FNDIOutputParam<FVector3f> outPosition(context);
+    FNDIOutputParam<FQuat4f> outRotation(context);
+    FNDIOutputParam<bool> outValid(context);
+
+    const auto& skeletons = instance->Skeletons;
+    const auto cnt = skeletons ? skeletons->Skeletons.Num() : 0;
+
+    for (int32 i = 0; i < context.GetNumInstances(); ++i) {
+        const auto s = inSkeleton.GetAndAdvance();
+        const auto j = inJoint.GetAndAdvance();
+        const auto inRange = (s >= 0) && (s < cnt) && (j >= 0)
+            && (j < FAzureKinectSkeletonData::JointCount);
+
+        // Like on the GPU, joints out of range of the tracker are returned,
+        // but not valid.
+        if (inRange) {
+            const auto& skeleton = skeletons->Skeletons[s];
+            outPosition.SetAndAdvance(skeleton.Positions[j]);
+            outRotation.SetAndAdvance(skeleton.Rotations[j]);
+            outValid.SetAndAdvance(skeleton.Confidences[j]
+                != EKinectJointConfidence::NONE);
+        } else {
+            outPosition.SetAndAdvance(FVector3f::ZeroVector);
+            outRotation.SetAndAdvance(FQuat4f::Identity);
+            outValid.SetAndAdvance(false);
+        }
+    }
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::VMGetJointCount
+ */
+void UNiagaraDataInterfaceAzureKinect::VMGetJointCount(
+        FVectorVMExternalFunctionContext& context) {
+    VectorVM::FUserPtrHandler<FInstanceData> instance(context);
+    FNDIOutputParam<int32> outCount(context);
+
+    for (int32 i = 0; i < context.GetNumInstances(); ++i) {
+        outCount.SetAndAdvance(FAzureKinectGpuBuffers::JointCount);
+    }
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::VMGetPoint
+ */
+void UNiagaraDataInterfaceAzureKinect::VMGetPoint(
+        FVectorVMExternalFunctionContext& context) {
+    VectorVM::FUserPtrHandler<FInstanceData> instance(context);
+    FNDIInputParam<int32> inIndex(context);
+    FNDIOutputParam<FVector3f> outPosition(context);
+    FNDIOutputParam<FLinearColor> outColour(context);
+
+    const auto& cloud = instance->PointCloud;
+    const auto cntPoints = cloud ? cloud->Positions.Num() : 0;
+    const auto cntColours = cloud ? cloud->Colours.Num() : 0;
+
+    for (int32 i = 0; i < context.GetNumInstances(); ++i) {
+        const auto index = inIndex.GetAndAdvance();
+        const auto valid = (index >= 0) && (index < cntPoints);
+
+        outPosition.SetAndAdvance(valid
+            ? cloud->Positions[index]
+            : FVector3f::ZeroVector);
+        outColour.SetAndAdvance((valid && (index < cntColours))
+            ? FLinearColor(cloud->Colours[index])
+            : FLinearColor::White);
+    }
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::VMGetPointCount
+ */
+void UNiagaraDataInterfaceAzureKinect::VMGetPointCount(
+        FVectorVMExternalFunctionContext& context) {
+    VectorVM::FUserPtrHandler<FInstanceData> instance(context);
+    FNDIOutputParam<int32> outCount(context);
+
+    const auto& cloud = instance->PointCloud;
+    const auto cnt = cloud ? cloud->Positions.Num() : 0;
+
+    for (int32 i = 0; i < context.GetNumInstances(); ++i) {
+        outCount.SetAndAdvance(cnt);
+    }
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::VMGetSkeletonCount
+ */
+void UNiagaraDataInterfaceAzureKinect::VMGetSkeletonCount(
+        FVectorVMExternalFunctionContext& context) {
+    VectorVM::FUserPtrHandler<FInstanceData> instance(context);
+    FNDIOutputParam<int32> outCount(context);
+
+    const auto& skeletons = instance->Skeletons;
+    const auto cnt = skeletons ? skeletons->Skeletons.Num() : 0;
+
+    for (int32 i = 0; i < context.GetNumInstances(); ++i) {
+        outCount.SetAndAdvance(cnt);
+    }
+}
+
+
+/*
+ * UNiagaraDataInterfaceAzureKinect::VMGetSkeletonID
+ */
+void UNiagaraDataInterfaceAzureKinect::VMGetSkeletonID(
+        FVectorVMExternalFunctionContext& context) {
+    VectorVM::FUserPtrHandler<FInstanceData> instance(context);
+    FNDIInputParam<int32> inSkeleton(context);
+    FNDIOutputParam<int32> outID(context);
+
+    const auto& skeletons = instance->Skeletons;
+    const auto cnt = skeletons ? skeletons->Skeletons.Num() : 0;
+
+    for (int32 i = 0; i < context.GetNumInstances(); ++i) {
+        const auto s = inSkeleton.GetAndAdvance();
+        outID.SetAndAdvance(((s >= 0) && (s < cnt))
+            ? skeletons->Skeletons[s].ID
+            : -1);
+    }
+}
+
+
+#undef LOCTEXT_NAMESPACE
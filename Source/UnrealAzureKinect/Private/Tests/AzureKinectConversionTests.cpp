@@ -0,0 +1,478 @@
+﻿// <copyright file="AzureKinectConversionTests.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CoreMinimal.h"
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "AzureKinectConversion.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+    /// <summary>
+    /// The numbers of samples the kernels are tested with, which cover
+    /// the vector loops as well as all lengths of their scalar tails.
+    /// </summary>
+    constexpr int32 SampleCounts[] = { 0, 1, 7, 8, 15, 16, 17, 31, 33, 63,
+        65, 1027 };
+
+    /*
+     * ::MakeSamples
+     */
+    TArray<uint16> MakeSamples(const int32 cnt, const int32 seed) {
+        // Every eighth sample is one of the edge cases, the others are
+        // random, including zero, i.e. invalid, samples.
+        constexpr uint16 special[] = { 0, 1, 0x00FF, 0x0100, 0x7FFF, 0x8000,
+            0xFFFE, 0xFFFF };
+        FRandomStream rng(seed);
+        TArray<uint16> retval;
+        retval.SetNumUninitialized(cnt);
+
+        for (int32 i = 0; i < cnt; ++i) {
+            retval[i] = ((i % 8) == 0)
+                ? special[(i / 8) % UE_ARRAY_COUNT(special)]
+                : static_cast<uint16>(rng.RandRange(0, 0xFFFF));
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// The relative threshold of 2 % in 1/65536 the depth filter kernels are
+    /// tested with.
+    /// </summary>
+    constexpr uint16 RelativeThreshold = 1311;
+
+    /// <summary>
+    /// The absolute threshold in millimetres the depth filter kernels are
+    /// tested with.
+    /// </summary>
+    constexpr uint16 MinThreshold = 10;
+
+    /*
+     * ::MakeDepth
+     */
+    TArray<uint16> MakeDepth(const int32 cnt, const int32 seed) {
+        // The samples lie on a few surfaces with some noise, such that the
+        // thresholds of the filters are met as well as exceeded. Some
+        // samples are invalid.
+        FRandomStream rng(seed);
+        TArray<uint16> retval;
+        retval.SetNumUninitialized(cnt);
+
+        int32 surface = rng.RandRange(500, 4000);
+        for (auto& s : retval) {
+            if (rng.FRand() < 0.1f) {
+                surface = rng.RandRange(500, 4000);
+            }
+
+            s = (rng.FRand() < 0.1f)
+                ? 0
+                : static_cast<uint16>(surface + rng.RandRange(-40, 40));
+        }
+
+        return retval;
+    }
+
+    /*
+     * ::MakeYuv
+     */
+    TArray<uint8> MakeYuv(const int32 cnt, const int32 seed,
+            const bool chroma) {
+        // Limited-range video only uses [16, 235] for luma and [16, 240] for
+        // chroma, outside of which the reference is not defined.
+        FRandomStream rng(seed);
+        TArray<uint8> retval;
+        retval.SetNumUninitialized(cnt);
+
+        for (auto& s : retval) {
+            s = static_cast<uint8>(rng.RandRange(16, chroma ? 240 : 235));
+        }
+
+        return retval;
+    }
+
+    /*
+     * ::CheckYuv
+     */
+    int32 CheckYuv(const uint8 *dst,
+            const int32 y,
+            const int32 u,
+            const int32 v) {
+        // The floating-point BT.601 conversion the kernels approximate in
+        // 6-bit fixed-point precision, which costs at most two steps.
+        const auto c = 1.164f * static_cast<float>(y - 16);
+        const auto d = static_cast<float>(u - 128);
+        const auto e = static_cast<float>(v - 128);
+        const float expected[] = {
+            c + 2.018f * d,
+            c - 0.391f * d - 0.813f * e,
+            c + 1.596f * e
+        };
+
+        int32 retval = (dst[3] != 0xFF) ? 1 : 0;
+        for (int32 i = 0; i < 3; ++i) {
+            const auto x = FMath::Clamp(FMath::RoundToInt32(expected[i]),
+                0, 255);
+            retval += (FMath::Abs(dst[i] - x) > 2) ? 1 : 0;
+        }
+
+        return retval;
+    }
+
+} /* namespace */
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectExpand16Test,
+    "AzureKinect.Conversion.Expand16",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectExpand16Test::RunTest
+ */
+bool FAzureKinectExpand16Test::RunTest(const FString& parameters) {
+    const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+    TestTrue(TEXT("The scalar kernels are always supported"),
+        kernels.Num() > 0);
+
+    for (const auto& k : kernels) {
+        for (const auto cnt : SampleCounts) {
+            const auto src = MakeSamples(cnt, cnt);
+
+            // Guard the end of the output such that overruns are detected.
+            TArray<uint8> dst;
+            dst.Init(0xCD, 4 * cnt + 64);
+            k.Expand16(dst.GetData(), src.GetData(), cnt);
+
+            int32 errors = 0;
+            for (int32 i = 0; i < cnt; ++i) {
+                const auto t = dst.GetData() + 4 * i;
+                const auto s = src[i];
+                errors += (t[0] != (s & 0xFF)) ? 1 : 0;
+                errors += (t[1] != (s >> 8)) ? 1 : 0;
+                errors += (t[2] != ((s == 0) ? 0xFF : 0x00)) ? 1 : 0;
+                errors += (t[3] != 0xFF) ? 1 : 0;
+            }
+
+            for (int32 i = 4 * cnt; i < dst.Num(); ++i) {
+                errors += (dst[i] != 0xCD) ? 1 : 0;
+            }
+
+            TestEqual(FString::Printf(TEXT("%s kernel expands %d samples"),
+                k.Name, cnt), errors, 0);
+        }
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectNv12Test,
+    "AzureKinect.Conversion.Nv12",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectNv12Test::RunTest
+ */
+bool FAzureKinectNv12Test::RunTest(const FString& parameters) {
+    const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+
+    // Black, white, red, green and blue must come out as such.
+    {
+        // Y, U, V and the expected B, G, R.
+        const uint8 colours[][6] = {
+            { 16, 128, 128, 0, 0, 0 },
+            { 235, 128, 128, 255, 255, 255 },
+            { 81, 90, 240, 0, 0, 255 },
+            { 145, 54, 34, 0, 255, 0 },
+            { 41, 240, 110, 255, 0, 0 }
+        };
+
+        for (const auto& k : kernels) {
+            for (const auto& c : colours) {
+                const uint8 y[] = { c[0], c[0] };
+                uint8 dst[8];
+                k.Nv12(dst, y, c + 1, 2);
+
+                int32 errors = 0;
+                for (int32 i = 0; i < 3; ++i) {
+                    errors += (FMath::Abs(dst[i] - c[3 + i]) > 2) ? 1 : 0;
+                    errors += (dst[i] != dst[4 + i]) ? 1 : 0;
+                }
+
+                TestEqual(FString::Printf(TEXT("%s kernel converts YUV ")
+                    TEXT("(%d, %d, %d) to BGR (%d, %d, %d)"), k.Name,
+                    c[0], c[1], c[2], c[3], c[4], c[5]), errors, 0);
+            }
+        }
+    }
+
+    for (const auto& k : kernels) {
+        for (const auto cnt : SampleCounts) {
+            // The chroma pairs are shared by two pixels.
+            const auto y = MakeYuv(cnt, cnt, false);
+            const auto uv = MakeYuv(cnt + 1, cnt + 1, true);
+
+            TArray<uint8> expected;
+            expected.Init(0xCD, 4 * cnt + 64);
+            kernels[0].Nv12(expected.GetData(), y.GetData(), uv.GetData(),
+                cnt);
+
+            TArray<uint8> dst;
+            dst.Init(0xCD, 4 * cnt + 64);
+            k.Nv12(dst.GetData(), y.GetData(), uv.GetData(), cnt);
+
+            int32 errors = 0;
+            for (int32 i = 0; i < cnt; ++i) {
+                const auto c = uv.GetData() + (i & ~1);
+                errors += CheckYuv(dst.GetData() + 4 * i, y[i], c[0], c[1]);
+            }
+
+            TestEqual(FString::Printf(TEXT("%s kernel converts %d NV12 ")
+                TEXT("pixels within the error bound"), k.Name, cnt),
+                errors, 0);
+            TestTrue(FString::Printf(TEXT("%s kernel converts %d NV12 ")
+                TEXT("pixels like the scalar one"), k.Name, cnt),
+                FMemory::Memcmp(dst.GetData(), expected.GetData(),
+                    dst.Num()) == 0);
+        }
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectYuy2Test,
+    "AzureKinect.Conversion.Yuy2",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectYuy2Test::RunTest
+ */
+bool FAzureKinectYuy2Test::RunTest(const FString& parameters) {
+    const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+
+    for (const auto& k : kernels) {
+        for (const auto cnt : SampleCounts) {
+            // Build the interleaved Y0, U, Y1, V row from valid luma and
+            // chroma samples, padded to an even number of pixels.
+            const auto y = MakeYuv(cnt + 1, cnt, false);
+            const auto uv = MakeYuv(cnt + 1, cnt + 1, true);
+            TArray<uint8> src;
+            src.SetNumUninitialized(2 * (cnt + 1));
+            for (int32 i = 0; i < cnt + 1; ++i) {
+                src[2 * i] = y[i];
+                src[2 * i + 1] = uv[i];
+            }
+
+            TArray<uint8> expected;
+            expected.Init(0xCD, 4 * cnt + 64);
+            kernels[0].Yuy2(expected.GetData(), src.GetData(), cnt);
+
+            TArray<uint8> dst;
+            dst.Init(0xCD, 4 * cnt + 64);
+            k.Yuy2(dst.GetData(), src.GetData(), cnt);
+
+            int32 errors = 0;
+            for (int32 i = 0; i < cnt; ++i) {
+                const auto c = uv.GetData() + (i & ~1);
+                errors += CheckYuv(dst.GetData() + 4 * i, y[i], c[0], c[1]);
+            }
+
+            TestEqual(FString::Printf(TEXT("%s kernel converts %d YUY2 ")
+                TEXT("pixels within the error bound"), k.Name, cnt),
+                errors, 0);
+            TestTrue(FString::Printf(TEXT("%s kernel converts %d YUY2 ")
+                TEXT("pixels like the scalar one"), k.Name, cnt),
+                FMemory::Memcmp(dst.GetData(), expected.GetData(),
+                    dst.Num()) == 0);
+        }
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectSpatialTest,
+    "AzureKinect.Conversion.Spatial",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectSpatialTest::RunTest
+ */
+bool FAzureKinectSpatialTest::RunTest(const FString& parameters) {
+    const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+
+    for (const auto& k : kernels) {
+        for (const auto cnt : SampleCounts) {
+            const auto above = MakeDepth(cnt, 3 * cnt);
+            const auto row = MakeDepth(cnt, 3 * cnt + 1);
+            const auto below = MakeDepth(cnt, 3 * cnt + 2);
+
+            for (int32 m = 0; m < 4; ++m) {
+                const auto smooth = ((m & 1) != 0);
+                const auto fill = ((m & 2) != 0);
+
+                TArray<uint16> expected;
+                expected.Init(0xCDCD, cnt + 32);
+                kernels[0].Spatial(expected.GetData(), above.GetData(),
+                    row.GetData(), below.GetData(), RelativeThreshold,
+                    MinThreshold, smooth, fill, cnt);
+
+                TArray<uint16> dst;
+                dst.Init(0xCDCD, cnt + 32);
+                k.Spatial(dst.GetData(), above.GetData(), row.GetData(),
+                    below.GetData(), RelativeThreshold, MinThreshold, smooth,
+                    fill, cnt);
+
+                TestTrue(FString::Printf(TEXT("%s kernel filters %d samples ")
+                    TEXT("like the scalar one (smooth %d, fill %d)"), k.Name,
+                    cnt, smooth, fill), dst == expected);
+            }
+        }
+    }
+
+    // A flat surface with a flying pixel, a hole and a bump, which are placed
+    // such that the vector loops process them.
+    {
+        const int32 cnt = 64;
+        TArray<uint16> above;
+        above.Init(2000, cnt);
+        auto row = above;
+        row[10] = 6000;
+        row[20] = 0;
+        row[30] = 2009;
+
+        for (const auto& k : kernels) {
+            for (int32 m = 0; m < 4; ++m) {
+                const auto smooth = ((m & 1) != 0);
+                const auto fill = ((m & 2) != 0);
+                TArray<uint16> dst;
+                dst.SetNumZeroed(cnt);
+                k.Spatial(dst.GetData(), above.GetData(), row.GetData(),
+                    above.GetData(), RelativeThreshold, MinThreshold, smooth,
+                    fill, cnt);
+
+                // The bump becomes (2 * 2009 + 4 * 2000) / 6, rounded.
+                TestEqual(FString::Printf(TEXT("%s kernel handles the flying ")
+                    TEXT("pixel (smooth %d, fill %d)"), k.Name, smooth, fill),
+                    dst[10], static_cast<uint16>(smooth ? 0 : 6000));
+                TestEqual(FString::Printf(TEXT("%s kernel handles the hole ")
+                    TEXT("(smooth %d, fill %d)"), k.Name, smooth, fill),
+                    dst[20], static_cast<uint16>(fill ? 2000 : 0));
+                TestEqual(FString::Printf(TEXT("%s kernel handles the bump ")
+                    TEXT("(smooth %d, fill %d)"), k.Name, smooth, fill),
+                    dst[30], static_cast<uint16>(smooth ? 2003 : 2009));
+                TestEqual(FString::Printf(TEXT("%s kernel keeps the surface ")
+                    TEXT("(smooth %d, fill %d)"), k.Name, smooth, fill),
+                    dst[50], static_cast<uint16>(2000));
+            }
+        }
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectTemporalTest,
+    "AzureKinect.Conversion.Temporal",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectTemporalTest::RunTest
+ */
+bool FAzureKinectTemporalTest::RunTest(const FString& parameters) {
+    const auto kernels = FAzureKinectConversion::GetSupportedKernels();
+    // New samples have a weight of 20 %.
+    const int16 weight = 6554;
+
+    for (const auto& k : kernels) {
+        for (const auto cnt : SampleCounts) {
+            const auto history = MakeDepth(cnt, 2 * cnt);
+            const auto depth = MakeDepth(cnt, 2 * cnt + 1);
+
+            auto expected = history;
+            expected.SetNum(cnt + 32);
+            kernels[0].Temporal(expected.GetData(), depth.GetData(),
+                RelativeThreshold, MinThreshold, weight, cnt);
+
+            auto actual = history;
+            actual.SetNum(cnt + 32);
+            k.Temporal(actual.GetData(), depth.GetData(), RelativeThreshold,
+                MinThreshold, weight, cnt);
+
+            TestTrue(FString::Printf(TEXT("%s kernel blends %d samples like ")
+                TEXT("the scalar one"), k.Name, cnt), actual == expected);
+        }
+    }
+
+    // Samples 0 and 1 are static, sample 2 moves away, sample 3 becomes
+    // invalid and sample 4 becomes valid. The rest pads the row such that
+    // the vector loops process it.
+    {
+        const int32 cnt = 64;
+        TArray<uint16> initial;
+        initial.Init(2000, cnt);
+        initial[4] = 0;
+        TArray<uint16> depth;
+        depth.Init(2000, cnt);
+        depth[0] = 2030;
+        depth[1] = 1970;
+        depth[2] = 2500;
+        depth[3] = 0;
+
+        for (const auto& k : kernels) {
+            auto history = initial;
+            k.Temporal(history.GetData(), depth.GetData(), RelativeThreshold,
+                MinThreshold, weight, cnt);
+
+            // A fifth of the difference of 30 mm is 6 mm, which is rounded
+            // down.
+            TestEqual(FString::Printf(TEXT("%s kernel moves the history ")
+                TEXT("up"), k.Name), history[0], static_cast<uint16>(2006));
+            TestEqual(FString::Printf(TEXT("%s kernel moves the history ")
+                TEXT("down"), k.Name), history[1], static_cast<uint16>(1993));
+            TestEqual(FString::Printf(TEXT("%s kernel resets the history on ")
+                TEXT("motion"), k.Name), history[2], static_cast<uint16>(2500));
+            TestEqual(FString::Printf(TEXT("%s kernel invalidates the ")
+                TEXT("history"), k.Name), history[3], static_cast<uint16>(0));
+            TestEqual(FString::Printf(TEXT("%s kernel initialises the ")
+                TEXT("history"), k.Name), history[4], static_cast<uint16>(2000));
+
+            // A static sample must converge to within the resolution of the
+            // weight, i.e. four millimetres.
+            for (int32 i = 0; i < 50; ++i) {
+                k.Temporal(history.GetData(), depth.GetData(),
+                    RelativeThreshold, MinThreshold, weight, cnt);
+            }
+
+            TestTrue(FString::Printf(TEXT("%s kernel converges from below ")
+                TEXT("to %d"), k.Name, history[0]),
+                FMath::Abs(history[0] - 2030) <= 4);
+            TestTrue(FString::Printf(TEXT("%s kernel converges from above ")
+                TEXT("to %d"), k.Name, history[1]),
+                FMath::Abs(history[1] - 1970) <= 4);
+        }
+    }
+
+    return true;
+}
+
+#endif /* WITH_DEV_AUTOMATION_TESTS */
@@ -0,0 +1,217 @@
+﻿// <copyright file="AzureKinectDecimationTests.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+
+#include "AzureKinectDecimation.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+    /*
+     * ::MakeLine
+     */
+    FAzureKinectPointCloud MakeLine(const int32 cnt, const float spacing) {
+        // The colour of each point encodes its index, such that the tests
+        // can check that colours stay with their points.
+        FAzureKinectPointCloud retval;
+        retval.Positions.SetNumUninitialized(cnt);
+        retval.Colours.SetNumUninitialized(cnt);
+
+        for (int32 i = 0; i < cnt; ++i) {
+            retval.Positions[i] = FVector3f(i * spacing, 0.0f, 100.0f);
+            retval.Colours[i] = FColor(static_cast<uint8>(i & 0xFF),
+                static_cast<uint8>((i >> 8) & 0xFF),
+                static_cast<uint8>((i >> 16) & 0xFF),
+                0xFF);
+        }
+
+        return retval;
+    }
+
+    /*
+     * ::MakePlane
+     */
+    FAzureKinectPointCloud MakePlane(const int32 width,
+            const int32 height,
+            const float spacing) {
+        FAzureKinectPointCloud retval;
+        retval.Positions.Reserve(width * height);
+
+        for (int32 y = 0; y < height; ++y) {
+            for (int32 x = 0; x < width; ++x) {
+                retval.Positions.Emplace((x + 0.5f) * spacing,
+                    (y + 0.5f) * spacing,
+                    100.0f);
+            }
+        }
+
+        return retval;
+    }
+
+} /* namespace */
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectFixedVoxelSizeTest,
+    "AzureKinect.Decimation.FixedVoxelSize",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectFixedVoxelSizeTest::RunTest
+ */
+bool FAzureKinectFixedVoxelSizeTest::RunTest(const FString& parameters) {
+    // A 10 x 10 grid of points with a spacing of 1 cm, each 2 cm voxel of
+    // which holds 2 x 2 points.
+    auto source = MakePlane(10, 10, 1.0f);
+    source.Colours.SetNumUninitialized(source.Positions.Num());
+    for (int32 i = 0; i < source.Positions.Num(); ++i) {
+        const auto& p = source.Positions[i];
+        source.Colours[i] = FColor(static_cast<uint8>(p.X * 20.0f), 0,
+            static_cast<uint8>(p.Y * 20.0f), 0xFF);
+    }
+
+    {
+        FAzureKinectDecimation decimation;
+        auto cloud = source;
+        TestEqual(TEXT("Without voxel size and target, all points are ")
+            TEXT("retained"), decimation.Decimate(cloud, 0.0f, 0, false),
+            source.Positions.Num());
+        TestTrue(TEXT("Without voxel size and target, the points are ")
+            TEXT("unchanged"), cloud.Positions == source.Positions);
+        TestEqual(TEXT("Without voxel size and target, there is no voxel ")
+            TEXT("size"), decimation.GetVoxelSize(), 0.0f);
+    }
+
+    for (int32 a = 0; a < 2; ++a) {
+        const auto average = (a != 0);
+        FAzureKinectDecimation decimation;
+        auto cloud = source;
+
+        TestEqual(FString::Printf(TEXT("Each voxel yields one point ")
+            TEXT("(averaging %d)"), a),
+            decimation.Decimate(cloud, 2.0f, 0, average), 25);
+        TestEqual(TEXT("The positions are truncated"),
+            cloud.Positions.Num(), 25);
+        TestEqual(TEXT("The colours are truncated"),
+            cloud.Colours.Num(), 25);
+        TestEqual(TEXT("The fixed voxel size is used"),
+            decimation.GetVoxelSize(), 2.0f);
+
+        // The voxels are emitted in the order of their first points, which
+        // is row-major. The first point is at 0.5 cm in the voxel, the
+        // centroid at 1 cm.
+        const auto offset = average ? 1.0f : 0.5f;
+        int32 errors = 0;
+        for (int32 i = 0; i < FMath::Min(cloud.Positions.Num(), 25); ++i) {
+            const FVector3f expected(2.0f * (i % 5) + offset,
+                2.0f * (i / 5) + offset,
+                100.0f);
+            const auto& p = cloud.Positions[i];
+            const auto& c = cloud.Colours[i];
+            errors += p.Equals(expected, 1e-4f) ? 0 : 1;
+            errors += (c.R != FMath::RoundToInt32(p.X * 20.0f)) ? 1 : 0;
+            errors += (c.B != FMath::RoundToInt32(p.Y * 20.0f)) ? 1 : 0;
+        }
+
+        TestEqual(FString::Printf(TEXT("The points and colours of the ")
+            TEXT("voxels are correct (averaging %d)"), a), errors, 0);
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectTargetPointsTest,
+    "AzureKinect.Decimation.TargetPoints",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectTargetPointsTest::RunTest
+ */
+bool FAzureKinectTargetPointsTest::RunTest(const FString& parameters) {
+    // Points on a surface are decimated by adapting the voxel size alone,
+    // which must also converge over consecutive frames.
+    {
+        const auto source = MakePlane(300, 300, 0.5f);
+        const int32 target = 2000;
+        FAzureKinectDecimation decimation;
+
+        for (int32 f = 0; f < 5; ++f) {
+            auto cloud = source;
+            const auto cnt = decimation.Decimate(cloud, 0.0f, target, true);
+            TestTrue(FString::Printf(TEXT("Frame %d of the plane has %d ")
+                TEXT("points, which is at most %d"), f, cnt, target),
+                cnt <= target);
+            TestTrue(FString::Printf(TEXT("Frame %d of the plane has %d ")
+                TEXT("points, which is not far below %d"), f, cnt, target),
+                cnt > target / 4);
+            TestEqual(TEXT("The point cloud is truncated"),
+                cloud.Positions.Num(), cnt);
+        }
+    }
+
+    // The number of points on a line only falls with the voxel size rather
+    // than its square, so the passes cannot meet the target and the rest
+    // must be thinned out.
+    for (const auto target : { 100, 1000 }) {
+        for (int32 a = 0; a < 2; ++a) {
+            const auto average = (a != 0);
+            const auto source = MakeLine(100000, 0.01f);
+            FAzureKinectDecimation decimation;
+            auto cloud = source;
+
+            const auto cnt = decimation.Decimate(cloud, 0.0f, target,
+                average);
+            TestEqual(FString::Printf(TEXT("The line is decimated to %d ")
+                TEXT("points (averaging %d)"), target, a), cnt, target);
+            TestEqual(TEXT("The positions are truncated"),
+                cloud.Positions.Num(), cnt);
+            TestEqual(TEXT("The colours are truncated"),
+                cloud.Colours.Num(), cnt);
+
+            if (cloud.Positions.Num() < 2) {
+                continue;
+            }
+
+            // The points must still cover the whole line in their order.
+            int32 errors = 0;
+            for (int32 i = 1; i < cloud.Positions.Num(); ++i) {
+                errors += (cloud.Positions[i].X > cloud.Positions[i - 1].X)
+                    ? 0 : 1;
+            }
+            TestEqual(TEXT("The retained points are in order"), errors, 0);
+            TestTrue(TEXT("The retained points cover the line"),
+                (cloud.Positions[0].X < 50.0f)
+                && (cloud.Positions.Last().X > 950.0f));
+
+            // Without averaging, the retained points are input points that
+            // must have kept their colours.
+            if (!average) {
+                errors = 0;
+                for (int32 i = 0; i < cloud.Positions.Num(); ++i) {
+                    const auto& c = cloud.Colours[i];
+                    const auto index = c.R | (c.G << 8) | (c.B << 16);
+                    errors += (cloud.Positions[i]
+                        == source.Positions[index]) ? 0 : 1;
+                }
+                TestEqual(TEXT("The colours stay with their points"),
+                    errors, 0);
+            }
+        }
+    }
+
+    return true;
+}
+
+#endif /* WITH_DEV_AUTOMATION_TESTS */
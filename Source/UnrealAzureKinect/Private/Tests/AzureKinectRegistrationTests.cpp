@@ -0,0 +1,345 @@
+﻿// <copyright file="AzureKinectRegistrationTests.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CoreMinimal.h"
+
+#include "Misc/AutomationTest.h"
+
+#include "AzureKinectRegistration.h"
+#include "AzureKinectWorkerPool.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+    constexpr int32 DepthWidth = 640;
+    constexpr int32 DepthHeight = 576;
+    constexpr int32 ColourWidth = 1280;
+    constexpr int32 ColourHeight = 720;
+
+    /// <summary>
+    /// The depth of the plane in front of the depth camera all mapping tests
+    /// use in millimetres.
+    /// </summary>
+    constexpr uint16 PlaneDepth = 1500;
+
+    /// <summary>
+    /// The ray of a depth pixel at a depth of one.
+    /// </summary>
+    struct FRayReference {
+        int32 X;
+        int32 Y;
+        float RayX;
+        float RayY;
+    };
+
+    /// <summary>
+    /// The colour pixel a depth pixel on the plane is nearest to, or -1 if it
+    /// is outside the colour image.
+    /// </summary>
+    struct FColourReference {
+        int32 X;
+        int32 Y;
+        int32 U;
+        int32 V;
+    };
+
+    /// <summary>
+    /// The depth of the plane in the colour camera at a colour pixel, or zero
+    /// if the pixel is not covered by the depth camera.
+    /// </summary>
+    struct FDepthReference {
+        int32 U;
+        int32 V;
+        float Depth;
+    };
+
+    // The references were computed independently in double precision from
+    // the Brown-Conrady model of the SDK for the calibration created by
+    // MakeCalibration. Rays were unprojected using Newton's method.
+    const FRayReference RayReferences[] = {
+        { 320, 288, 0.0000000f, 0.0000000f },
+        { 100, 50, -0.5351036f, -0.5788785f },
+        { 500, 400, 0.3828476f, 0.2382081f },
+        { 213, 511, -0.2345971f, 0.4888265f },
+        { 600, 150, 0.6662767f, -0.3284780f }
+    };
+
+    const FColourReference ColourReferences[] = {
+        { 320, 288, 625, 302 },
+        { 100, 288, 332, 301 },
+        { 540, 288, 917, 301 },
+        { 320, 500, 625, 569 },
+        { 150, 120, 384, 62 },
+        { 480, 450, 831, 511 },
+        { 320, 60, -1, -1 },
+        { 320, 573, 626, 683 }
+    };
+
+    const FDepthReference DepthReferences[] = {
+        { 638, 367, 1512.47f },
+        { 400, 200, 1470.73f },
+        { 900, 500, 1547.36f },
+        { 640, 100, 1446.73f },
+        { 640, 650, 1588.80f },
+        { 5, 360, 0.0f },
+        { 1275, 360, 0.0f }
+    };
+
+    /*
+     * ::MakeCalibration
+     */
+    k4a::calibration MakeCalibration(void) {
+        // This is the calibration of the registration benchmark in NFOV
+        // unbinned mode.
+        k4a::calibration retval;
+        FMemory::Memzero(static_cast<k4a_calibration_t&>(retval));
+        retval.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+        retval.color_resolution = K4A_COLOR_RESOLUTION_720P;
+
+        {
+            auto& c = retval.depth_camera_calibration;
+            auto& p = c.intrinsics.parameters.param;
+            c.resolution_width = DepthWidth;
+            c.resolution_height = DepthHeight;
+            c.metric_radius = 1.74f;
+            c.intrinsics.type = K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY;
+            c.intrinsics.parameter_count = 14;
+            p.cx = 0.5f * DepthWidth;
+            p.cy = 0.5f * DepthHeight;
+            p.fx = p.fy = 504.0f;
+            p.k1 = 0.55f;
+            p.k2 = -0.02f;
+            p.k3 = -0.002f;
+            p.k4 = 0.9f;
+            p.k5 = 0.2f;
+            p.k6 = -0.01f;
+            p.p1 = p.p2 = 0.0001f;
+            p.metric_radius = c.metric_radius;
+            c.extrinsics.rotation[0] = 1.0f;
+            c.extrinsics.rotation[4] = 1.0f;
+            c.extrinsics.rotation[8] = 1.0f;
+        }
+
+        {
+            auto& c = retval.color_camera_calibration;
+            auto& p = c.intrinsics.parameters.param;
+            c.resolution_width = ColourWidth;
+            c.resolution_height = ColourHeight;
+            c.metric_radius = 1.7f;
+            c.intrinsics.type = K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY;
+            c.intrinsics.parameter_count = 14;
+            p.cx = 638.0f;
+            p.cy = 367.0f;
+            p.fx = p.fy = 610.0f;
+            p.k1 = 0.08f;
+            p.k2 = -0.06f;
+            p.k3 = 0.02f;
+            p.p1 = p.p2 = 0.0005f;
+            p.metric_radius = c.metric_radius;
+        }
+
+        // The colour camera is tilted by six degrees and offset by about
+        // 32 mm from the depth camera.
+        {
+            const auto a = FMath::DegreesToRadians(6.0f);
+            const float r[] = {
+                1.0f, 0.0f, 0.0f,
+                0.0f, FMath::Cos(a), -FMath::Sin(a),
+                0.0f, FMath::Sin(a), FMath::Cos(a)
+            };
+            const float t[] = { -32.0f, -2.0f, 4.0f };
+
+            for (int32 i = 0; i < K4A_CALIBRATION_TYPE_NUM; ++i) {
+                for (int32 j = 0; j < K4A_CALIBRATION_TYPE_NUM; ++j) {
+                    auto& e = retval.extrinsics[i][j];
+                    e.rotation[0] = e.rotation[4] = e.rotation[8] = 1.0f;
+                }
+            }
+
+            auto& d2c = retval.extrinsics[K4A_CALIBRATION_TYPE_DEPTH]
+                [K4A_CALIBRATION_TYPE_COLOR];
+            auto& c2d = retval.extrinsics[K4A_CALIBRATION_TYPE_COLOR]
+                [K4A_CALIBRATION_TYPE_DEPTH];
+            for (int32 i = 0; i < 3; ++i) {
+                c2d.translation[i] = 0.0f;
+                for (int32 j = 0; j < 3; ++j) {
+                    d2c.rotation[3 * i + j] = r[3 * i + j];
+                    c2d.rotation[3 * i + j] = r[3 * j + i];
+                    c2d.translation[i] -= r[3 * j + i] * t[j];
+                }
+                d2c.translation[i] = t[i];
+            }
+
+            retval.color_camera_calibration.extrinsics = d2c;
+        }
+
+        return retval;
+    }
+
+    /*
+     * ::MakeRegistration
+     */
+    bool MakeRegistration(FAzureKinectRegistration& registration,
+            FAutomationTestBase& test) {
+        try {
+            registration.Reset(MakeCalibration());
+        } catch (k4a::error ex) {
+            FString msg(ANSI_TO_TCHAR(ex.what()));
+            test.AddError(FString::Printf(TEXT("The synthetic calibration ")
+                TEXT("was rejected: %s"), *msg));
+            return false;
+        }
+
+        test.TestTrue(TEXT("The registration is valid"),
+            registration.IsValid());
+        test.TestEqual(TEXT("Width of the depth image"),
+            registration.GetDepthWidth(), DepthWidth);
+        test.TestEqual(TEXT("Height of the depth image"),
+            registration.GetDepthHeight(), DepthHeight);
+        test.TestEqual(TEXT("Width of the colour image"),
+            registration.GetColourWidth(), ColourWidth);
+        test.TestEqual(TEXT("Height of the colour image"),
+            registration.GetColourHeight(), ColourHeight);
+        return registration.IsValid();
+    }
+
+} /* namespace */
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectRaysTest,
+    "AzureKinect.Registration.Rays",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectRaysTest::RunTest
+ */
+bool FAzureKinectRaysTest::RunTest(const FString& parameters) {
+    FAzureKinectRegistration registration;
+    if (!MakeRegistration(registration, *this)) {
+        return false;
+    }
+
+    // 1e-4 at a depth of one is about a twentieth of a depth pixel.
+    for (const auto& r : RayReferences) {
+        const auto i = r.Y * DepthWidth + r.X;
+        TestNearlyEqual(FString::Printf(TEXT("x-component of the ray of ")
+            TEXT("(%d, %d)"), r.X, r.Y), registration.GetRaysX()[i],
+            r.RayX, 1e-4f);
+        TestNearlyEqual(FString::Printf(TEXT("y-component of the ray of ")
+            TEXT("(%d, %d)"), r.X, r.Y), registration.GetRaysY()[i],
+            r.RayY, 1e-4f);
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectColourToDepthTest,
+    "AzureKinect.Registration.ColourToDepth",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectColourToDepthTest::RunTest
+ */
+bool FAzureKinectColourToDepthTest::RunTest(const FString& parameters) {
+    FAzureKinectRegistration registration;
+    if (!MakeRegistration(registration, *this)) {
+        return false;
+    }
+
+    // Each colour pixel encodes its own coordinates, and the alpha channel
+    // distinguishes it from the pixels without colour.
+    TArray<uint32> colour;
+    colour.SetNumUninitialized(ColourWidth * ColourHeight);
+    for (int32 v = 0, i = 0; v < ColourHeight; ++v) {
+        for (int32 u = 0; u < ColourWidth; ++u, ++i) {
+            colour[i] = 0xFF000000 | (v << 11) | u;
+        }
+    }
+
+    TArray<uint16> depth;
+    depth.Init(PlaneDepth, DepthWidth * DepthHeight);
+
+    FAzureKinectWorkerPool workers;
+    workers.Start(2, 0);
+    TArray<uint32> dst;
+    dst.SetNumZeroed(depth.Num());
+    registration.ColourToDepth(dst.GetData(), colour.GetData(),
+        depth.GetData(), workers, 64);
+    workers.Shutdown();
+
+    // The interpolated projection may round to a neighbouring pixel.
+    for (const auto& r : ColourReferences) {
+        const auto c = dst[r.Y * DepthWidth + r.X];
+
+        if (r.U < 0) {
+            TestEqual(FString::Printf(TEXT("(%d, %d) is outside the colour ")
+                TEXT("image"), r.X, r.Y), c, 0u);
+
+        } else {
+            const int32 u = c & 0x7FF;
+            const int32 v = (c >> 11) & 0x3FF;
+            TestTrue(FString::Printf(TEXT("(%d, %d) is coloured"), r.X, r.Y),
+                c != 0);
+            TestTrue(FString::Printf(TEXT("(%d, %d) is coloured by (%d, %d), ")
+                TEXT("which is near (%d, %d)"), r.X, r.Y, u, v, r.U, r.V),
+                (FMath::Abs(u - r.U) <= 1) && (FMath::Abs(v - r.V) <= 1));
+        }
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectDepthToColourTest,
+    "AzureKinect.Registration.DepthToColour",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectDepthToColourTest::RunTest
+ */
+bool FAzureKinectDepthToColourTest::RunTest(const FString& parameters) {
+    FAzureKinectRegistration registration;
+    if (!MakeRegistration(registration, *this)) {
+        return false;
+    }
+
+    TArray<uint16> depth;
+    depth.Init(PlaneDepth, DepthWidth * DepthHeight);
+
+    FAzureKinectWorkerPool workers;
+    workers.Start(2, 0);
+    TArray<uint16> dst;
+    dst.Init(0xCDCD, ColourWidth * ColourHeight);
+    registration.DepthToColour(dst.GetData(), depth.GetData(), workers, 64);
+    workers.Shutdown();
+
+    // The quads are splatted with their mean depth, which is rounded to
+    // millimetres.
+    for (const auto& r : DepthReferences) {
+        const auto d = dst[r.V * ColourWidth + r.U];
+
+        if (r.Depth <= 0.0f) {
+            TestEqual(FString::Printf(TEXT("(%d, %d) is not covered by the ")
+                TEXT("depth camera"), r.U, r.V), d, static_cast<uint16>(0));
+        } else {
+            TestNearlyEqual(FString::Printf(TEXT("Depth of (%d, %d)"),
+                r.U, r.V), static_cast<float>(d), r.Depth, 3.0f);
+        }
+    }
+
+    return true;
+}
+
+#endif /* WITH_DEV_AUTOMATION_TESTS */
@@ -0,0 +1,366 @@
+﻿// <copyright file="AzureKinectSkeletonFilterTests.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CoreMinimal.h"
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "AzureKinectSkeletonFilter.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Note: the joint streams are synthesised from known trajectories and uniform
+// noise from a fixed seed rather than recorded from a device, because the
+// error of the filters can only be measured against the true positions, which
+// a recording does not provide.
+
+namespace {
+
+    constexpr auto JointCount = FAzureKinectSkeletonData::JointCount;
+
+    /// <summary>
+    /// The number of frames in a replayed stream, i.e. four seconds.
+    /// </summary>
+    constexpr int32 FrameCount = 120;
+
+    /// <summary>
+    /// The time between two frames of the tracker in seconds.
+    /// </summary>
+    constexpr double FrameTime = 1.0 / 30.0;
+
+    /// <summary>
+    /// The number of frames at the begin of a stream that are not evaluated,
+    /// because the filters are still settling.
+    /// </summary>
+    constexpr int32 SettlingFrames = 30;
+
+    /// <summary>
+    /// The share of the jitter of the tracked positions that may remain
+    /// after filtering.
+    /// </summary>
+    constexpr float MaxJitterShare = 0.7f;
+
+    /// <summary>
+    /// A movement of all joints along the x-axis and the largest RMS error
+    /// of the filters in centimetres for it.
+    /// </summary>
+    /// <remarks>
+    /// The One Euro filter lags behind moving joints, whereas the Kalman
+    /// filter predicts their constant velocity.
+    /// </remarks>
+    struct FTrajectory {
+        const TCHAR *Name;
+        float (*X)(const int32 frame);
+        float MaxOneEuroError;
+        float MaxKalmanError;
+    };
+
+    const FTrajectory Trajectories[] = {
+        { TEXT("Rest"),
+            [](const int32) { return 0.0f; },
+            0.5f, 0.8f },
+        { TEXT("Linear"),
+            [](const int32 f) {
+                return static_cast<float>(50.0 * f * FrameTime);
+            },
+            3.5f, 0.8f },
+        { TEXT("Sine"),
+            [](const int32 f) {
+                return static_cast<float>(15.0 * FMath::Sin(PI * f
+                    * FrameTime));
+            },
+            3.0f, 0.8f }
+    };
+
+    /*
+     * ::MakeSettings
+     */
+    FAzureKinectSkeletonFilterSettings MakeSettings(
+            const EKinectSkeletonFilter filter) {
+        FAzureKinectSkeletonFilterSettings retval;
+        retval.Filter = filter;
+        return retval;
+    }
+
+    /*
+     * ::MakeSkeleton
+     */
+    FAzureKinectSkeletonData MakeSkeleton(const int32 id, const float x) {
+        FAzureKinectSkeletonData retval;
+        retval.ID = id;
+
+        for (int32 j = 0; j < JointCount; ++j) {
+            retval.Confidences[j] = EKinectJointConfidence::MEDIUM;
+            retval.Positions[j] = FVector3f(x, 0.0f, 0.0f);
+            retval.Rotations[j] = FQuat4f::Identity;
+        }
+
+        return retval;
+    }
+
+    /*
+     * ::GetName
+     */
+    const TCHAR *GetName(const EKinectSkeletonFilter filter) {
+        return (filter == EKinectSkeletonFilter::KALMAN)
+            ? TEXT("Kalman")
+            : TEXT("One Euro");
+    }
+
+    /*
+     * ::Replay
+     */
+    void Replay(float& error,
+            float& jitter,
+            float& trackedJitter,
+            const EKinectSkeletonFilter filter,
+            const FTrajectory& trajectory) {
+        // The stream is reproducible, because the tracking noise of up to
+        // 1 cm per axis is drawn from a seeded generator.
+        constexpr int32 cntValues = 3 * JointCount;
+        const auto settings = MakeSettings(filter);
+        FRandomStream rng(42);
+        FAzureKinectSkeletonFilter f;
+
+        TArray<float> filtered;
+        TArray<float> tracked;
+        filtered.SetNumUninitialized(FrameCount * cntValues);
+        tracked.SetNumUninitialized(FrameCount * cntValues);
+
+        for (int32 i = 0; i < FrameCount; ++i) {
+            const auto x = trajectory.X(i);
+            auto skeleton = MakeSkeleton(1, x);
+            for (auto& p : skeleton.Positions) {
+                p += FVector3f(rng.FRandRange(-1.0f, 1.0f),
+                    rng.FRandRange(-1.0f, 1.0f),
+                    rng.FRandRange(-1.0f, 1.0f));
+            }
+
+            for (int32 j = 0; j < JointCount; ++j) {
+                auto t = tracked.GetData() + i * cntValues + 3 * j;
+                t[0] = skeleton.Positions[j].X - x;
+                t[1] = skeleton.Positions[j].Y;
+                t[2] = skeleton.Positions[j].Z;
+            }
+
+            f.Apply(&skeleton, 1, 1.0 + i * FrameTime, settings);
+
+            for (int32 j = 0; j < JointCount; ++j) {
+                auto e = filtered.GetData() + i * cntValues + 3 * j;
+                e[0] = skeleton.Positions[j].X - x;
+                e[1] = skeleton.Positions[j].Y;
+                e[2] = skeleton.Positions[j].Z;
+            }
+        }
+
+        // The error is the RMS of the deviation from the trajectory, the
+        // jitter the RMS of its second difference between frames.
+        auto rms = [](const TArray<float>& values, const bool difference) {
+            double sum = 0.0;
+            int32 cnt = 0;
+
+            for (int32 i = SettlingFrames; i < FrameCount - 1; ++i) {
+                for (int32 v = 0; v < cntValues; ++v) {
+                    const auto c = values[i * cntValues + v];
+                    const auto d = difference
+                        ? values[(i - 1) * cntValues + v] - 2.0f * c
+                            + values[(i + 1) * cntValues + v]
+                        : c;
+                    sum += d * d;
+                    ++cnt;
+                }
+            }
+
+            return static_cast<float>(FMath::Sqrt(sum / cnt));
+        };
+
+        error = rms(filtered, false);
+        jitter = rms(filtered, true);
+        trackedJitter = rms(tracked, true);
+    }
+
+} /* namespace */
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectSkeletonFilterAccuracyTest,
+    "AzureKinect.SkeletonFilter.Accuracy",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectSkeletonFilterAccuracyTest::RunTest
+ */
+bool FAzureKinectSkeletonFilterAccuracyTest::RunTest(
+        const FString& parameters) {
+    for (const auto filter : { EKinectSkeletonFilter::ONE_EURO,
+            EKinectSkeletonFilter::KALMAN }) {
+        for (const auto& t : Trajectories) {
+            float error, jitter, trackedJitter;
+            Replay(error, jitter, trackedJitter, filter, t);
+
+            const auto maxError = (filter == EKinectSkeletonFilter::KALMAN)
+                ? t.MaxKalmanError
+                : t.MaxOneEuroError;
+            TestTrue(FString::Printf(TEXT("%s filter has an error of %f cm ")
+                TEXT("for %s, which is at most %f cm"), GetName(filter),
+                error, t.Name, maxError), error <= maxError);
+            TestTrue(FString::Printf(TEXT("%s filter leaves a jitter of %f ")
+                TEXT("cm of %f cm for %s"), GetName(filter), jitter,
+                trackedJitter, t.Name),
+                jitter <= MaxJitterShare * trackedJitter);
+        }
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectSkeletonFilterBodyIDsTest,
+    "AzureKinect.SkeletonFilter.BodyIDs",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectSkeletonFilterBodyIDsTest::RunTest
+ */
+bool FAzureKinectSkeletonFilterBodyIDsTest::RunTest(
+        const FString& parameters) {
+    for (const auto filter : { EKinectSkeletonFilter::ONE_EURO,
+            EKinectSkeletonFilter::KALMAN }) {
+        const auto name = GetName(filter);
+        const auto settings = MakeSettings(filter);
+        FAzureKinectSkeletonFilter f;
+        auto time = 1.0;
+
+        // Bodies 1 and 2 rest far apart, so the filters settle on them.
+        for (int32 i = 0; i < SettlingFrames; ++i, time += FrameTime) {
+            FAzureKinectSkeletonData skeletons[] = {
+                MakeSkeleton(1, 0.0f),
+                MakeSkeleton(2, 100.0f)
+            };
+            f.Apply(skeletons, UE_ARRAY_COUNT(skeletons), time, settings);
+        }
+
+        // If the tracker reorders the bodies, each one must still move
+        // smoothly from its own state.
+        {
+            FAzureKinectSkeletonData skeletons[] = {
+                MakeSkeleton(2, 110.0f),
+                MakeSkeleton(1, 10.0f)
+            };
+            f.Apply(skeletons, UE_ARRAY_COUNT(skeletons), time, settings);
+            time += FrameTime;
+
+            const auto x1 = skeletons[1].Positions[0].X;
+            const auto x2 = skeletons[0].Positions[0].X;
+            TestTrue(FString::Printf(TEXT("%s filter keeps body 1 after ")
+                TEXT("reordering at %f"), name, x1), (x1 > 0.0f)
+                && (x1 < 10.0f));
+            TestTrue(FString::Printf(TEXT("%s filter keeps body 2 after ")
+                TEXT("reordering at %f"), name, x2), (x2 > 100.0f)
+                && (x2 < 110.0f));
+        }
+
+        // A new body starts from its first observation.
+        {
+            FAzureKinectSkeletonData skeletons[] = {
+                MakeSkeleton(2, 110.0f),
+                MakeSkeleton(3, -100.0f),
+                MakeSkeleton(1, 10.0f)
+            };
+            f.Apply(skeletons, UE_ARRAY_COUNT(skeletons), time, settings);
+            time += FrameTime;
+
+            TestEqual(FString::Printf(TEXT("%s filter starts a new body from ")
+                TEXT("its observation"), name),
+                skeletons[1].Positions[0].X, -100.0f);
+            TestTrue(FString::Printf(TEXT("%s filter keeps body 1 after a ")
+                TEXT("body appeared"), name),
+                FMath::Abs(skeletons[2].Positions[0].X - 10.0f) < 5.0f);
+        }
+
+        // A body that disappears is forgotten, so it starts over when the
+        // tracker reports its ID again.
+        {
+            FAzureKinectSkeletonData skeletons[] = {
+                MakeSkeleton(3, -100.0f),
+                MakeSkeleton(1, 10.0f)
+            };
+            f.Apply(skeletons, UE_ARRAY_COUNT(skeletons), time, settings);
+            time += FrameTime;
+
+            TestEqual(FString::Printf(TEXT("%s filter keeps body 3 after a ")
+                TEXT("body disappeared"), name),
+                skeletons[0].Positions[0].X, -100.0f);
+        }
+
+        {
+            FAzureKinectSkeletonData skeletons[] = {
+                MakeSkeleton(1, 10.0f),
+                MakeSkeleton(2, 200.0f)
+            };
+            f.Apply(skeletons, UE_ARRAY_COUNT(skeletons), time, settings);
+            time += FrameTime;
+
+            TestEqual(FString::Printf(TEXT("%s filter restarts a body that ")
+                TEXT("reappeared"), name),
+                skeletons[1].Positions[0].X, 200.0f);
+        }
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectSkeletonFilterTimeTest,
+    "AzureKinect.SkeletonFilter.Time",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectSkeletonFilterTimeTest::RunTest
+ */
+bool FAzureKinectSkeletonFilterTimeTest::RunTest(const FString& parameters) {
+    for (const auto filter : { EKinectSkeletonFilter::ONE_EURO,
+            EKinectSkeletonFilter::KALMAN }) {
+        const auto name = GetName(filter);
+        const auto settings = MakeSettings(filter);
+        FAzureKinectSkeletonFilter f;
+        auto time = 1.0;
+
+        auto apply = [&f, &settings](const float x, const double t) {
+            auto skeleton = MakeSkeleton(1, x);
+            f.Apply(&skeleton, 1, t, settings);
+            return skeleton.Positions[0].X;
+        };
+
+        for (int32 i = 0; i < SettlingFrames; ++i, time += FrameTime) {
+            apply(0.0f, time);
+        }
+
+        // A jump in the next frame is smoothed.
+        TestTrue(FString::Printf(TEXT("%s filter smoothes a jump"), name),
+            apply(50.0f, time) < 50.0f);
+
+        // The same time again restarts the filter from the observation, as
+        // does a time in the past.
+        TestEqual(FString::Printf(TEXT("%s filter restarts on a repeated ")
+            TEXT("time"), name), apply(-50.0f, time), -50.0f);
+        TestEqual(FString::Printf(TEXT("%s filter restarts on a time in the ")
+            TEXT("past"), name), apply(50.0f, time - 1.0), 50.0f);
+        TestEqual(FString::Printf(TEXT("%s filter continues from the ")
+            TEXT("restart"), name), apply(50.0f, time), 50.0f);
+    }
+
+    return true;
+}
+
+#endif /* WITH_DEV_AUTOMATION_TESTS */
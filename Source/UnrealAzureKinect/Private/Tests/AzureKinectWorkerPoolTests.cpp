@@ -0,0 +1,165 @@
+﻿// <copyright file="AzureKinectWorkerPoolTests.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#include "AzureKinectConversion.h"
+#include "AzureKinectWorkerPool.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+    /// <summary>
+    /// The numbers of dedicated threads the pool is tested with, where zero
+    /// selects the task graph.
+    /// </summary>
+    constexpr int32 ThreadCounts[] = { 0, 1, 3 };
+
+    /*
+     * ::CountVisits
+     */
+    int32 CountVisits(FAzureKinectWorkerPool& pool,
+            const int32 cnt,
+            const int32 grain) {
+        TArray<int32> visits;
+        visits.SetNumZeroed(cnt);
+
+        std::atomic<int32> badTiles(0);
+        pool.ParallelForTiles(cnt, grain,
+                [&visits, &badTiles, cnt, grain](const int32 b, const int32 e) {
+            if ((b < 0) || (e > cnt) || (b >= e)
+                    || ((grain > 0) && (e - b > grain))) {
+                ++badTiles;
+                return;
+            }
+
+            for (int32 i = b; i < e; ++i) {
+                FPlatformAtomics::InterlockedIncrement(&visits[i]);
+            }
+        });
+
+        // Each index must be visited exactly once.
+        int32 retval = badTiles.load();
+        for (const auto v : visits) {
+            retval += (v != 1) ? 1 : 0;
+        }
+
+        return retval;
+    }
+
+} /* namespace */
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectTilesTest,
+    "AzureKinect.WorkerPool.Tiles",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectTilesTest::RunTest
+ */
+bool FAzureKinectTilesTest::RunTest(const FString& parameters) {
+    constexpr int32 counts[] = { 0, 1, 63, 64, 65, 288, 576 };
+    constexpr int32 grains[] = { 0, 1, 16, 64, 100, 1000 };
+
+    for (const auto threads : ThreadCounts) {
+        FAzureKinectWorkerPool pool;
+        pool.Start(threads, 0);
+
+        for (const auto cnt : counts) {
+            for (const auto grain : grains) {
+                TestEqual(FString::Printf(TEXT("%d rows in tiles of %d on ")
+                    TEXT("%d threads are processed exactly once"),
+                    cnt, grain, threads),
+                    CountVisits(pool, cnt, grain), 0);
+            }
+        }
+
+        // The conversion stage runs the streams in parallel, each of which
+        // tiles its rows on the same pool, so the calls must nest.
+        {
+            std::atomic<int32> errors(0);
+            pool.ParallelFor(5, [&pool, &errors](const int32) {
+                errors += CountVisits(pool, 576, 64);
+            });
+            TestEqual(FString::Printf(TEXT("Nested tiles on %d threads are ")
+                TEXT("processed exactly once"), threads), errors.load(), 0);
+        }
+
+        pool.Shutdown();
+    }
+
+    return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAzureKinectTiledConversionTest,
+    "AzureKinect.WorkerPool.TiledConversion",
+    EAutomationTestFlags_ApplicationContextMask
+    | EAutomationTestFlags::ProductFilter)
+
+
+/*
+ * FAzureKinectTiledConversionTest::RunTest
+ */
+bool FAzureKinectTiledConversionTest::RunTest(const FString& parameters) {
+    const int32 width = 640;
+    const int32 height = 576;
+    const int32 grains[] = { 1, 7, 64, height };
+
+    TArray<uint16> src;
+    src.SetNumUninitialized(width * height);
+    {
+        FRandomStream rng(11);
+        for (auto& s : src) {
+            s = static_cast<uint16>(rng.RandRange(0, 0xFFFF));
+        }
+    }
+
+    TArray<uint8> expected;
+    expected.SetNumUninitialized(4 * src.Num());
+    FAzureKinectConversion::Expand16(expected.GetData(), src.GetData(),
+        src.Num());
+
+    for (const auto threads : ThreadCounts) {
+        FAzureKinectWorkerPool pool;
+        pool.Start(threads, 0);
+
+        for (const auto grain : grains) {
+            TArray<uint8> actual;
+            actual.SetNumZeroed(expected.Num());
+            const auto dst = actual.GetData();
+            const auto s = src.GetData();
+
+            pool.ParallelForTiles(height, grain,
+                    [dst, s, width](const int32 b, const int32 e) {
+                FAzureKinectConversion::Expand16(dst + 4 * b * width,
+                    s + b * width,
+                    (e - b) * width);
+            });
+
+            TestTrue(FString::Printf(TEXT("Tiles of %d rows on %d threads ")
+                TEXT("match the conversion of the whole image"),
+                grain, threads),
+                FMemory::Memcmp(actual.GetData(), expected.GetData(),
+                    expected.Num()) == 0);
+        }
+
+        pool.Shutdown();
+    }
+
+    return true;
+}
+
+#endif /* WITH_DEV_AUTOMATION_TESTS */
@@ -51,6 +51,15 @@ public:
     UPROPERTY(EditAnywhere, Category="Bone Mapping")
     TMap<EKinectBodyJoint, FBoneReference> BonesToModify;
 
+    /// <summary>
+    /// If enabled, joints with the confidence <c>NONE</c>, i.e. joints that
+    /// are out of range or skipped by the
+    /// <see cref="UAzureKinectDevice::LowConfidencePolicy" />, leave their
+    /// bones in the input pose. Otherwise, all joints are applied.
+    /// </summary>
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Bone Mapping")
+    bool SkipUntrackedJoints;
+
     virtual void EvaluateComponentSpace_AnyThread(
         FComponentSpacePoseContext& output) override;
 
@@ -0,0 +1,109 @@
+﻿// <copyright file="AzureKinectBufferPool.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Templates/SharedPointer.h"
+
+#include "k4a/k4a.hpp"
+
+#include "AzureKinectStatistics.h"
+
+
+/// <summary>
+/// A pool of equally sized buffers that are handed out as
+/// <see cref="k4a::image" />s and return to the pool once the last reference
+/// to the image has been released.
+/// </summary>
+/// <remarks>
+/// Images obtained from the pool keep the pool alive, so they can safely be
+/// passed to the render thread even if the owner of the pool goes away in the
+/// meantime. The pool must therefore always be allocated as a shared object.
+/// </remarks>
+class FAzureKinectBufferPool final
+        : public TSharedFromThis<FAzureKinectBufferPool, ESPMode::ThreadSafe> {
+
+public:
+
+    /// <summary>
+    /// Initialises a new, empty instance.
+    /// </summary>
+    FAzureKinectBufferPool(void);
+
+    FAzureKinectBufferPool(const FAzureKinectBufferPool&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~FAzureKinectBufferPool(void);
+
+    /// <summary>
+    /// Obtains an image with a pooled buffer.
+    /// </summary>
+    /// <remarks>
+    /// If the image does not fit into the pooled buffers or if no buffer is
+    /// available, a new buffer is allocated, which is counted as a miss.
+    /// </remarks>
+    /// <param name="format">The format of the image.</param>
+    /// <param name="width">The width of the image in pixels.</param>
+    /// <param name="height">The height of the image in pixels.</param>
+    /// <param name="stride">The size of a row in bytes.</param>
+    /// <returns>An image with uninitialised content.</returns>
+    /// <exception cref="k4a::error">If the image could not be
+    /// created.</exception>
+    k4a::image Acquire(const k4a_image_format_t format,
+        const int32 width,
+        const int32 height,
+        const int32 stride);
+
+    /// <summary>
+    /// Retrieves the counters of the pool.
+    /// </summary>
+    /// <param name="statistics">Receives the counters.</param>
+    void GetStatistics(FAzureKinectBufferPoolStatistics& statistics) const;
+
+    /// <summary>
+    /// Releases all pooled buffers, resets the counters and allocates
+    /// <paramref name="count" /> new buffers of <paramref name="size" />
+    /// bytes.
+    /// </summary>
+    /// <remarks>
+    /// Buffers that are still in use are released once they return if their
+    /// size does not match the new one.
+    /// </remarks>
+    /// <param name="size">The size of a buffer in bytes.</param>
+    /// <param name="count">The number of buffers to allocate upfront.</param>
+    void Reset(const int32 size, const int32 count);
+
+    FAzureKinectBufferPool& operator =(const FAzureKinectBufferPool&) = delete;
+
+private:
+
+    /// <summary>
+    /// A buffer that is either pooled or in use.
+    /// </summary>
+    struct FBuffer {
+        uint8 *Data;
+        TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> Owner;
+        int32 Size;
+    };
+
+    static FBuffer *Allocate(const int32 size);
+
+    static void Free(FBuffer *buffer);
+
+    static void OnRelease(void *data, void *context);
+
+    void Return(FBuffer *buffer);
+
+    TArray<FBuffer *> _available;
+    int64 _hits;
+    mutable FCriticalSection _lock;
+    int64 _misses;
+    int32 _size;
+};
@@ -0,0 +1,170 @@
+﻿// <copyright file="AzureKinectColourDecoder.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/SharedPointer.h"
+
+#include "k4a/k4a.hpp"
+
+#include "AzureKinectBufferPool.h"
+#include "AzureKinectQueue.h"
+#include "AzureKinectStatistics.h"
+#include "AzureKinectTextureUpload.h"
+
+
+/// <summary>
+/// Converts colour images delivered in one of the compressed or subsampled
+/// formats of the sensor into BGRA32.
+/// </summary>
+/// <remarks>
+/// <para>The static <see cref="Decode" /> methods work on plain buffers and
+/// can be used on synthetic frames without a device.</para>
+/// <para>Decoding MJPG is expensive, so the decoder can run a number of
+/// threads, each of which decodes a whole frame. The decoded frames are
+/// submitted directly to the uploader. Frames that finish after a newer one
+/// has already been submitted are discarded.</para>
+/// </remarks>
+class FAzureKinectColourDecoder final : public FRunnable {
+
+public:
+
+    /// <summary>
+    /// Converts an image into BGRA32.
+    /// </summary>
+    /// <param name="dst">The output buffer, which must be able to hold
+    /// <paramref name="height" /> rows of <paramref name="pitch" />
+    /// bytes.</param>
+    /// <param name="pitch">The size of an output row in bytes.</param>
+    /// <param name="format">The format of <paramref name="src" />.</param>
+    /// <param name="src">The image to be converted.</param>
+    /// <param name="size">The size of <paramref name="src" /> in
+    /// bytes.</param>
+    /// <param name="width">The width of the image in pixels.</param>
+    /// <param name="height">The height of the image in pixels.</param>
+    /// <param name="stride">The size of an input row in bytes. For NV12,
+    /// this is the stride of both planes.</param>
+    /// <returns><see langword="true" /> on success, <see langword="false" />
+    /// if the input is malformed or the format is not supported.</returns>
+    static bool Decode(uint8 *dst,
+        const int32 pitch,
+        const k4a_image_format_t format,
+        const uint8 *src,
+        const size_t size,
+        const int32 width,
+        const int32 height,
+        const int32 stride);
+
+    /// <summary>
+    /// Converts an image into a BGRA32 image obtained from
+    /// <paramref name="pool" />.
+    /// </summary>
+    /// <param name="image">The image to be converted.</param>
+    /// <param name="pool">The pool providing the output buffer.</param>
+    /// <returns>The converted image, which is empty if the conversion
+    /// failed.</returns>
+    /// <exception cref="k4a::error">If the output image could not be
+    /// allocated.</exception>
+    static k4a::image Decode(const k4a::image& image,
+        FAzureKinectBufferPool& pool);
+
+    /// <summary>
+    /// Initialises a new instance without any threads.
+    /// </summary>
+    FAzureKinectColourDecoder(void);
+
+    FAzureKinectColourDecoder(const FAzureKinectColourDecoder&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    virtual ~FAzureKinectColourDecoder(void);
+
+    /// <summary>
+    /// Retrieves the counters of the decoder.
+    /// </summary>
+    /// <param name="statistics">Receives the counters.</param>
+    void GetStatistics(FAzureKinectStageStatistics& statistics) const;
+
+    /// <summary>
+    /// Answer the number of decoder threads.
+    /// </summary>
+    inline int32 GetThreadCount(void) const noexcept {
+        return this->_threads.Num();
+    }
+
+    virtual uint32 Run(void) override;
+
+    /// <summary>
+    /// Stops and joins all threads of the decoder.
+    /// </summary>
+    void Shutdown(void);
+
+    /// <summary>
+    /// (Re-) Starts the decoder with the given number of threads.
+    /// </summary>
+    /// <remarks>
+    /// This method must be called on the game thread before any MJPG image
+    /// is decoded, because it loads the JPEG codec.
+    /// </remarks>
+    /// <param name="threads">The number of decoder threads, which can be
+    /// zero if the images are only decoded synchronously.</param>
+    /// <param name="pool">The pool providing the buffers of the decoded
+    /// images.</param>
+    /// <param name="uploader">The uploader receiving the decoded
+    /// images.</param>
+    void Start(const int32 threads,
+        const TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe>& pool,
+        const TSharedPtr<FAzureKinectTextureUploader, ESPMode::ThreadSafe>& uploader);
+
+    virtual void Stop(void) override;
+
+    /// <summary>
+    /// Queues an image for being decoded into <paramref name="target" />.
+    /// </summary>
+    /// <remarks>
+    /// If all threads are busy and the queue is full, the oldest image is
+    /// discarded.
+    /// </remarks>
+    /// <param name="image">The image to be decoded.</param>
+    /// <param name="target">The render target to be updated.</param>
+    /// <param name="frameInfo">The frame the image belongs to.</param>
+    void Submit(k4a::image&& image,
+        UTextureRenderTarget2D *target,
+        const FAzureKinectFrameInfo& frameInfo);
+
+    FAzureKinectColourDecoder& operator =(
+        const FAzureKinectColourDecoder&) = delete;
+
+private:
+
+    /// <summary>
+    /// An image waiting to be decoded.
+    /// </summary>
+    struct FJob {
+        FAzureKinectFrameInfo FrameInfo;
+        k4a::image Image;
+        uint64 Sequence = 0;
+        UTextureRenderTarget2D *Target = nullptr;
+    };
+
+    FThreadSafeCounter64 _cntDecoded;
+    FThreadSafeCounter64 _cntDiscarded;
+    uint64 _latest;
+    FCriticalSection _lock;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _pool;
+    TAzureKinectQueue<FJob> _queue;
+    uint64 _sequence;
+    FThreadSafeCounter _stopCounter;
+    TArray<FRunnableThread *> _threads;
+    TSharedPtr<FAzureKinectTextureUploader, ESPMode::ThreadSafe> _uploader;
+};
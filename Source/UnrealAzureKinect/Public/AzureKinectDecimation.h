@@ -0,0 +1,107 @@
+﻿// <copyright file="AzureKinectDecimation.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AzureKinectPointCloud.h"
+
+
+/// <summary>
+/// Reduces point clouds to at most one point per cell of a voxel grid.
+/// </summary>
+/// <remarks>
+/// <para>The occupied cells are found in a hash table keyed by the cell
+/// coordinates, so the cost is linear in the number of points and does not
+/// depend on the extent of the scene. Each cell either keeps its first point
+/// or the centroid and the mean colour of all of its points.</para>
+/// <para>If a target number of points is given, the voxel size is adapted
+/// from frame to frame. A frame that still exceeds the target is decimated
+/// again with a larger voxel size, so the target is met without waiting for
+/// the next frame. If a few passes do not suffice, the remaining points are
+/// thinned out with a regular stride, so the target is always met.</para>
+/// <para>The instance holds the hash table as scratch space and must
+/// therefore not be used concurrently.</para>
+/// </remarks>
+class FAzureKinectDecimation final {
+
+public:
+
+    /// <summary>
+    /// The smallest voxel size in centimetres used for meeting a target
+    /// number of points.
+    /// </summary>
+    static constexpr float MinVoxelSize = 0.1f;
+
+    /// <summary>
+    /// Initialises a new instance.
+    /// </summary>
+    FAzureKinectDecimation(void);
+
+    FAzureKinectDecimation(const FAzureKinectDecimation&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~FAzureKinectDecimation(void) = default;
+
+    /// <summary>
+    /// Decimates the given point cloud in place.
+    /// </summary>
+    /// <param name="cloud">The point cloud to be decimated. If it has
+    /// colours, there must be one per point.</param>
+    /// <param name="voxelSize">The edge length of the voxels in centimetres.
+    /// If <paramref name="targetPoints" /> is positive, this is the lower
+    /// bound of the adapted voxel size. If both are not positive, the point
+    /// cloud is not changed.</param>
+    /// <param name="targetPoints">The maximum number of points to be
+    /// retained, or zero for using a fixed voxel size.</param>
+    /// <param name="average">If <c>true</c>, each voxel yields the centroid
+    /// and the mean colour of its points. Otherwise, its first point is
+    /// retained.</param>
+    /// <returns>The number of points retained.</returns>
+    int32 Decimate(FAzureKinectPointCloud& cloud,
+        const float voxelSize,
+        const int32 targetPoints,
+        const bool average);
+
+    /// <summary>
+    /// Answer the voxel size used for the last point cloud, which is zero if
+    /// no point cloud has been decimated.
+    /// </summary>
+    inline float GetVoxelSize(void) const noexcept {
+        return this->_voxelSize;
+    }
+
+    /// <summary>
+    /// Forgets the adapted voxel size and releases the hash table.
+    /// </summary>
+    void Reset(void);
+
+    FAzureKinectDecimation& operator =(
+        const FAzureKinectDecimation&) = delete;
+
+private:
+
+    /// <summary>
+    /// The maximum number of passes for meeting a target number of points.
+    /// </summary>
+    static constexpr int32 MaxPasses = 4;
+
+    int32 Grid(FVector3f *positions,
+        FColor *colours,
+        const int32 cnt,
+        const float voxelSize,
+        const bool average);
+
+    TArray<uint32> _colourSums;
+    TArray<uint32> _counts;
+    TArray<uint64> _keys;
+    TArray<int32> _slots;
+    TArray<FVector3f> _sums;
+    float _voxelSize;
+};
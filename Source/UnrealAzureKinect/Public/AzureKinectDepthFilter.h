@@ -0,0 +1,152 @@
+﻿// <copyright file="AzureKinectDepthFilter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AzureKinectWorkerPool.h"
+
+#include "AzureKinectDepthFilter.generated.h"
+
+
+/// <summary>
+/// Configures the filtering of depth images before they are converted.
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAzureKinectDepthFilterSettings {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The maximum difference between neighbouring samples that are
+    /// considered to lie on the same surface, relative to their depth.
+    /// </summary>
+    /// <remarks>
+    /// This threshold guards the spatial smoothing and the hole filling
+    /// against blurring edges. Samples without any similar neighbour are
+    /// flying pixels, which are removed by the spatial smoothing.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter",
+        meta = (ClampMin = 0, ClampMax = 0.125))
+    float EdgeThreshold = 0.02f;
+
+    /// <summary>
+    /// Enables the filtering.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter")
+    bool Enabled = false;
+
+    /// <summary>
+    /// Fills invalid samples with the mean of at least two valid neighbours
+    /// that do not span an edge.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter")
+    bool FillHoles = true;
+
+    /// <summary>
+    /// The absolute part of the edge and the motion thresholds in
+    /// millimetres, which accounts for the noise of near samples.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter",
+        meta = (ClampMin = 0, ClampMax = 8192))
+    int32 MinThreshold = 10;
+
+    /// <summary>
+    /// The maximum change of a sample between frames that is considered
+    /// noise rather than motion, relative to its depth.
+    /// </summary>
+    /// <remarks>
+    /// Samples changing by more than this threshold reset their history, so
+    /// moving objects do not leave trails.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter",
+        meta = (ClampMin = 0, ClampMax = 0.125))
+    float MotionThreshold = 0.05f;
+
+    /// <summary>
+    /// Enables the edge-preserving smoothing of each sample with its four
+    /// direct neighbours.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter")
+    bool SpatialSmoothing = true;
+
+    /// <summary>
+    /// The weight of the history in the exponential smoothing of each sample
+    /// over time, or zero for disabling the temporal smoothing.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter",
+        meta = (ClampMin = 0, ClampMax = 0.99))
+    float TemporalSmoothing = 0.6f;
+};
+
+
+/// <summary>
+/// Smoothes depth images over time and space and fills small holes.
+/// </summary>
+/// <remarks>
+/// <para>The temporal stage blends each sample into an exponentially
+/// smoothed history unless it changed by more than the motion threshold.
+/// The spatial stage then smoothes the history with the four direct
+/// neighbours of each sample while preserving edges and fills holes of a
+/// single sample. Both stages work on rows, which are processed in parallel
+/// by the vectorised kernels of <see cref="FAzureKinectConversion" />.
+/// </para>
+/// <para>The instance holds the history and must therefore not be used
+/// concurrently.</para>
+/// </remarks>
+class FAzureKinectDepthFilter final {
+
+public:
+
+    /// <summary>
+    /// Initialises a new instance.
+    /// </summary>
+    FAzureKinectDepthFilter(void);
+
+    FAzureKinectDepthFilter(const FAzureKinectDepthFilter&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~FAzureKinectDepthFilter(void) = default;
+
+    /// <summary>
+    /// Filters the given depth image.
+    /// </summary>
+    /// <remarks>
+    /// If the size of the image changes, the history is restarted.
+    /// </remarks>
+    /// <param name="dst">The output image, which must not alias
+    /// <paramref name="src" />.</param>
+    /// <param name="src">The depth image to be filtered.</param>
+    /// <param name="width">The width of the images in pixels.</param>
+    /// <param name="height">The height of the images in pixels.</param>
+    /// <param name="settings">The configuration of the filter.</param>
+    /// <param name="workers">The pool processing the rows in
+    /// parallel.</param>
+    /// <param name="tileRows">The number of rows processed as one
+    /// task.</param>
+    void Apply(uint16 *dst,
+        const uint16 *src,
+        const int32 width,
+        const int32 height,
+        const FAzureKinectDepthFilterSettings& settings,
+        FAzureKinectWorkerPool& workers,
+        const int32 tileRows);
+
+    /// <summary>
+    /// Discards the history.
+    /// </summary>
+    void Reset(void);
+
+    FAzureKinectDepthFilter& operator =(
+        const FAzureKinectDepthFilter&) = delete;
+
+private:
+
+    TArray<uint16> _history;
+    TArray<uint16> _zeros;
+};
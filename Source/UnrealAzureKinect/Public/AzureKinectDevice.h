@@ -35,8 +35,22 @@
 #include "k4a/k4a.hpp"
 
 #include "k4abt.hpp"
+#include "AzureKinectBufferPool.h"
+#include "AzureKinectColourDecoder.h"
+#include "AzureKinectDecimation.h"
+#include "AzureKinectDepthFilter.h"
 #include "AzureKinectEnum.h"
+#include "AzureKinectFrameInfo.h"
+#include "AzureKinectGpuBuffers.h"
+#include "AzureKinectPointCloud.h"
+#include "AzureKinectQueue.h"
+#include "AzureKinectRegistration.h"
 #include "AzureKinectSkeleton.h"
+#include "AzureKinectSkeletonFilter.h"
+#include "AzureKinectSnapshotBuffer.h"
+#include "AzureKinectStatistics.h"
+#include "AzureKinectTextureUpload.h"
+#include "AzureKinectWorkerPool.h"
 
 #include "AzureKinectDevice.generated.h"
 
@@ -60,16 +74,11 @@ public:
     /// <summary>
     /// Counts the number of connected Kinects.
     /// </summary>
-    /// <returns></returns>
+    /// <returns>The number of Azure Kinect devices connected to the host.
+    /// </returns>
     UFUNCTION(BlueprintCallable, Category = "Device")
     static int32 CountDevices();
 
-    /// <summary>
-    /// Specifies the acceptable default colour image format.
-    /// </summary>
-    static constexpr k4a_image_format_t ColourFormat
-        = k4a_image_format_t::K4A_IMAGE_FORMAT_COLOR_BGRA32;
-
     /// <summary>
     /// Initialises a new instance.
     /// </summary>
@@ -81,15 +90,87 @@ public:
     /// <param name="initialiser"></param>
     UAzureKinectDevice(const FObjectInitializer& initialiser);
 
+    /// <summary>
+    /// Determines how the body index map is written to
+    /// <see cref="BodyIndexTexture" />.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "I/O")
+    EKinectBodyIndexMode BodyIndexMode;
+
+    /// <summary>
+    /// The colours of the bodies if <see cref="BodyIndexMode" /> is
+    /// <see cref="EKinectBodyIndexMode::PALETTE" />. A body with ID n is
+    /// assigned the colour n modulo the number of colours.
+    /// </summary>
+    /// <remarks>
+    /// The body index map is converted on worker threads, which use a copy
+    /// of the palette. C++ code changing the palette while the device is
+    /// running must therefore use <see cref="SetBodyIndexPalette" />.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, BlueprintSetter = SetBodyIndexPalette, EditAnywhere, Category = "I/O")
+    TArray<FColor> BodyIndexPalette;
+
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "I/O")
     UTextureRenderTarget2D *BodyIndexTexture;
 
+    /// <summary>
+    /// The number of threads decoding MJPG colour images in parallel, or zero
+    /// for decoding them in the conversion stage.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline", meta = (ClampMin = 0))
+    int32 ColourDecoderThreads;
+
+    /// <summary>
+    /// The format the colour camera delivers its images in.
+    /// </summary>
+    /// <remarks>
+    /// BGRA32 makes the SDK decode MJPG on a single thread. The other formats
+    /// are converted to BGRA32 by the plugin, which reduces the load on the
+    /// SDK and, in case of MJPG, the USB bandwidth. NV12 and YUY2 are only
+    /// available at 720p.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
+    EKinectColourFormat ColourFormat;
+
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
     EKinectColourResolution ColourResolution;
 
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "I/O")
     UTextureRenderTarget2D *ColourTexture;
 
+    /// <summary>
+    /// The number of captures that can wait for the conversion into textures
+    /// before the oldest one is discarded.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline", meta = (ClampMin = 1))
+    int32 ConversionQueueDepth;
+
+    /// <summary>
+    /// The number of rows of an image that are converted as one tile.
+    /// </summary>
+    /// <remarks>
+    /// The tiles of an image are converted in parallel. Smaller tiles reduce
+    /// the latency of the conversion, larger ones reduce the number of cores
+    /// used. Zero disables the tiling.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline", meta = (ClampMin = 0))
+    int32 ConversionTileRows;
+
+    /// <summary>
+    /// Configures the filtering of the depth images, which applies to the
+    /// depth, the sensor and the point cloud outputs.
+    /// </summary>
+    /// <remarks>
+    /// The body tracker always receives the unfiltered depth images. For the
+    /// same reason, the sensor texture is not filtered if the body index map
+    /// is packed into it, which must match the depth the tracker saw.
+    /// Changes of the settings take effect with the next capture. If the
+    /// filter is enabled while the device is running, its buffers are
+    /// allocated on demand.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Depth filter")
+    FAzureKinectDepthFilterSettings DepthFilter;
+
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
     EKinectDepthMode DepthMode;
 
@@ -107,21 +188,280 @@ public:
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
     EKinectFps FrameRate;
 
+    /// <summary>
+    /// If enabled, a point cloud is generated from every depth image, which
+    /// can be obtained from <see cref="GetPointCloud" />.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Point cloud")
+    bool GeneratePointCloud;
+
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "I/O")
     UTextureRenderTarget2D *InfraredTexture;
 
+    /// <summary>
+    /// The confidence a joint must at least have for being published as it
+    /// was tracked. Joints below the threshold are handled according to the
+    /// <see cref="LowConfidencePolicy" />.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeletons")
+    EKinectJointConfidence JointConfidenceThreshold;
+
+    /// <summary>
+    /// Determines how joints below the
+    /// <see cref="JointConfidenceThreshold" /> are published.
+    /// </summary>
+    /// <remarks>
+    /// The policy is applied by the tracker stage before the skeletons are
+    /// published, so it does not cost anything on the game or the animation
+    /// thread. The confidences reported are always the ones of the tracker,
+    /// except for skipped joints, which are reported as <c>NONE</c>.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeletons")
+    EKinectJointPolicy LowConfidencePolicy;
+
+    /// <summary>
+    /// The time in milliseconds <see cref="GetSkeletonsAt" /> may predict
+    /// the skeletons beyond the most recent frame of the tracker.
+    /// </summary>
+    /// <remarks>
+    /// Requests for later times return the skeletons at the limit. As the
+    /// extrapolation assumes constant velocity, large values make fast
+    /// motion overshoot.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeletons", meta = (ClampMin = 0))
+    float MaxExtrapolation;
+
+    /// <summary>
+    /// The number of render commands that may hold an upload of a single
+    /// texture.
+    /// </summary>
+    /// <remarks>
+    /// If the render thread cannot keep up, only the uploads of the latest
+    /// capture beyond this limit are retained and older ones are counted as
+    /// dropped. The textures of a capture are always updated together.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline", meta = (ClampMin = 1))
+    int32 MaxInFlightUploads;
+
+    /// <summary>
+    /// If enabled, each voxel of the decimated point cloud yields the
+    /// centroid and the mean colour of its points instead of its first point.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Point cloud")
+    bool PointCloudAveraging;
+
+    /// <summary>
+    /// If enabled and the colour camera is running, the points of the point
+    /// cloud are coloured with the pixel of the colour image they project
+    /// to.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Point cloud")
+    bool PointCloudColours;
+
+    /// <summary>
+    /// The maximum number of points in the point cloud, or zero for no limit.
+    /// </summary>
+    /// <remarks>
+    /// The point cloud is decimated on a voxel grid whose size is adapted
+    /// from frame to frame such that the limit is met.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Point cloud", meta = (ClampMin = 0))
+    int32 PointCloudMaxPoints;
+
+    /// <summary>
+    /// The edge length in centimetres of the voxels the point cloud is
+    /// decimated on, or zero for no decimation.
+    /// </summary>
+    /// <remarks>
+    /// If <see cref="PointCloudMaxPoints" /> is set, this is the smallest
+    /// voxel size used for meeting the limit.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Point cloud", meta = (ClampMin = 0))
+    float PointCloudVoxelSize;
+
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
     EKinectRemap Remapping;
 
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
     EKinectSensorOrientation SensorOrientation;
 
+    /// <summary>
+    /// An optional RGBA16 unsigned integer texture in depth space, which
+    /// holds the depth in red, the infrared sample in green and the body
+    /// index in blue.
+    /// </summary>
+    /// <remarks>
+    /// If body tracking is enabled, the texture is updated once the body
+    /// tracker has finished the capture. Otherwise, blue is always 255, i.e.
+    /// background. The texture is not affected by
+    /// <see cref="Remapping" />.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "I/O")
+    UTextureRenderTarget2D *SensorTexture;
+
+    /// <summary>
+    /// Determines the format of <see cref="DepthTexture" /> and
+    /// <see cref="InfraredTexture" />.
+    /// </summary>
+    /// <remarks>
+    /// The single-channel formats upload the samples as they are delivered by
+    /// the sensor, which halves the bandwidth compared to the expanded RGBA8
+    /// format and requires no conversion on the CPU.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "I/O")
+    EKinectSensorTextureFormat SensorTextureFormat;
+
+    /// <summary>
+    /// Configures the smoothing of the joints over time, which is applied
+    /// by the tracker stage after the <see cref="LowConfidencePolicy" />.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeletons")
+    FAzureKinectSkeletonFilterSettings SkeletonFilter;
+
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
     EKinectTrackerProcessing SkeletonTracking;
 
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Device settings")
     bool SynchronisedImagesOnly;
 
+    /// <summary>
+    /// If enabled and body tracking is active, the colour, depth and infrared
+    /// textures are updated from the capture of the body tracking result
+    /// rather than as soon as the capture is available.
+    /// </summary>
+    /// <remarks>
+    /// This guarantees that all textures, including
+    /// <see cref="BodyIndexTexture" />, show the same capture at the expense
+    /// of the latency of the body tracker.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline")
+    bool SynchronisedTextures;
+
+    /// <summary>
+    /// Determines what happens if a capture arrives while the tracking queue
+    /// is full, which is the case if the body tracker cannot keep up with the
+    /// frame rate of the camera.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline")
+    EKinectQueuePolicy TrackerQueuePolicy;
+
+    /// <summary>
+    /// The number of captures that can wait for the body tracker before
+    /// <see cref="TrackerQueuePolicy" /> is applied.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline", meta = (ClampMin = 1))
+    int32 TrackingQueueDepth;
+
+    /// <summary>
+    /// The mask of the cores the threads processing the streams of a capture
+    /// may run on, or zero for no restriction.
+    /// </summary>
+    /// <remarks>
+    /// The mask is only applied to dedicated threads, i.e. if
+    /// <see cref="WorkerThreads" /> is not zero.
+    /// </remarks>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline")
+    int64 WorkerAffinityMask;
+
+    /// <summary>
+    /// The number of dedicated threads processing the streams of a capture
+    /// in parallel, or zero for using the task graph of the engine.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Pipeline", meta = (ClampMin = 0))
+    int32 WorkerThreads;
+
+    /// <summary>
+    /// Answer the counters of the pool of upload buffers for the given
+    /// stream.
+    /// </summary>
+    /// <param name="stream">The stream to retrieve the counters for.</param>
+    /// <returns>The counters of the buffer pool of the stream.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Pipeline")
+    FAzureKinectBufferPoolStatistics GetBufferPoolStatistics(
+        const EKinectStream stream) const;
+
+    /// <summary>
+    /// Answer the current time on the clock of <see cref="GetSkeletonsAt" />
+    /// in seconds.
+    /// </summary>
+    /// <remarks>
+    /// This is the clock of <c>FPlatformTime::Seconds</c>, which the engine
+    /// derives its frame times from.
+    /// </remarks>
+    /// <returns>The current time in seconds.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Skeletons")
+    static double GetHostTime();
+
+    /// <summary>
+    /// Answer the GPU buffers holding the most recent point cloud and
+    /// skeletons, which are shared by all users of the device.
+    /// </summary>
+    /// <remarks>
+    /// The buffers are not updated by the device itself, but by the render
+    /// thread of their users from the snapshots of the device.
+    /// </remarks>
+    inline TSharedPtr<FAzureKinectGpuBuffers, ESPMode::ThreadSafe>
+    GetGpuBuffers(void) const noexcept {
+        return this->_gpuBuffers;
+    }
+
+    /// <summary>
+    /// Copies the most recent point cloud.
+    /// </summary>
+    /// <param name="positions">Receives the positions of the points in
+    /// centimetres.</param>
+    /// <param name="colours">Receives the colours of the points, or nothing
+    /// if <see cref="PointCloudColours" /> is disabled.</param>
+    /// <returns>The number of points.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Point cloud")
+    int32 GetPointCloud(TArray<FVector>& positions,
+        TArray<FColor>& colours) const;
+
+    /// <summary>
+    /// Answer the frame of the device the most recent point cloud has been
+    /// generated from.
+    /// </summary>
+    /// <returns>The frame of the point cloud, which is default-initialised
+    /// if none has been generated yet.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Point cloud")
+    FAzureKinectFrameInfo GetPointCloudFrameInfo() const;
+
+    /// <summary>
+    /// Returns the most recent point cloud without copying it.
+    /// </summary>
+    /// <remarks>
+    /// This method does not lock and can be called from any thread. Callers
+    /// should release the snapshot quickly as the device otherwise needs to
+    /// allocate new point clouds.
+    /// </remarks>
+    /// <returns>The current point cloud, which might be
+    /// <see langword="nullptr"/> if none has been generated yet.</returns>
+    TAzureKinectSnapshotBuffer<FAzureKinectPointCloud>::SnapshotType
+    GetPointCloudSnapshot(void) const;
+
+    /// <summary>
+    /// Answer the cost of generating the most recent point cloud.
+    /// </summary>
+    /// <returns>The statistics of the most recent point cloud.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Point cloud")
+    FAzureKinectPointCloudStatistics GetPointCloudStatistics() const;
+
+    /// <summary>
+    /// Answer the counters of the capture pipeline.
+    /// </summary>
+    /// <returns>The counters of all stages of the pipeline.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Pipeline")
+    FAzureKinectPipelineStatistics GetPipelineStatistics() const;
+
+    /// <summary>
+    /// Answer the counters of the texture uploads for the given stream.
+    /// </summary>
+    /// <param name="stream">The stream to retrieve the counters for.</param>
+    /// <returns>The counters of the uploads of the stream.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Pipeline")
+    FAzureKinectStageStatistics GetUploadStatistics(
+        const EKinectStream stream) const;
+
     /// <summary>
     /// Gets the skeleton at the give zero-based index.
     /// </summary>
@@ -131,24 +471,112 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Skeletons")
     FAzureKinectSkeleton GetSkeleton(const int32 index) const;
 
+    /// <summary>
+    /// Answer the frame of the device the most recent set of skeletons has
+    /// been tracked in.
+    /// </summary>
+    /// <returns>The frame of the skeletons, which is default-initialised if
+    /// none have been tracked yet.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Skeletons")
+    FAzureKinectFrameInfo GetSkeletonFrameInfo() const;
+
     /// <summary>
     /// Returns a snapshot of the currently tracked skeletons.
     /// </summary>
-    /// <returns></returns>
+    /// <returns>A copy of the skeletons tracked in the most recent frame.
+    /// </returns>
     UFUNCTION(BlueprintCallable, Category = "Skeletons")
     TArray<FAzureKinectSkeleton> GetSkeletons() const;
 
+    /// <summary>
+    /// Returns the currently tracked skeletons evaluated at the given time,
+    /// which hides the latency of the body tracker.
+    /// </summary>
+    /// <remarks>
+    /// Times between the two most recent frames of the tracker are
+    /// interpolated and later ones are extrapolated by at most
+    /// <see cref="MaxExtrapolation" />. Earlier times yield the older frame.
+    /// Bodies that have just been found are returned as they were tracked.
+    /// </remarks>
+    /// <param name="time">The time in seconds on the clock of
+    /// <see cref="GetHostTime" />.</param>
+    /// <returns>The skeletons predicted for <paramref name="time" />, which
+    /// is empty if no skeletons have been tracked yet.</returns>
+    UFUNCTION(BlueprintCallable, Category = "Skeletons")
+    TArray<FAzureKinectSkeleton> GetSkeletonsAt(const double time) const;
+
+    /// <summary>
+    /// Returns the most recent set of tracked skeletons without copying it.
+    /// </summary>
+    /// <remarks>
+    /// This method does not lock and can be called from any thread. The
+    /// snapshot returned remains valid and unchanged for as long as the
+    /// caller holds on to it, but callers should release it quickly as the
+    /// tracker otherwise needs to allocate new snapshots.
+    /// </remarks>
+    /// <returns>The current snapshot, which might be
+    /// <see langword="nullptr"/> if no frame has been tracked yet.</returns>
+    TAzureKinectSnapshotBuffer<FAzureKinectSkeletonSnapshot>::SnapshotType
+    GetSkeletonSnapshot(void) const;
+
+    /// <summary>
+    /// Copies the most recent set of tracked skeletons into
+    /// <paramref name="dst" />.
+    /// </summary>
+    /// <remarks>
+    /// This is the fast path of <see cref="GetSkeletons" /> for C++ callers,
+    /// which copies all skeletons with a single <c>memcpy</c> and reuses the
+    /// memory of <paramref name="dst" />.
+    /// </remarks>
+    /// <param name="dst">Receives the skeletons.</param>
+    /// <returns>The number of skeletons copied.</returns>
+    int32 CopySkeletons(TArray<FAzureKinectSkeletonData>& dst) const;
+
+    /// <summary>
+    /// Copies the currently tracked skeletons evaluated at the given time
+    /// into <paramref name="dst" />.
+    /// </summary>
+    /// <remarks>
+    /// This is the fast path of <see cref="GetSkeletonsAt" /> for C++
+    /// callers, which reuses the memory of <paramref name="dst" />.
+    /// </remarks>
+    /// <param name="dst">Receives the skeletons.</param>
+    /// <param name="time">The time in seconds on the clock of
+    /// <see cref="GetHostTime" />.</param>
+    /// <param name="frameInfo">Receives the frame the skeletons have been
+    /// evaluated from.</param>
+    /// <returns>The number of skeletons copied.</returns>
+    int32 CopySkeletonsAt(TArray<FAzureKinectSkeletonData>& dst,
+        const double time,
+        FAzureKinectFrameInfo& frameInfo) const;
+
+    /// <summary>
+    /// Answer the frame of the device the texture of the given stream has
+    /// most recently been updated from.
+    /// </summary>
+    /// <remarks>
+    /// The textures are updated on the render thread, so the frame returned
+    /// might not yet be visible to the game thread.
+    /// </remarks>
+    /// <param name="stream">The stream to retrieve the frame for.</param>
+    /// <returns>The frame the texture shows, which is default-initialised if
+    /// the texture has not been updated yet.</returns>
+    UFUNCTION(BlueprintCallable, Category = "I/O")
+    FAzureKinectFrameInfo GetTextureFrameInfo(
+        const EKinectStream stream) const;
+
     /// <summary>
     /// Answer the number of currently tracked skeletons.
     /// </summary>
-    /// <returns></returns>
+    /// <returns>The number of skeletons in the most recent frame.</returns>
     UFUNCTION(BlueprintCallable, Category = "Skeletons")
     int32 GetTrackedSkeletons() const;
 
     /// <summary>
     /// Answer whether there is any tracked skeleton
     /// </summary>
-    /// <returns></returns>
+    /// <returns><see langword="true" /> if at least one skeleton is tracked,
+    /// <see langword="false" /> otherwise.</returns>
     UFUNCTION(BlueprintCallable, Category = "Skeletons")
     inline bool HasTrackedSkeletons() const {
         return (this->GetTrackedSkeletons() > 0);
@@ -168,6 +596,14 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Device")
     int32 RefreshDevices();
 
+    /// <summary>
+    /// Sets <see cref="BodyIndexPalette" /> and makes the new colours
+    /// available to the conversion of the body index map.
+    /// </summary>
+    /// <param name="palette">The new colours of the bodies.</param>
+    UFUNCTION(BlueprintSetter)
+    void SetBodyIndexPalette(const TArray<FColor>& palette);
+
     /// <summary>
     /// Opens the selected device and starts the camera.
     /// </summary>
@@ -179,14 +615,47 @@ public:
     /// <summary>
     /// Stops the camera and closes the device.
     /// </summary>
-    /// <returns></returns>
+    /// <returns><see langword="true"/> on success, <see langword="false"/>
+    /// if the device was not running.</returns>
     UFUNCTION(BlueprintCallable, Category = "Device")
     bool Stop();
 
+#if WITH_EDITOR
+    void PostEditChangeProperty(FPropertyChangedEvent& event) override;
+#endif /* WITH_EDITOR */
+
 private:
 
+    /// <summary>
+    /// Associates the device timestamp of a capture with the number the
+    /// capture stage has assigned to it.
+    /// </summary>
+    struct FFrameSequence {
+        int64 DeviceTimestamp;
+        int64 Sequence;
+    };
+
+    /// <summary>
+    /// The number of captures whose numbers are remembered for the stages
+    /// processing them, which must exceed the frames that can be in flight.
+    /// </summary>
+    static constexpr int32 FrameSequenceHistory = 64;
+
+    /// <summary>
+    /// Answer the palette <see cref="BodyIndexPalette" /> is initialised
+    /// with.
+    /// </summary>
+    static TArray<FColor> GetDefaultBodyIndexPalette(void);
+
     static FString GetPluginLocation(void);
 
+    /// <summary>
+    /// Answer the image the frame information of <paramref name="capture" />
+    /// is derived from, which is its depth image or, if there is none, its
+    /// colour or infrared image.
+    /// </summary>
+    static k4a::image GetReferenceImage(const k4a::capture& capture);
+
     static inline bool HasSize(const UTextureRenderTarget2D *texture,
             const int32 width,
             const int32 height) noexcept {
@@ -195,53 +664,225 @@ private:
             && (texture->GetSurfaceHeight() == height);
     }
 
-    static std::chrono::milliseconds ToFrameTime(
-        const EKinectFps frameRate) noexcept;
+    static inline bool HasSize(const UTextureRenderTarget2D *texture,
+            const int32 width,
+            const int32 height,
+            const EPixelFormat format) noexcept {
+        return HasSize(texture, width, height)
+            && (texture->GetFormat() == format);
+    }
 
-    static FTransform ToTransform(const k4abt_joint_t& joint,
-        const int32 index);
+    static void InitColourTexture(UTextureRenderTarget2D *rt,
+        const int32 width,
+        const int32 height);
 
-    static void Update(UTextureRenderTarget2D *rt,
-        TArray<uint8>&& data,
+    static void InitSensorTexture(UTextureRenderTarget2D *rt,
         const int32 width,
         const int32 height,
-        const int32 pitch);
+        const EKinectSensorTextureFormat format);
 
-    static inline void Update(UTextureRenderTarget2D *rt,
-            const void *data,
-            const int32 width,
-            const int32 height,
-            const int32 pitch) {
-        TArray<uint8> d(static_cast<const uint8 *>(data), height * pitch);
-        UAzureKinectDevice::Update(rt, std::move(d), width, height, pitch);
+    static inline bool IsColourRemapped(const EKinectRemap remap) noexcept {
+        return (remap == EKinectRemap::COLOUR_TO_DEPTH)
+            || (remap == EKinectRemap::BOTH);
+    }
+
+    static inline bool IsDepthRemapped(const EKinectRemap remap) noexcept {
+        return (remap == EKinectRemap::DEPTH_TO_COLOUR)
+            || (remap == EKinectRemap::BOTH);
     }
 
-    void CaptureBodyIndexTexture(const k4abt::frame& frame);
+    static EPixelFormat ToPixelFormat(
+        const EKinectSensorTextureFormat format) noexcept;
+
+    static int32 ToFramesPerSecond(const EKinectFps frameRate) noexcept;
+
+    static std::chrono::milliseconds ToFrameTime(
+        const EKinectFps frameRate) noexcept;
+
+    static void ToJoint(FVector3f& position,
+        FQuat4f& rotation,
+        EKinectJointConfidence& confidence,
+        const k4abt_joint_t& joint);
+
+    /// <summary>
+    /// Applies the <see cref="LowConfidencePolicy" /> to the joints of
+    /// <paramref name="skeleton" />.
+    /// </summary>
+    /// <param name="skeleton">The skeleton to be processed.</param>
+    /// <param name="previous">The most recent snapshot, which provides the
+    /// last values of the joints that are held and the offsets of the joints
+    /// that follow their parents.</param>
+    void ApplyJointPolicy(FAzureKinectSkeletonData& skeleton,
+        const FAzureKinectSkeletonSnapshot *previous) const;
+
+    void CaptureBodyIndexTexture(const k4abt::frame& frame,
+        FAzureKinectTextureUploads& uploads);
+
+    /// <summary>
+    /// Fills the lookup table mapping the body indices of
+    /// <paramref name="frame" /> to texels in the current
+    /// <see cref="BodyIndexMode" />.
+    /// </summary>
+    /// <remarks>
+    /// This method is called on worker threads and therefore only reads the
+    /// copy of the palette made by <see cref="UpdateBodyIndexColours" />.
+    /// </remarks>
+    void GetBodyIndexLut(const k4abt::frame& frame, uint32 (&lut)[256]) const;
 
-    void CaptureColourTexture(k4a::capture& capture);
+    /// <summary>
+    /// Answer the frame of <paramref name="capture" />, which is the one of
+    /// its reference image.
+    /// </summary>
+    FAzureKinectFrameInfo GetFrameInfo(const k4a::capture& capture) const;
 
-    void CaptureDepthTexture(k4a::capture& capture);
+    FAzureKinectFrameInfo GetFrameInfo(const k4abt::frame& frame) const;
+
+    /// <summary>
+    /// Answer the frame with the given timestamps, whose number is looked up
+    /// from the ones <see cref="UpdateFrameSequence" /> has assigned.
+    /// </summary>
+    FAzureKinectFrameInfo GetFrameInfo(
+        const std::chrono::microseconds deviceTimestamp,
+        const std::chrono::nanoseconds systemTimestamp) const;
+
+    void CaptureColourTexture(k4a::capture& capture,
+        FAzureKinectTextureUploads& uploads);
+
+    void CaptureDepthTexture(k4a::capture& capture,
+        FAzureKinectTextureUploads& uploads);
+
+    void CaptureInfraredTexture(k4a::capture& capture,
+        FAzureKinectTextureUploads& uploads);
+
+    /// <summary>
+    /// Generates a point cloud from the depth image of
+    /// <paramref name="capture" />, decimates it if requested and publishes
+    /// it.
+    /// </summary>
+    void CapturePointCloud(k4a::capture& capture);
 
-    void CaptureInfraredTexture(k4a::capture& capture);
+    void CaptureSensorTexture(k4a::capture& capture,
+        const k4abt::frame *frame,
+        FAzureKinectTextureUploads& uploads);
 
     /// <summary>
-    /// This method is called periodically be the
-    /// <see cref="FAzureKinectDeviceThread"/>.
+    /// Adds the updates of the colour, depth and infrared textures from
+    /// <paramref name="capture" /> and the body index texture from
+    /// <paramref name="frame" /> to <paramref name="uploads" />.
+    /// </summary>
+    /// <remarks>
+    /// The streams are processed in parallel by the worker pool. Either of
+    /// the inputs may be empty, in which case its textures are skipped.
+    /// </remarks>
+    void ConvertCapture(k4a::capture& capture,
+        const k4abt::frame *frame,
+        FAzureKinectTextureUploads& uploads);
+
+    /// <summary>
+    /// Expands a depth or infrared image into RGBA8 texels in tiles of
+    /// <see cref="ConversionTileRows" /> rows.
+    /// </summary>
+    void Expand16(uint8 *dst,
+        const uint16 *src,
+        const int32 width,
+        const int32 height);
+
+    /// <summary>
+    /// Replaces <paramref name="capture" /> with a new capture holding the
+    /// filtered depth image and the other images of the original one.
+    /// </summary>
+    /// <remarks>
+    /// The original capture is shared with the body tracker, so it must not
+    /// be modified. If the filtering fails, the capture remains unchanged.
+    /// </remarks>
+    void FilterDepth(k4a::capture& capture);
+
+    /// <summary>
+    /// Runs one iteration of the conversion stage, which waits for the next
+    /// capture and updates the colour, depth and infrared textures from it.
+    /// </summary>
+    void ConvertAsync(void);
+
+    /// <summary>
+    /// Runs one iteration of the tracker result stage, which waits for the
+    /// body tracker to finish a frame and publishes its results.
+    /// </summary>
+    void PopTrackerResultAsync(void);
+
+    /// <summary>
+    /// Runs one iteration of the tracking stage, which waits for the next
+    /// capture and feeds it to the body tracker.
+    /// </summary>
+    void TrackAsync(void);
+
+    /// <summary>
+    /// Runs one iteration of the capture stage, which retrieves the next
+    /// capture from the device and forwards it to the conversion and tracking
+    /// stages.
     /// </summary>
     void UpdateAsync(void);
 
-    void UpdateSkeletons(k4a::capture& capture);
+    /// <summary>
+    /// Converts <see cref="BodyIndexPalette" /> into the packed colours the
+    /// body index map is converted with. This must be called on the game
+    /// thread.
+    /// </summary>
+    void UpdateBodyIndexColours(void);
+
+    /// <summary>
+    /// Assigns the next frame number to <paramref name="capture" />, which
+    /// must be called on the capture thread for every capture retrieved from
+    /// the device.
+    /// </summary>
+    void UpdateFrameSequence(const k4a::capture& capture);
+
+    void UpdateSkeletons(k4abt::frame& frame);
 
+    TArray<uint32> _bodyIndexColours;
+    mutable FCriticalSection _bodyIndexLock;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _bodyIndexPool;
     k4abt::tracker _bodyTracker;
     k4a::calibration _calibration;
-    int32 _cntTrackedSkeletons;
+    FThreadSafeCounter64 _cntCaptured;
+    FThreadSafeCounter64 _cntCaptureTimeouts;
+    FThreadSafeCounter64 _cntConverted;
+    FThreadSafeCounter64 _cntTracked;
+    FThreadSafeCounter64 _cntTrackerEnqueued;
+    FAzureKinectDeviceThread *_captureThread;
+    FAzureKinectColourDecoder _colourDecoder;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _colourPool;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _colourRemapPool;
+    FAzureKinectDeviceThread *_conversionThread;
+    TAzureKinectQueue<k4a::capture> _conversionQueue;
+    FAzureKinectDecimation _decimation;
+    FAzureKinectDepthFilter _depthFilter;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _depthFilterPool;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _depthPool;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _depthRemapPool;
     k4a::device _device;
+    int64 _frameSequence;
+    mutable FCriticalSection _frameSequenceLock;
+    FFrameSequence _frameSequences[FrameSequenceHistory];
+    int32 _framesPerSecond;
     std::chrono::milliseconds _frameTime;
-    mutable FCriticalSection _lock;
-    k4a::image _remapImage;
-    TArray<FAzureKinectSkeleton> _skeletons;
-    k4a::transformation _transform;
-    FAzureKinectDeviceThread *_thread;
+    TSharedPtr<FAzureKinectGpuBuffers, ESPMode::ThreadSafe> _gpuBuffers;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _infraredPool;
+    k4a::capture _pendingTrackerCapture;
+    TAzureKinectSnapshotBuffer<FAzureKinectPointCloud> _pointClouds;
+    TArray<int32> _pointCloudRows;
+    uint64 _pointCloudSequence;
+    FAzureKinectRegistration _registration;
+    TSharedPtr<FAzureKinectBufferPool, ESPMode::ThreadSafe> _sensorPool;
+    FAzureKinectSkeletonFilter _skeletonFilter;
+    TAzureKinectSnapshotBuffer<FAzureKinectSkeletonSnapshot> _skeletons;
+    uint64 _skeletonSequence;
+    double _systemTimeOffset;
+    bool _texturesFromTracker;
+    FAzureKinectDeviceThread *_trackingThread;
+    TAzureKinectQueue<k4a::capture> _trackingQueue;
+    FAzureKinectDeviceThread *_trackerResultThread;
+    TSharedPtr<FAzureKinectTextureUploader, ESPMode::ThreadSafe> _uploader;
+    FAzureKinectWorkerPool _workers;
 
     friend class FAzureKinectDeviceThread;
 };
@@ -77,6 +77,22 @@ enum class EKinectColourResolution : uint8 {
 };
 
 
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectColourFormat : uint8 {
+    /** Motion JPEG, which is decoded on the CPU. */
+    MJPG = 0        UMETA(DisplayName = "MJPG"),
+
+    /** NV12, which is only available at 720p. */
+    NV12            UMETA(DisplayName = "NV12 (720p only)"),
+
+    /** YUY2, which is only available at 720p. */
+    YUY2            UMETA(DisplayName = "YUY2 (720p only)"),
+
+    /** BGRA32, which is converted from MJPG by the SDK. */
+    BGRA32          UMETA(DisplayName = "BGRA32"),
+};
+
+
 UENUM(BlueprintType, Category = "Azure Kinect|Enums")
 enum class EKinectFps : uint8 {
     PER_SECOND_5 = 0    UMETA(DisplayName = "5 fps"),
@@ -85,10 +101,45 @@ enum class EKinectFps : uint8 {
 };
 
 
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectQueuePolicy : uint8 {
+    /** Discard the oldest queued item to make room for the new one. */
+    DROP_OLDEST = 0     UMETA(DisplayName = "Drop oldest"),
+
+    /** Discard the new item and keep the queued ones. */
+    DROP_NEWEST         UMETA(DisplayName = "Drop newest"),
+
+    /** Block the producer until there is room in the queue. */
+    BLOCK               UMETA(DisplayName = "Block"),
+};
+
+
 UENUM(BlueprintType, Category = "Azure Kinect|Enums")
 enum class EKinectRemap : uint8 {
     COLOUR_TO_DEPTH = 0     UMETA(DisplayName = "Colour to Depth"),
     DEPTH_TO_COLOUR         UMETA(DisplayName = "Depth to Colour"),
+
+    /** Neither image is remapped. */
+    NONE                    UMETA(DisplayName = "None"),
+
+    /** Colour is remapped to depth and depth to colour. */
+    BOTH                    UMETA(DisplayName = "Both"),
+};
+
+
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectBodyIndexMode : uint8 {
+    /** Each body index is written as a shade of grey, background is white. */
+    GREYSCALE = 0   UMETA(DisplayName = "Greyscale"),
+
+    /**
+     * Each body is coloured according to its ID using the palette of the
+     * device, background is transparent black.
+     */
+    PALETTE         UMETA(DisplayName = "Palette"),
+
+    /** The body index map is uploaded as it is into a single 8-bit channel. */
+    RAW_G8          UMETA(DisplayName = "Raw (G8)"),
 };
 
 
@@ -130,6 +181,77 @@ enum class EKinectBodyJoint : uint8 {
 };
 
 
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectJointConfidence : uint8 {
+    /** The joint is out of range, i.e. too far from the depth camera. */
+    NONE = 0    UMETA(DisplayName = "None"),
+
+    /** The joint is not observed, likely due to occlusion, but predicted. */
+    LOW         UMETA(DisplayName = "Low"),
+
+    /** The joint is observed with medium confidence. */
+    MEDIUM      UMETA(DisplayName = "Medium"),
+
+    /** The joint is observed with high confidence (not yet supported). */
+    HIGH        UMETA(DisplayName = "High"),
+};
+
+
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectJointPolicy : uint8 {
+    /** Publish the joint as it was tracked. */
+    KEEP = 0    UMETA(DisplayName = "Keep"),
+
+    /**
+     * Publish the last value of the joint that met the threshold while the
+     * body has been tracked, including the confidence it had then.
+     */
+    HOLD_LAST   UMETA(DisplayName = "Hold last"),
+
+    /**
+     * Publish the rotation of the parent joint and move the joint rigidly
+     * with the parent, keeping the offset it had in the previous frame.
+     */
+    USE_PARENT  UMETA(DisplayName = "Use parent"),
+
+    /**
+     * Mark the joint as out of range such that consumers skip it. The pose
+     * animation node only does so if SkipUntrackedJoints is enabled.
+     */
+    SKIP        UMETA(DisplayName = "Skip"),
+};
+
+
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectSkeletonFilter : uint8 {
+    /** The skeletons are published as they were tracked. */
+    NONE = 0    UMETA(DisplayName = "None"),
+
+    /** Each joint is smoothed by a speed-adaptive low-pass filter. */
+    ONE_EURO    UMETA(DisplayName = "One Euro"),
+
+    /** Each joint is smoothed by a constant-velocity Kalman filter. */
+    KALMAN      UMETA(DisplayName = "Kalman"),
+};
+
+
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectSensorTextureFormat : uint8 {
+    /**
+     * Four channels of 8 bits, which hold the low byte of the sample in red,
+     * the high byte in green, 0xFF in blue if the sample is invalid and 0xFF
+     * in alpha.
+     */
+    RGBA8 = 0   UMETA(DisplayName = "RGBA8 (expanded)"),
+
+    /** A single normalised 16-bit channel holding the sample as it is. */
+    G16         UMETA(DisplayName = "G16 (normalised)"),
+
+    /** A single unsigned integer 16-bit channel holding the sample as it is. */
+    R16_UINT    UMETA(DisplayName = "R16 (unsigned integer)"),
+};
+
+
 UENUM(BlueprintType, Category = "Azure Kinect|Enums")
 enum class EKinectSensorOrientation : uint8 {
     /** Mount the sensor at its default orientation */
@@ -146,6 +268,25 @@ enum class EKinectSensorOrientation : uint8 {
 };
 
 
+UENUM(BlueprintType, Category = "Azure Kinect|Enums")
+enum class EKinectStream : uint8 {
+    /** The colour image. */
+    COLOUR = 0      UMETA(DisplayName = "Colour"),
+
+    /** The depth image. */
+    DEPTH           UMETA(DisplayName = "Depth"),
+
+    /** The infrared image. */
+    INFRARED        UMETA(DisplayName = "Infrared"),
+
+    /** The body index map created by the body tracker. */
+    BODY_INDEX      UMETA(DisplayName = "Body index"),
+
+    /** The combination of depth, infrared and body index. */
+    SENSOR          UMETA(DisplayName = "Sensor"),
+};
+
+
 UENUM(BlueprintType, Category = "Azure Kinect|Enums")
 enum class EKinectTrackerProcessing : uint8 {
 
@@ -0,0 +1,62 @@
+﻿// <copyright file="AzureKinectFrameInfo.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AzureKinectFrameInfo.generated.h"
+
+
+/// <summary>
+/// Identifies the frame of the device that published data are derived from.
+/// </summary>
+/// <remarks>
+/// All members are zero if nothing has been published yet.
+/// </remarks>
+USTRUCT(BlueprintType)
+struct FAzureKinectFrameInfo {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The centre of the exposure in microseconds on the clock of the device,
+    /// which starts when the cameras are started.
+    /// </summary>
+    /// <remarks>
+    /// This is the time base for relating the streams of the device to each
+    /// other, because it is not affected by the latency of USB or the
+    /// pipeline.
+    /// </remarks>
+    UPROPERTY(BlueprintReadOnly, Category = "Device")
+    int64 DeviceTimestamp = 0;
+
+    /// <summary>
+    /// The number of the frame, which is counted on the host starting from
+    /// zero for the first frame after the device has been started.
+    /// </summary>
+    /// <remarks>
+    /// The number advances by the frame periods between the device timestamps
+    /// of consecutive captures, so consecutive frames of the device differ by
+    /// one, and any larger difference indicates that frames have been dropped
+    /// by the device or later in the pipeline.
+    /// </remarks>
+    UPROPERTY(BlueprintReadOnly, Category = "Device")
+    int64 Sequence = 0;
+
+    /// <summary>
+    /// The time in nanoseconds on the monotonic clock of the host when the
+    /// frame was received from the device.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Device")
+    int64 SystemTimestamp = 0;
+
+    /// <summary>
+    /// Answer <see cref="DeviceTimestamp" /> in seconds.
+    /// </summary>
+    inline double GetDeviceTime(void) const noexcept {
+        return 1e-6 * static_cast<double>(this->DeviceTimestamp);
+    }
+};
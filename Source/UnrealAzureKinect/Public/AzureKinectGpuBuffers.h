@@ -0,0 +1,161 @@
+﻿// <copyright file="AzureKinectGpuBuffers.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "RHIUtilities.h"
+#include "Templates/SharedPointer.h"
+
+#include "AzureKinectPointCloud.h"
+#include "AzureKinectSkeleton.h"
+#include "AzureKinectSnapshotBuffer.h"
+
+
+/// <summary>
+/// Holds the most recent point cloud and skeletons of a device in GPU
+/// buffers, which can be bound to any number of shaders.
+/// </summary>
+/// <remarks>
+/// <para>The buffers are updated from the snapshots published by the device.
+/// A snapshot is only uploaded if its sequence number differs from the one
+/// uploaded before, so all users of the buffers share a single upload per
+/// frame. The buffers only grow, so they are rarely reallocated.</para>
+/// <para>The layout of the buffers is as follows: the positions of the points
+/// are stored as three floats each, their colours as <c>FColor</c>, i.e. as
+/// BGRA8, which is viewed as RGBA8 and must be swizzled. Each joint
+/// occupies two float4, the first one holding its position with w being one,
+/// or zero if the joint is out of range, the second one its rotation as
+/// quaternion. The joints of a skeleton are stored consecutively in the order
+/// of <c>k4abt_joint_id_t</c>.</para>
+/// <para>All methods except for the constructor and the destructor must only
+/// be called on the render thread. The destructor defers releasing the
+/// buffers to the render thread. The instance must always be allocated as a
+/// shared object.</para>
+/// </remarks>
+class UNREALAZUREKINECT_API FAzureKinectGpuBuffers final
+        : public TSharedFromThis<FAzureKinectGpuBuffers, ESPMode::ThreadSafe> {
+
+public:
+
+    /// <summary>
+    /// The type of the point cloud snapshots uploaded.
+    /// </summary>
+    typedef TAzureKinectSnapshotBuffer<FAzureKinectPointCloud>::SnapshotType
+        PointCloudType;
+
+    /// <summary>
+    /// The type of the skeleton snapshots uploaded.
+    /// </summary>
+    typedef TAzureKinectSnapshotBuffer<FAzureKinectSkeletonSnapshot>::SnapshotType
+        SkeletonsType;
+
+    /// <summary>
+    /// The number of joints stored for each skeleton.
+    /// </summary>
+    static constexpr int32 JointCount = FAzureKinectSkeletonData::JointCount;
+
+    /// <summary>
+    /// Initialises a new instance without any buffers.
+    /// </summary>
+    FAzureKinectGpuBuffers(void);
+
+    FAzureKinectGpuBuffers(const FAzureKinectGpuBuffers&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~FAzureKinectGpuBuffers(void);
+
+    /// <summary>
+    /// Answer the number of colours, which is either zero or the number of
+    /// points.
+    /// </summary>
+    inline int32 GetColourCount(void) const noexcept {
+        return this->_colourCount;
+    }
+
+    /// <summary>
+    /// Answer the RGBA8 view of the BGRA8 colours of the points, which is
+    /// <see langword="nullptr" /> if nothing has been uploaded yet.
+    /// </summary>
+    inline FRHIShaderResourceView *GetColours(void) const noexcept {
+        return this->_colours.SRV;
+    }
+
+    /// <summary>
+    /// Answer the view of the joints of all skeletons, which is
+    /// <see langword="nullptr" /> if nothing has been uploaded yet.
+    /// </summary>
+    inline FRHIShaderResourceView *GetJoints(void) const noexcept {
+        return this->_joints.SRV;
+    }
+
+    /// <summary>
+    /// Answer the number of points in the point cloud.
+    /// </summary>
+    inline int32 GetPointCount(void) const noexcept {
+        return this->_pointCount;
+    }
+
+    /// <summary>
+    /// Answer the view of the positions of the points, which is
+    /// <see langword="nullptr" /> if nothing has been uploaded yet.
+    /// </summary>
+    inline FRHIShaderResourceView *GetPoints(void) const noexcept {
+        return this->_points.SRV;
+    }
+
+    /// <summary>
+    /// Answer the number of skeletons.
+    /// </summary>
+    inline int32 GetSkeletonCount(void) const noexcept {
+        return this->_skeletonCount;
+    }
+
+    /// <summary>
+    /// Answer the view of the IDs of the skeletons, which is
+    /// <see langword="nullptr" /> if nothing has been uploaded yet.
+    /// </summary>
+    inline FRHIShaderResourceView *GetSkeletonIDs(void) const noexcept {
+        return this->_skeletonIDs.SRV;
+    }
+
+    /// <summary>
+    /// Uploads the given snapshots unless they have already been uploaded.
+    /// </summary>
+    /// <param name="cmdList">The command list used for the upload.</param>
+    /// <param name="pointCloud">The most recent point cloud, which may be
+    /// <see langword="nullptr" />.</param>
+    /// <param name="skeletons">The most recent skeletons, which may be
+    /// <see langword="nullptr" />.</param>
+    void Update(FRHICommandListBase& cmdList,
+        const PointCloudType& pointCloud,
+        const SkeletonsType& skeletons);
+
+    FAzureKinectGpuBuffers& operator =(
+        const FAzureKinectGpuBuffers&) = delete;
+
+private:
+
+    static void *Lock(FRHICommandListBase& cmdList,
+        FReadBuffer& buffer,
+        const TCHAR *name,
+        const EPixelFormat format,
+        const uint32 bytesPerElement,
+        const int32 cnt);
+
+    FReadBuffer _colours;
+    int32 _colourCount;
+    FReadBuffer _joints;
+    uint64 _pointCloudSequence;
+    int32 _pointCount;
+    FReadBuffer _points;
+    int32 _skeletonCount;
+    FReadBuffer _skeletonIDs;
+    uint64 _skeletonSequence;
+};
@@ -0,0 +1,53 @@
+﻿// <copyright file="AzureKinectPointCloud.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AzureKinectFrameInfo.h"
+#include "AzureKinectStatistics.h"
+
+
+/// <summary>
+/// An immutable point cloud generated from a single depth image.
+/// </summary>
+/// <remarks>
+/// Only pixels with a valid depth produce a point, so the number of points
+/// varies from frame to frame. The device reuses the arrays of snapshots
+/// that are not referenced anymore, so their memory is allocated only once.
+/// </remarks>
+struct FAzureKinectPointCloud {
+
+    /// <summary>
+    /// The colours of the points in the order of <see cref="Positions" />,
+    /// which is empty if no colours are requested. Points outside the colour
+    /// image are transparent black.
+    /// </summary>
+    TArray<FColor> Colours;
+
+    /// <summary>
+    /// The frame of the device the depth image has been captured in.
+    /// </summary>
+    FAzureKinectFrameInfo FrameInfo;
+
+    /// <summary>
+    /// The positions of the points in centimetres in the coordinate system
+    /// of Unreal, which is the one of the skeletons as well.
+    /// </summary>
+    TArray<FVector3f> Positions;
+
+    /// <summary>
+    /// A number that increases with every point cloud published by the
+    /// device.
+    /// </summary>
+    uint64 Sequence = 0;
+
+    /// <summary>
+    /// The cost of generating and decimating the point cloud.
+    /// </summary>
+    FAzureKinectPointCloudStatistics Statistics;
+};
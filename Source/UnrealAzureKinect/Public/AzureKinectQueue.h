@@ -0,0 +1,219 @@
+﻿// <copyright file="AzureKinectQueue.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+
+#include "CoreMinimal.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+
+#include "AzureKinectEnum.h"
+#include "AzureKinectStatistics.h"
+
+
+/// <summary>
+/// A bounded queue connecting two stages of the capture pipeline.
+/// </summary>
+/// <remarks>
+/// <para>The queue is a ring buffer of fixed capacity. What happens if a
+/// producer pushes into a full queue is determined by the
+/// <see cref="EKinectQueuePolicy" /> the queue was opened with. By default,
+/// the oldest item is discarded, because a stale capture is worth less than a
+/// recent one.</para>
+/// <para>The queue is intended to be used by a single producer and a single
+/// consumer thread, which can block on it for a limited amount of
+/// time. Multiple consumers are safe, but each item only wakes one of
+/// them, so consumers should not block for long.</para>
+/// </remarks>
+/// <typeparam name="TItem">The type of the items in the queue, which must be
+/// default-constructible and movable.</typeparam>
+template<class TItem> class TAzureKinectQueue final {
+
+public:
+
+    /// <summary>
+    /// Initialises a new, closed queue.
+    /// </summary>
+    TAzureKinectQueue(void)
+        : _capacity(0),
+        _closed(true),
+        _count(0),
+        _dropped(0),
+        _event(FPlatformProcess::GetSynchEventFromPool(false)),
+        _head(0),
+        _policy(EKinectQueuePolicy::DROP_OLDEST),
+        _spaceEvent(FPlatformProcess::GetSynchEventFromPool(false)) { }
+
+    TAzureKinectQueue(const TAzureKinectQueue&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~TAzureKinectQueue(void) {
+        FPlatformProcess::ReturnSynchEventToPool(this->_event);
+        FPlatformProcess::ReturnSynchEventToPool(this->_spaceEvent);
+    }
+
+    /// <summary>
+    /// Discards all queued items, rejects any further items and wakes a
+    /// consumer blocking in <see cref="Pop" /> as well as a producer blocking
+    /// in <see cref="Push" />.
+    /// </summary>
+    void Close(void) {
+        {
+            FScopeLock l(&this->_lock);
+            this->_closed = true;
+            this->_count = 0;
+            this->_head = 0;
+            this->_items.Empty();
+        }
+
+        this->_event->Trigger();
+        this->_spaceEvent->Trigger();
+    }
+
+    /// <summary>
+    /// Fills the queue-related counters of the given statistics.
+    /// </summary>
+    /// <param name="statistics">The statistics of the stage the queue
+    /// feeds.</param>
+    void GetStatistics(FAzureKinectStageStatistics& statistics) const {
+        FScopeLock l(&this->_lock);
+        statistics.Capacity = this->_capacity;
+        statistics.Dropped += this->_dropped;
+        statistics.Pending = this->_count;
+    }
+
+    /// <summary>
+    /// Clears the queue, resets its counters and makes it accept up to
+    /// <paramref name="capacity" /> items.
+    /// </summary>
+    /// <param name="capacity">The maximum number of queued items, which will
+    /// be clamped to at least one.</param>
+    /// <param name="policy">Determines how <see cref="Push" /> handles a full
+    /// queue.</param>
+    void Open(const int32 capacity,
+            const EKinectQueuePolicy policy = EKinectQueuePolicy::DROP_OLDEST) {
+        FScopeLock l(&this->_lock);
+        this->_capacity = FMath::Max(capacity, 1);
+        this->_closed = false;
+        this->_count = 0;
+        this->_dropped = 0;
+        this->_head = 0;
+        this->_items.Empty(this->_capacity);
+        this->_items.SetNum(this->_capacity);
+        this->_policy = policy;
+    }
+
+    /// <summary>
+    /// Removes the oldest item from the queue, waiting at most
+    /// <paramref name="timeout" /> for one to arrive.
+    /// </summary>
+    /// <param name="item">Receives the item on success.</param>
+    /// <param name="timeout">The maximum time to block.</param>
+    /// <returns><see langword="true" /> if an item was retrieved,
+    /// <see langword="false" /> if the queue was empty or closed.</returns>
+    bool Pop(TItem& item, const std::chrono::milliseconds timeout) {
+        if (this->TryPop(item)) {
+            return true;
+        }
+
+        this->_event->Wait(static_cast<uint32>(timeout.count()));
+        return this->TryPop(item);
+    }
+
+    /// <summary>
+    /// Appends an item to the queue, applying the policy of the queue if it
+    /// is full.
+    /// </summary>
+    /// <param name="item">The item to be queued.</param>
+    /// <returns><see langword="true" /> if the item was queued,
+    /// <see langword="false" /> if the queue is closed or if the item was
+    /// discarded.</returns>
+    bool Push(TItem&& item) {
+        while (true) {
+            {
+                FScopeLock l(&this->_lock);
+                if (this->_closed) {
+                    return false;
+                }
+
+                if (this->_count == this->_capacity) {
+                    switch (this->_policy) {
+                        case EKinectQueuePolicy::DROP_NEWEST:
+                            ++this->_dropped;
+                            return false;
+
+                        case EKinectQueuePolicy::BLOCK:
+                            // Wait for the consumer outside the lock.
+                            break;
+
+                        default:
+                            this->_items[this->_head] = TItem();
+                            this->_head = (this->_head + 1) % this->_capacity;
+                            --this->_count;
+                            ++this->_dropped;
+                            break;
+                    }
+                }
+
+                if (this->_count < this->_capacity) {
+                    const auto tail = (this->_head + this->_count)
+                        % this->_capacity;
+                    this->_items[tail] = MoveTemp(item);
+                    ++this->_count;
+                    break;
+                }
+            }
+
+            this->_spaceEvent->Wait();
+        }
+
+        this->_event->Trigger();
+        return true;
+    }
+
+    /// <summary>
+    /// Removes the oldest item from the queue if there is any.
+    /// </summary>
+    /// <param name="item">Receives the item on success.</param>
+    /// <returns><see langword="true" /> if an item was retrieved,
+    /// <see langword="false" /> otherwise.</returns>
+    bool TryPop(TItem& item) {
+        {
+            FScopeLock l(&this->_lock);
+            if (this->_count < 1) {
+                return false;
+            }
+
+            item = MoveTemp(this->_items[this->_head]);
+            this->_items[this->_head] = TItem();
+            this->_head = (this->_head + 1) % this->_capacity;
+            --this->_count;
+        }
+
+        this->_spaceEvent->Trigger();
+        return true;
+    }
+
+    TAzureKinectQueue& operator =(const TAzureKinectQueue&) = delete;
+
+private:
+
+    int32 _capacity;
+    bool _closed;
+    int32 _count;
+    int64 _dropped;
+    FEvent *_event;
+    int32 _head;
+    TArray<TItem> _items;
+    mutable FCriticalSection _lock;
+    EKinectQueuePolicy _policy;
+    FEvent *_spaceEvent;
+};
@@ -0,0 +1,199 @@
+﻿// <copyright file="AzureKinectRegistration.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "k4a/k4a.hpp"
+
+#include "AzureKinectWorkerPool.h"
+
+
+/// <summary>
+/// Maps images between the depth and the colour camera using lookup tables
+/// that are computed once from the calibration of the device.
+/// </summary>
+/// <remarks>
+/// <para>The registration replaces the per-frame geometry of
+/// <see cref="k4a::transformation" />. It stores the ray of each depth pixel
+/// and a grid of the projection of the colour camera including its lens
+/// distortion, which is interpolated bilinearly. Each frame therefore only
+/// requires a rigid transformation, a division and a table lookup per depth
+/// pixel.</para>
+/// <para>The registration only depends on the calibration, which can also be
+/// synthetic, so it does not require a device.</para>
+/// </remarks>
+class FAzureKinectRegistration final {
+
+public:
+
+    /// <summary>
+    /// The largest supported width of the depth image.
+    /// </summary>
+    static constexpr int32 MaxDepthWidth = 1024;
+
+    /// <summary>
+    /// Initialises a new, invalid instance.
+    /// </summary>
+    FAzureKinectRegistration(void);
+
+    FAzureKinectRegistration(const FAzureKinectRegistration&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~FAzureKinectRegistration(void) = default;
+
+    /// <summary>
+    /// Maps the colour image into the depth camera.
+    /// </summary>
+    /// <remarks>
+    /// Each valid depth pixel receives the colour of the nearest colour
+    /// pixel it projects to. Pixels without depth or outside the colour image
+    /// are zero.
+    /// </remarks>
+    /// <param name="dst">The output image of the size of the depth
+    /// image.</param>
+    /// <param name="colour">The BGRA32 colour image.</param>
+    /// <param name="depth">The depth image.</param>
+    /// <param name="workers">The pool processing the rows in
+    /// parallel.</param>
+    /// <param name="tileRows">The number of rows processed as one
+    /// tile.</param>
+    void ColourToDepth(uint32 *dst,
+        const uint32 *colour,
+        const uint16 *depth,
+        FAzureKinectWorkerPool& workers,
+        const int32 tileRows) const;
+
+    /// <summary>
+    /// Maps the depth image into the colour camera.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each quad of neighbouring depth pixels that does not span a
+    /// discontinuity is rasterised into the colour image using the mean depth
+    /// in the colour camera. If multiple quads cover a pixel, the nearest one
+    /// wins. Pixels that are not covered are zero.</para>
+    /// <para>The method uses the instance as scratch space and must therefore
+    /// not be called concurrently.</para>
+    /// </remarks>
+    /// <param name="dst">The output image of the size of the colour
+    /// image.</param>
+    /// <param name="depth">The depth image.</param>
+    /// <param name="workers">The pool processing the rows in
+    /// parallel.</param>
+    /// <param name="tileRows">The number of rows processed as one
+    /// tile.</param>
+    void DepthToColour(uint16 *dst,
+        const uint16 *depth,
+        FAzureKinectWorkerPool& workers,
+        const int32 tileRows);
+
+    /// <summary>
+    /// Answer the height of the colour image in pixels.
+    /// </summary>
+    inline int32 GetColourHeight(void) const noexcept {
+        return this->_colourHeight;
+    }
+
+    /// <summary>
+    /// Answer the width of the colour image in pixels.
+    /// </summary>
+    inline int32 GetColourWidth(void) const noexcept {
+        return this->_colourWidth;
+    }
+
+    /// <summary>
+    /// Answer the height of the depth image in pixels.
+    /// </summary>
+    inline int32 GetDepthHeight(void) const noexcept {
+        return this->_depthHeight;
+    }
+
+    /// <summary>
+    /// Answer the width of the depth image in pixels.
+    /// </summary>
+    inline int32 GetDepthWidth(void) const noexcept {
+        return this->_depthWidth;
+    }
+
+    /// <summary>
+    /// Answer the x-components of the rays of the depth pixels at a depth of
+    /// one, which are NaN if a pixel cannot be unprojected.
+    /// </summary>
+    inline const float *GetRaysX(void) const noexcept {
+        return this->_raysX.GetData();
+    }
+
+    /// <summary>
+    /// Answer the y-components of the rays of the depth pixels at a depth of
+    /// one, which are NaN if a pixel cannot be unprojected.
+    /// </summary>
+    inline const float *GetRaysY(void) const noexcept {
+        return this->_raysY.GetData();
+    }
+
+    /// <summary>
+    /// Answer whether the tables for mapping between depth and colour have
+    /// been computed.
+    /// </summary>
+    inline bool IsValid(void) const noexcept {
+        return (this->_depthWidth > 0) && (this->_colourGrid.Num() > 0);
+    }
+
+    /// <summary>
+    /// Computes the lookup tables from the given calibration.
+    /// </summary>
+    /// <remarks>
+    /// The rays are also computed if the colour camera is disabled, in which
+    /// case the instance is not valid for mapping images.
+    /// </remarks>
+    /// <param name="calibration">The calibration of the device.</param>
+    /// <exception cref="k4a::error">If the calibration is invalid.</exception>
+    void Reset(const k4a::calibration& calibration);
+
+    /// <summary>
+    /// Releases all lookup tables.
+    /// </summary>
+    void Reset(void);
+
+    FAzureKinectRegistration& operator =(
+        const FAzureKinectRegistration&) = delete;
+
+private:
+
+    /// <summary>
+    /// The distance of the nodes of the projection grid in colour pixels.
+    /// </summary>
+    static constexpr float GridSpacing = 8.0f;
+
+    bool Project(float& u,
+        float& v,
+        const float x,
+        const float y) const noexcept;
+
+    void ProjectRows(const uint16 *depth, const int32 begin, const int32 end);
+
+    TArray<FVector2f> _colourGrid;
+    int32 _colourGridHeight;
+    float _colourGridMinX;
+    float _colourGridMinY;
+    float _colourGridScale;
+    int32 _colourGridWidth;
+    int32 _colourHeight;
+    int32 _colourWidth;
+    int32 _depthHeight;
+    int32 _depthWidth;
+    TArray<float> _projectedMaxV;
+    TArray<float> _projectedMinV;
+    TArray<float> _projectedU;
+    TArray<float> _projectedV;
+    TArray<float> _projectedZ;
+    TArray<float> _raysX;
+    TArray<float> _raysY;
+    float _transform[12];
+};
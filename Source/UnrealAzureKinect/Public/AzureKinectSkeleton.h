@@ -28,6 +28,11 @@
 
 #include "CoreMinimal.h"
 
+#include <type_traits>
+
+#include "AzureKinectEnum.h"
+#include "AzureKinectFrameInfo.h"
+
 #include "AzureKinectSkeleton.generated.h"
 
 
@@ -38,9 +43,189 @@ USTRUCT(BlueprintType)
 struct FAzureKinectSkeleton {
     GENERATED_BODY()
 
+    /// <summary>
+    /// The confidence of each joint in <see cref="Joints" />. Joints that
+    /// are out of range or have been skipped are <c>NONE</c>.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite)
+    TArray<EKinectJointConfidence> Confidences;
+
+    /// <summary>
+    /// The frame of the device the skeleton has been tracked in.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite)
+    FAzureKinectFrameInfo FrameInfo;
+
     UPROPERTY(BlueprintReadWrite)
     int32 ID;
 
     UPROPERTY(BlueprintReadWrite)
     TArray<FTransform> Joints;
 };
+
+
+/// <summary>
+/// Represents a tracked skeleton with inline storage for all of its joints.
+/// </summary>
+/// <remarks>
+/// <para>This is the representation the device tracks skeletons in. Unlike
+/// <see cref="FAzureKinectSkeleton" />, it does not allocate, so whole sets
+/// of skeletons can be copied with a single <c>memcpy</c>. The positions and
+/// the rotations are stored in separate blocks, which are in the coordinate
+/// system of Unreal, i.e. in centimetres.</para>
+/// <para>Use <see cref="ToSkeleton" /> for obtaining the Blueprint
+/// representation.</para>
+/// </remarks>
+struct FAzureKinectSkeletonData {
+
+    /// <summary>
+    /// The number of joints of a skeleton, which is
+    /// <c>K4ABT_JOINT_COUNT</c>.
+    /// </summary>
+    static constexpr int32 JointCount = 32;
+
+    /// <summary>
+    /// The confidence of each joint.
+    /// </summary>
+    EKinectJointConfidence Confidences[JointCount];
+
+    /// <summary>
+    /// The ID of the body, which remains the same while it is being tracked.
+    /// </summary>
+    int32 ID;
+
+    /// <summary>
+    /// The positions of the joints.
+    /// </summary>
+    FVector3f Positions[JointCount];
+
+    /// <summary>
+    /// The orientations of the joints.
+    /// </summary>
+    FQuat4f Rotations[JointCount];
+
+    /// <summary>
+    /// Answer the parent of the given joint in the hierarchy of the body
+    /// tracker, or -1 for the pelvis, which is the root.
+    /// </summary>
+    /// <remarks>
+    /// Parents always precede their children, so a skeleton can be traversed
+    /// from the root by iterating over the joints in order.
+    /// </remarks>
+    static inline int32 GetParent(const int32 joint) {
+        static constexpr int32 Parents[JointCount] = {
+            -1, 0, 1, 2,                    // Pelvis to neck
+            2, 4, 5, 6, 7, 8, 7,            // Left arm
+            2, 11, 12, 13, 14, 15, 14,      // Right arm
+            0, 18, 19, 20,                  // Left leg
+            0, 22, 23, 24,                  // Right leg
+            3, 26, 26, 26, 26, 26           // Head
+        };
+        check((joint >= 0) && (joint < JointCount));
+        return Parents[joint];
+    }
+
+    /// <summary>
+    /// Answer the transform of the given joint.
+    /// </summary>
+    inline FTransform GetTransform(const int32 joint) const {
+        check((joint >= 0) && (joint < JointCount));
+        return FTransform(FQuat(this->Rotations[joint]),
+            FVector(this->Positions[joint]));
+    }
+
+    /// <summary>
+    /// Moves the joints along the motion from <paramref name="previous" /> to
+    /// the current state, which interpolates for <paramref name="alpha" />
+    /// between zero and one and extrapolates beyond one.
+    /// </summary>
+    /// <remarks>
+    /// The positions are interpolated linearly, which amounts to constant
+    /// velocity, and the rotations are slerped. Joints that are not tracked
+    /// in either of the states remain unchanged.
+    /// </remarks>
+    /// <param name="previous">The preceding state of the same body.</param>
+    /// <param name="alpha">The position between <paramref name="previous" />
+    /// at zero and the current state at one.</param>
+    inline void InterpolateFrom(const FAzureKinectSkeletonData& previous,
+            const float alpha) {
+        for (int32 j = 0; j < JointCount; ++j) {
+            if ((this->Confidences[j] == EKinectJointConfidence::NONE)
+                    || (previous.Confidences[j]
+                        == EKinectJointConfidence::NONE)) {
+                continue;
+            }
+
+            this->Positions[j] = FMath::Lerp(previous.Positions[j],
+                this->Positions[j],
+                alpha);
+            this->Rotations[j] = FQuat4f::Slerp(previous.Rotations[j],
+                this->Rotations[j],
+                alpha);
+        }
+    }
+
+    /// <summary>
+    /// Converts the skeleton into its Blueprint representation.
+    /// </summary>
+    /// <remarks>
+    /// The joints of <paramref name="dst" /> are resized rather than reset,
+    /// so they do not allocate if the skeleton is reused.
+    /// </remarks>
+    /// <param name="dst">Receives the skeleton.</param>
+    inline void ToSkeleton(FAzureKinectSkeleton& dst) const {
+        dst.Confidences.SetNumUninitialized(JointCount);
+        FMemory::Memcpy(dst.Confidences.GetData(), this->Confidences,
+            sizeof(this->Confidences));
+        dst.ID = this->ID;
+        dst.Joints.SetNumUninitialized(JointCount);
+        for (int32 j = 0; j < JointCount; ++j) {
+            dst.Joints[j] = this->GetTransform(j);
+        }
+    }
+};
+
+// The NaN diagnostics add copy constructors to the vector types, which
+// makes them non-trivial, but still safe to copy with memcpy.
+#if !ENABLE_NAN_DIAGNOSTIC
+static_assert(std::is_trivially_copyable<FAzureKinectSkeletonData>::value,
+    "Sets of skeletons must be copyable with memcpy.");
+#endif /* !ENABLE_NAN_DIAGNOSTIC */
+
+
+/// <summary>
+/// An immutable set of skeletons that were tracked in the same frame.
+/// </summary>
+struct FAzureKinectSkeletonSnapshot {
+
+    /// <summary>
+    /// The frame of the device the skeletons have been tracked in.
+    /// </summary>
+    FAzureKinectFrameInfo FrameInfo;
+
+    /// <summary>
+    /// The frame of the device <see cref="PreviousSkeletons" /> have been
+    /// tracked in.
+    /// </summary>
+    FAzureKinectFrameInfo PreviousFrameInfo;
+
+    /// <summary>
+    /// The skeletons of the snapshot published before this one, which allow
+    /// for evaluating the skeletons between and after the two frames.
+    /// </summary>
+    TArray<FAzureKinectSkeletonData> PreviousSkeletons;
+
+    /// <summary>
+    /// A number that increases with every snapshot published by the device.
+    /// </summary>
+    /// <remarks>
+    /// Unlike the sequence number of <see cref="FrameInfo" />, this one does
+    /// not account for frames that have not been tracked.
+    /// </remarks>
+    uint64 Sequence = 0;
+
+    /// <summary>
+    /// The skeletons that have been tracked.
+    /// </summary>
+    TArray<FAzureKinectSkeletonData> Skeletons;
+};
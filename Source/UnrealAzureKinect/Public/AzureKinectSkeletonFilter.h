@@ -0,0 +1,201 @@
+﻿// <copyright file="AzureKinectSkeletonFilter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AzureKinectEnum.h"
+#include "AzureKinectSkeleton.h"
+
+#include "AzureKinectSkeletonFilter.generated.h"
+
+
+/// <summary>
+/// The parameters of the skeleton filter for a group of joints.
+/// </summary>
+/// <remarks>
+/// Only the parameters of the selected filter are used.
+/// </remarks>
+USTRUCT(BlueprintType)
+struct FAzureKinectJointFilterSettings {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The increase of the cutoff frequency of the One Euro filter per
+    /// centimetre per second of speed, which reduces the lag of fast
+    /// movements.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "One Euro",
+        meta = (ClampMin = 0))
+    float Beta = 0.02f;
+
+    /// <summary>
+    /// The cutoff frequency in Hertz the speed of a joint is smoothed with
+    /// by the One Euro filter.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "One Euro",
+        meta = (ClampMin = 0.01))
+    float DerivativeCutoff = 1.0f;
+
+    /// <summary>
+    /// The standard deviation of the tracked positions in centimetres
+    /// assumed by the Kalman filter.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Kalman",
+        meta = (ClampMin = 0.01))
+    float MeasurementNoise = 1.0f;
+
+    /// <summary>
+    /// The cutoff frequency in Hertz of the One Euro filter for joints at
+    /// rest. Lower values remove more jitter.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "One Euro",
+        meta = (ClampMin = 0.01))
+    float MinCutoff = 1.0f;
+
+    /// <summary>
+    /// The standard deviation of the acceleration of a joint in centimetres
+    /// per square second assumed by the Kalman filter. Higher values follow
+    /// fast movements more closely.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Kalman",
+        meta = (ClampMin = 0.01))
+    float ProcessNoise = 500.0f;
+};
+
+
+/// <summary>
+/// Configures the smoothing of the skeletons before they are published.
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAzureKinectSkeletonFilterSettings {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The parameters for shoulders, elbows and wrists.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeleton filter")
+    FAzureKinectJointFilterSettings Arms;
+
+    /// <summary>
+    /// The filter to be applied.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeleton filter")
+    EKinectSkeletonFilter Filter = EKinectSkeletonFilter::NONE;
+
+    /// <summary>
+    /// The parameters for ankles and feet.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeleton filter")
+    FAzureKinectJointFilterSettings Feet;
+
+    /// <summary>
+    /// The parameters for hands, hand tips and thumbs.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeleton filter")
+    FAzureKinectJointFilterSettings Hands;
+
+    /// <summary>
+    /// The parameters for the head and the face.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeleton filter")
+    FAzureKinectJointFilterSettings Head;
+
+    /// <summary>
+    /// The parameters for hips and knees.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeleton filter")
+    FAzureKinectJointFilterSettings Legs;
+
+    /// <summary>
+    /// The parameters for the pelvis, the spine, the neck and the clavicles.
+    /// </summary>
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Skeleton filter")
+    FAzureKinectJointFilterSettings Torso;
+};
+
+
+/// <summary>
+/// Smoothes the joints of tracked skeletons over time.
+/// </summary>
+/// <remarks>
+/// <para>The state of the filter is kept per body ID in a flat array of
+/// joints, which is updated in a single pass over all joints of all bodies.
+/// Bodies that are no longer tracked are forgotten, and new bodies start
+/// from their first observation.</para>
+/// <para>Positions are filtered per axis. Rotations are interpolated towards
+/// the tracked ones by the same share the position of the joint moved by,
+/// so they follow the adaptation of the filter. Joints that are out of range
+/// are not filtered and do not change the state.</para>
+/// <para>The instance must not be used concurrently.</para>
+/// </remarks>
+class FAzureKinectSkeletonFilter final {
+
+public:
+
+    /// <summary>
+    /// Initialises a new instance.
+    /// </summary>
+    FAzureKinectSkeletonFilter(void);
+
+    FAzureKinectSkeletonFilter(const FAzureKinectSkeletonFilter&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~FAzureKinectSkeletonFilter(void) = default;
+
+    /// <summary>
+    /// Filters the given skeletons in place.
+    /// </summary>
+    /// <param name="skeletons">The skeletons tracked in the same
+    /// frame.</param>
+    /// <param name="cnt">The number of skeletons.</param>
+    /// <param name="time">The time the skeletons were tracked at in
+    /// seconds, which must increase from call to call. A time that does not
+    /// restarts the filter.</param>
+    /// <param name="settings">The configuration of the filter. If the filter
+    /// is <c>NONE</c>, the state is discarded.</param>
+    void Apply(FAzureKinectSkeletonData *skeletons,
+        const int32 cnt,
+        const double time,
+        const FAzureKinectSkeletonFilterSettings& settings);
+
+    /// <summary>
+    /// Discards the state of all bodies.
+    /// </summary>
+    void Reset(void);
+
+    FAzureKinectSkeletonFilter& operator =(
+        const FAzureKinectSkeletonFilter&) = delete;
+
+private:
+
+    /// <summary>
+    /// The state of a single joint, which is shared by both filters.
+    /// </summary>
+    /// <remarks>
+    /// The One Euro filter stores its smoothed speed in
+    /// <see cref="Velocity" />, the Kalman filter its velocity estimate and
+    /// the covariance of position and velocity, which is the same for all
+    /// axes.
+    /// </remarks>
+    struct FJoint {
+        float Covariance[3];
+        FVector3f Position;
+        FQuat4f Rotation;
+        bool Valid;
+        FVector3f Velocity;
+    };
+
+    EKinectSkeletonFilter _filter;
+    TArray<int32> _ids;
+    TArray<FJoint> _joints;
+    TArray<FJoint> _previous;
+    TArray<int32> _previousIDs;
+    double _time;
+};
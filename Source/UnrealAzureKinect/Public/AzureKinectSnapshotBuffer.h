@@ -0,0 +1,144 @@
+﻿// <copyright file="AzureKinectSnapshotBuffer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+#include "CoreMinimal.h"
+
+#include "Templates/SharedPointer.h"
+
+
+/// <summary>
+/// A triple buffer that allows a single writer to publish immutable
+/// snapshots to any number of readers without locking.
+/// </summary>
+/// <remarks>
+/// <para>Readers obtain a reference-counted pointer to the most recently
+/// published snapshot. They only pin the slot holding the snapshot for as
+/// long as it takes to copy the pointer, and they never block.</para>
+/// <para>The writer fills a slot that is neither the current one nor pinned
+/// by a reader. If no reader holds on to the snapshot in this slot anymore,
+/// the object is reused in place such that its containers keep their memory;
+/// otherwise, a fresh object is allocated and the old one lives on until the
+/// last reader has released it. The writer therefore never waits for
+/// readers.</para>
+/// </remarks>
+/// <typeparam name="TSnapshot">The type of the published data.</typeparam>
+template<class TSnapshot> class TAzureKinectSnapshotBuffer final {
+
+public:
+
+    /// <summary>
+    /// The type of a snapshot handed out to readers.
+    /// </summary>
+    typedef TSharedPtr<const TSnapshot, ESPMode::ThreadSafe> SnapshotType;
+
+    /// <summary>
+    /// Initialises a new instance without any snapshot.
+    /// </summary>
+    TAzureKinectSnapshotBuffer(void) : _current(0), _writing(INDEX_NONE) {
+        for (auto& s : this->_slots) {
+            s.Pins.store(0);
+        }
+    }
+
+    TAzureKinectSnapshotBuffer(const TAzureKinectSnapshotBuffer&) = delete;
+
+    /// <summary>
+    /// Gets the most recently published snapshot.
+    /// </summary>
+    /// <remarks>
+    /// This method is lock-free and can be called from any thread.
+    /// </remarks>
+    /// <returns>The current snapshot, which might be <see langword="nullptr"/>
+    /// if nothing has been published yet.</returns>
+    SnapshotType Acquire(void) const {
+        while (true) {
+            const auto i = this->_current.load();
+            auto& slot = this->_slots[i];
+            ++slot.Pins;
+
+            // If the writer has not moved on since we read the index, it
+            // cannot touch the slot anymore until we remove our pin. Otherwise,
+            // we retry with the new index.
+            if (this->_current.load() == i) {
+                SnapshotType retval = slot.Value;
+                --slot.Pins;
+                return retval;
+            }
+
+            --slot.Pins;
+        }
+    }
+
+    /// <summary>
+    /// Starts publishing a new snapshot by obtaining a writable object.
+    /// </summary>
+    /// <remarks>
+    /// The object returned might contain the data of an old snapshot, which
+    /// the caller must overwrite. This method must only be called from the
+    /// writer thread.
+    /// </remarks>
+    /// <returns>The object to be filled, or <see langword="nullptr"/> if all
+    /// slots are pinned by readers at the moment, in which case the caller
+    /// should skip the update rather than waiting.</returns>
+    TSnapshot *BeginPublish(void) {
+        assert(this->_writing == INDEX_NONE);
+        const auto current = this->_current.load();
+
+        for (int32 i = 1; i < Slots; ++i) {
+            const auto s = (current + i) % Slots;
+            auto& slot = this->_slots[s];
+
+            if (slot.Pins.load() == 0) {
+                if (!slot.Value.IsValid() || !slot.Value.IsUnique()) {
+                    slot.Value = MakeShared<TSnapshot, ESPMode::ThreadSafe>();
+                }
+
+                this->_writing = s;
+                return slot.Value.Get();
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// <summary>
+    /// Makes the object obtained from <see cref="BeginPublish" /> the current
+    /// snapshot.
+    /// </summary>
+    void EndPublish(void) {
+        assert(this->_writing != INDEX_NONE);
+        this->_current.store(this->_writing);
+        this->_writing = INDEX_NONE;
+    }
+
+    TAzureKinectSnapshotBuffer& operator =(
+        const TAzureKinectSnapshotBuffer&) = delete;
+
+private:
+
+    /// <summary>
+    /// A slot that can hold a snapshot.
+    /// </summary>
+    struct FSlot {
+        mutable std::atomic<int32> Pins;
+        TSharedPtr<TSnapshot, ESPMode::ThreadSafe> Value;
+    };
+
+    /// <summary>
+    /// The number of slots, which is one for the current snapshot, one being
+    /// written and one in case a reader still pins the previous one.
+    /// </summary>
+    static constexpr int32 Slots = 3;
+
+    std::atomic<int32> _current;
+    FSlot _slots[Slots];
+    int32 _writing;
+};
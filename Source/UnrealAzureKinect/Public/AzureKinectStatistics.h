@@ -0,0 +1,156 @@
+﻿// <copyright file="AzureKinectStatistics.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AzureKinectStatistics.generated.h"
+
+
+/// <summary>
+/// Counters of a pool of upload buffers.
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAzureKinectBufferPoolStatistics {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The number of buffers that are currently waiting for reuse.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int32 Available = 0;
+
+    /// <summary>
+    /// The size of the pooled buffers in bytes.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int32 BufferSize = 0;
+
+    /// <summary>
+    /// The number of requests that were served from the pool.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int64 Hits = 0;
+
+    /// <summary>
+    /// The number of requests that required a new allocation.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int64 Misses = 0;
+};
+
+
+/// <summary>
+/// Describes the cost of generating a single point cloud.
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAzureKinectPointCloudStatistics {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The time spent on decimating the point cloud in milliseconds.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Point cloud")
+    float DecimationTime = 0.0f;
+
+    /// <summary>
+    /// The time spent on unprojecting and colouring the depth image in
+    /// milliseconds.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Point cloud")
+    float GenerationTime = 0.0f;
+
+    /// <summary>
+    /// The number of points retained after decimation.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Point cloud")
+    int32 Points = 0;
+
+    /// <summary>
+    /// The number of pixels with a valid depth, i.e. the number of points
+    /// before decimation.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Point cloud")
+    int32 ValidPoints = 0;
+
+    /// <summary>
+    /// The edge length of the voxels in centimetres, which is zero if the
+    /// point cloud has not been decimated.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Point cloud")
+    float VoxelSize = 0.0f;
+};
+
+
+/// <summary>
+/// Counters of a single stage of the capture pipeline.
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAzureKinectStageStatistics {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The maximum number of items that can be queued for the stage.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int32 Capacity = 0;
+
+    /// <summary>
+    /// The number of items that were discarded by the stage or by its input
+    /// queue.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int64 Dropped = 0;
+
+    /// <summary>
+    /// The number of items currently waiting in the input queue of the stage.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int32 Pending = 0;
+
+    /// <summary>
+    /// The number of items the stage has completed.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    int64 Processed = 0;
+};
+
+
+/// <summary>
+/// Counters of all stages of the capture pipeline.
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAzureKinectPipelineStatistics {
+    GENERATED_BODY()
+
+    /// <summary>
+    /// The stage retrieving captures from the device. Captures that could not
+    /// be obtained in time are counted as dropped.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    FAzureKinectStageStatistics Capture;
+
+    /// <summary>
+    /// The stage converting the colour, depth and infrared images into
+    /// textures.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    FAzureKinectStageStatistics Conversion;
+
+    /// <summary>
+    /// The threads decoding MJPG colour images. Images that were superseded
+    /// by a newer one before they could be uploaded are counted as dropped.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    FAzureKinectStageStatistics Decoding;
+
+    /// <summary>
+    /// The stage running the body tracker.
+    /// </summary>
+    UPROPERTY(BlueprintReadOnly, Category = "Pipeline")
+    FAzureKinectStageStatistics Tracking;
+};
@@ -0,0 +1,221 @@
+﻿// <copyright file="AzureKinectTextureUpload.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Engine/TextureRenderTarget2D.h"
+#include "Templates/SharedPointer.h"
+
+#include "k4a/k4a.hpp"
+
+#include "AzureKinectEnum.h"
+#include "AzureKinectFrameInfo.h"
+#include "AzureKinectStatistics.h"
+
+
+class FRHICommandListImmediate;
+
+
+/// <summary>
+/// Describes the update of a render target from the buffer of an image.
+/// </summary>
+struct FAzureKinectTextureUpload {
+
+    /// <summary>
+    /// Initialises a new instance.
+    /// </summary>
+    FAzureKinectTextureUpload(const EKinectStream stream,
+            UTextureRenderTarget2D *target,
+            k4a::image&& image,
+            const int32 width,
+            const int32 height,
+            const int32 pitch)
+        : FrameInfo(),
+        Height(height),
+        Image(MoveTemp(image)),
+        Pitch(pitch),
+        Stream(stream),
+        Target(target),
+        Width(width) { }
+
+    /// <summary>
+    /// The frame of the device the image has been derived from.
+    /// </summary>
+    FAzureKinectFrameInfo FrameInfo;
+
+    /// <summary>
+    /// The height of the region to be updated in pixels.
+    /// </summary>
+    int32 Height;
+
+    /// <summary>
+    /// The image holding the data, which keeps the buffer alive until the
+    /// upload is complete.
+    /// </summary>
+    k4a::image Image;
+
+    /// <summary>
+    /// The size of a row of <see cref="Image" /> in bytes.
+    /// </summary>
+    int32 Pitch;
+
+    /// <summary>
+    /// The stream the image belongs to.
+    /// </summary>
+    EKinectStream Stream;
+
+    /// <summary>
+    /// The render target to be updated.
+    /// </summary>
+    UTextureRenderTarget2D *Target;
+
+    /// <summary>
+    /// The width of the region to be updated in pixels.
+    /// </summary>
+    int32 Width;
+};
+
+
+/// <summary>
+/// All texture updates derived from a single capture, which are submitted to
+/// the render thread together.
+/// </summary>
+typedef TArray<FAzureKinectTextureUpload, TInlineAllocator<4>>
+    FAzureKinectTextureUploads;
+
+
+/// <summary>
+/// Submits texture uploads to the render thread and limits the number of
+/// uploads that can be in flight for each stream.
+/// </summary>
+/// <remarks>
+/// <para>Each upload owns a full-frame buffer until the render thread has
+/// processed it. If the render thread stalls, batches of uploads exceeding
+/// the limit of any of their streams are not enqueued, but kept in a mailbox.
+/// A batch in the mailbox is replaced as a whole by any newer batch sharing a
+/// stream with it. The render thread uploads the content of the mailbox once
+/// it has caught up, so the memory held by pending uploads is bounded.</para>
+/// <para>The uploads of a batch are always admitted, deferred or dropped
+/// together, so the textures updated by a batch never mix captures.</para>
+/// <para>The render commands keep the instance alive, so it must always be
+/// allocated as a shared object.</para>
+/// </remarks>
+class FAzureKinectTextureUploader final
+        : public TSharedFromThis<FAzureKinectTextureUploader,
+            ESPMode::ThreadSafe> {
+
+public:
+
+    /// <summary>
+    /// Initialises a new instance.
+    /// </summary>
+    FAzureKinectTextureUploader(void);
+
+    FAzureKinectTextureUploader(const FAzureKinectTextureUploader&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~FAzureKinectTextureUploader(void) = default;
+
+    /// <summary>
+    /// Retrieves the frame of the device the texture of the given stream has
+    /// most recently been updated from.
+    /// </summary>
+    /// <remarks>
+    /// The frame is recorded on the render thread once the upload has been
+    /// enqueued to the RHI, so it does not include uploads that are still
+    /// pending.
+    /// </remarks>
+    /// <param name="stream">The stream to retrieve the frame for.</param>
+    /// <param name="frameInfo">Receives the frame.</param>
+    void GetFrameInfo(const EKinectStream stream,
+        FAzureKinectFrameInfo& frameInfo) const;
+
+    /// <summary>
+    /// Retrieves the counters of the uploads for the given stream.
+    /// </summary>
+    /// <remarks>
+    /// The capacity is the maximum number of uploads in flight and the
+    /// pending uploads include the ones in the mailbox.
+    /// </remarks>
+    /// <param name="stream">The stream to retrieve the counters for.</param>
+    /// <param name="statistics">Receives the counters.</param>
+    void GetStatistics(const EKinectStream stream,
+        FAzureKinectStageStatistics& statistics) const;
+
+    /// <summary>
+    /// Discards all uploads waiting in the mailboxes, resets the counters and
+    /// sets the maximum number of uploads in flight per stream.
+    /// </summary>
+    /// <param name="maxInFlight">The maximum number of render commands that
+    /// may hold an upload of a single stream.</param>
+    void Reset(const int32 maxInFlight);
+
+    /// <summary>
+    /// Submits the given <paramref name="uploads" /> in a single render
+    /// command or, if the limit of any of their streams has been reached,
+    /// moves them to the mailbox as a whole.
+    /// </summary>
+    /// <param name="uploads">The uploads derived from a single capture, which
+    /// must not contain more than one upload per stream.</param>
+    void Submit(FAzureKinectTextureUploads&& uploads);
+
+    FAzureKinectTextureUploader& operator =(
+        const FAzureKinectTextureUploader&) = delete;
+
+private:
+
+    /// <summary>
+    /// A batch of uploads waiting in the mailbox.
+    /// </summary>
+    struct FPending {
+        uint32 Streams;
+        FAzureKinectTextureUploads Uploads;
+    };
+
+    /// <summary>
+    /// The state of the uploads of a single stream.
+    /// </summary>
+    struct FStream {
+        int64 Dropped = 0;
+        FAzureKinectFrameInfo FrameInfo;
+        int32 InFlight = 0;
+        int64 Uploaded = 0;
+    };
+
+    /// <summary>
+    /// The number of values in <see cref="EKinectStream" />.
+    /// </summary>
+    static constexpr int32 StreamCount
+        = static_cast<int32>(EKinectStream::SENSOR) + 1;
+
+    /// <summary>
+    /// Answer the bit mask of the streams <paramref name="uploads" /> update.
+    /// </summary>
+    static uint32 GetStreams(const FAzureKinectTextureUploads& uploads);
+
+    static void Write(FRHICommandListImmediate& cmdList,
+        const FAzureKinectTextureUpload& upload);
+
+    /// <summary>
+    /// Takes a slot for each of the given <paramref name="streams" /> if all
+    /// of them are below the limit. The caller must hold the lock.
+    /// </summary>
+    /// <returns><see langword="true" /> if the slots have been taken,
+    /// <see langword="false" /> if nothing has been changed.</returns>
+    bool TryAdmit(const uint32 streams);
+
+    void Upload(FRHICommandListImmediate& cmdList,
+        FAzureKinectTextureUploads&& uploads);
+
+    mutable FCriticalSection _lock;
+    int32 _maxInFlight;
+    TArray<FPending, TInlineAllocator<2>> _pending;
+    FStream _streams[StreamCount];
+};
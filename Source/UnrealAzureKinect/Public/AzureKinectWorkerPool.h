@@ -0,0 +1,135 @@
+﻿// <copyright file="AzureKinectWorkerPool.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+#include "HAL/Event.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Templates/Function.h"
+#include "Templates/SharedPointer.h"
+
+
+/// <summary>
+/// A pool of dedicated threads that process the work of a capture in
+/// parallel.
+/// </summary>
+/// <remarks>
+/// <para>The thread calling <see cref="ParallelFor" /> participates in the
+/// work and the most recently submitted job is processed first, so calls can
+/// be nested without the risk of a deadlock.</para>
+/// <para>If the pool has not been started with any threads, the work is
+/// distributed via the task graph of the engine.</para>
+/// </remarks>
+class FAzureKinectWorkerPool final : public FRunnable {
+
+public:
+
+    /// <summary>
+    /// The type of the function processing a single item of a job.
+    /// </summary>
+    typedef TFunctionRef<void (const int32)> BodyType;
+
+    /// <summary>
+    /// The type of the function processing the range [begin, end[ of a
+    /// tiled job.
+    /// </summary>
+    typedef TFunctionRef<void (const int32, const int32)> TileBodyType;
+
+    /// <summary>
+    /// Initialises a new instance without any threads.
+    /// </summary>
+    FAzureKinectWorkerPool(void);
+
+    FAzureKinectWorkerPool(const FAzureKinectWorkerPool&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    virtual ~FAzureKinectWorkerPool(void);
+
+    /// <summary>
+    /// Answer the number of dedicated threads in the pool.
+    /// </summary>
+    inline int32 GetThreadCount(void) const noexcept {
+        return this->_threads.Num();
+    }
+
+    /// <summary>
+    /// Calls <paramref name="body" /> for all indices in [0,
+    /// <paramref name="cnt" />[ and blocks the caller until all of them have
+    /// been processed.
+    /// </summary>
+    /// <param name="cnt">The number of items to process.</param>
+    /// <param name="body">The function processing an item.</param>
+    void ParallelFor(const int32 cnt, BodyType body);
+
+    /// <summary>
+    /// Splits the range [0, <paramref name="cnt" />[ into tiles of
+    /// <paramref name="grain" /> items and processes the tiles in parallel.
+    /// </summary>
+    /// <param name="cnt">The number of items to process, e.g. the rows of
+    /// an image.</param>
+    /// <param name="grain">The number of items per tile. If not positive,
+    /// the whole range is processed as a single tile.</param>
+    /// <param name="body">The function processing a tile.</param>
+    void ParallelForTiles(const int32 cnt,
+        const int32 grain,
+        TileBodyType body);
+
+    virtual uint32 Run(void) override;
+
+    /// <summary>
+    /// Stops and joins all threads of the pool.
+    /// </summary>
+    void Shutdown(void);
+
+    /// <summary>
+    /// (Re-) Starts the pool with the given number of threads.
+    /// </summary>
+    /// <param name="threads">The number of dedicated threads. If zero, the
+    /// task graph is used.</param>
+    /// <param name="affinityMask">The mask of cores the threads may run on.
+    /// If zero, the threads are not restricted.</param>
+    void Start(const int32 threads, const uint64 affinityMask);
+
+    virtual void Stop(void) override;
+
+    FAzureKinectWorkerPool& operator =(const FAzureKinectWorkerPool&) = delete;
+
+private:
+
+    /// <summary>
+    /// The state of a call to <see cref="ParallelFor" />.
+    /// </summary>
+    struct FJob {
+        inline FJob(const int32 cnt, BodyType body)
+            : Body(body), Count(cnt), Done(nullptr), Next(0), Pending(cnt) { }
+
+        BodyType Body;
+        const int32 Count;
+        FEvent *Done;
+        std::atomic<int32> Next;
+        std::atomic<int32> Pending;
+    };
+
+    typedef TSharedPtr<FJob, ESPMode::ThreadSafe> JobType;
+
+    static void Execute(FJob& job);
+
+    void Retire(const JobType& job);
+
+    FEvent *_event;
+    TArray<JobType> _jobs;
+    FCriticalSection _lock;
+    FThreadSafeCounter _stopCounter;
+    TArray<FRunnableThread *> _threads;
+};
@@ -0,0 +1,118 @@
+﻿// <copyright file="NiagaraDataInterfaceAzureKinect.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2025 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "NiagaraDataInterface.h"
+
+#include "AzureKinectDevice.h"
+
+#include "NiagaraDataInterfaceAzureKinect.generated.h"
+
+
+/// <summary>
+/// Provides Niagara systems with the point cloud and the skeletons of an
+/// Azure Kinect device.
+/// </summary>
+/// <remarks>
+/// <para>GPU simulations read the data from the buffers of the device, which
+/// are uploaded at most once per frame and shared by all emitters and systems
+/// using the same device. CPU simulations read the snapshots of the device
+/// directly. Neither involves copying the data for each emitter.</para>
+/// <para>Positions are in centimetres in the coordinate system of the
+/// device, i.e. the one of <see cref="UAzureKinectDevice::GetSkeletons" />.
+/// </para>
+/// </remarks>
+UCLASS(EditInlineNew, Category = "Azure Kinect", CollapseCategories, meta = (DisplayName = "Azure Kinect"))
+class UNREALAZUREKINECT_API UNiagaraDataInterfaceAzureKinect
+        : public UNiagaraDataInterface {
+    GENERATED_UCLASS_BODY()
+
+public:
+
+    /// <summary>
+    /// The device providing the data.
+    /// </summary>
+    UPROPERTY(EditAnywhere, Category = "Azure Kinect")
+    TObjectPtr<UAzureKinectDevice> Device;
+
+    virtual void BuildShaderParameters(
+        FNiagaraShaderParametersBuilder& builder) const override;
+
+    virtual bool CanExecuteOnTarget(
+        ENiagaraSimTarget target) const override;
+
+    virtual void DestroyPerInstanceData(void *data,
+        FNiagaraSystemInstance *instance) override;
+
+    virtual bool Equals(const UNiagaraDataInterface *other) const override;
+
+    virtual void GetVMExternalFunction(
+        const FVMExternalFunctionBindingInfo& bindingInfo,
+        void *data,
+        FVMExternalFunction& outFunc) override;
+
+    virtual bool HasPreSimulateTick(void) const override;
+
+    virtual bool InitPerInstanceData(void *data,
+        FNiagaraSystemInstance *instance) override;
+
+    virtual int32 PerInstanceDataSize(void) const override;
+
+    virtual bool PerInstanceTick(void *data,
+        FNiagaraSystemInstance *instance,
+        float deltaSeconds) override;
+
+    virtual void PostInitProperties(void) override;
+
+    virtual void ProvidePerInstanceDataForRenderThread(void *dataForRenderThread,
+        void *data,
+        const FNiagaraSystemInstanceID& instance) override;
+
+    virtual void SetShaderParameters(
+        const FNiagaraDataInterfaceSetShaderParametersContext& context) const override;
+
+#if WITH_EDITORONLY_DATA
+    virtual bool AppendCompileHash(
+        FNiagaraCompileHashVisitor *visitor) const override;
+
+    virtual bool GetFunctionHLSL(
+        const FNiagaraDataInterfaceGPUParamInfo& paramInfo,
+        const FNiagaraDataInterfaceGeneratedFunction& functionInfo,
+        int functionInstanceIndex,
+        FString& outHlsl) override;
+
+    virtual void GetParameterDefinitionHLSL(
+        const FNiagaraDataInterfaceGPUParamInfo& paramInfo,
+        FString& outHlsl) override;
+#endif /* WITH_EDITORONLY_DATA */
+
+protected:
+
+    virtual bool CopyToInternal(
+        UNiagaraDataInterface *destination) const override;
+
+#if WITH_EDITORONLY_DATA
+    virtual void GetFunctionsInternal(
+        TArray<FNiagaraFunctionSignature>& outFunctions) const override;
+#endif /* WITH_EDITORONLY_DATA */
+
+private:
+
+    void VMGetJoint(FVectorVMExternalFunctionContext& context);
+
+    void VMGetJointCount(FVectorVMExternalFunctionContext& context);
+
+    void VMGetPoint(FVectorVMExternalFunctionContext& context);
+
+    void VMGetPointCount(FVectorVMExternalFunctionContext& context);
+
+    void VMGetSkeletonCount(FVectorVMExternalFunctionContext& context);
+
+    void VMGetSkeletonID(FVectorVMExternalFunctionContext& context);
+};
@@ -107,7 +107,11 @@ public class UnrealAzureKinect : ModuleRules {
             "Engine",
             "RenderCore",
             "RHI",
-            "AnimGraphRuntime"
+            "AnimGraphRuntime",
+            "ImageWrapper",
+            "Niagara",
+            "NiagaraCore",
+            "VectorVM"
         ]);
     }
 }